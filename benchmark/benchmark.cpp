@@ -0,0 +1,422 @@
+/**
+ * \file benchmark.cpp
+ * \author Milos Stojanovic Stojke (milsto)
+ *
+ * End-to-end benchmark of the Differential Evolution optimizer over the test functions.
+ * Runs a grid of functions, dimensions, population sizes and thread counts and writes
+ * the results as JSON.
+ *
+ * Usage: benchmark [--functions rastrigin,vss,cosinemixture] [--dims 2,10,100]
+ *                  [--populations 16,100,1000] [--threads 1,4] [--generations 200]
+ *                  [--max-evaluations 2000000] [--max-seconds 10] [--tolerance 1e-4]
+ *                  [--seed 123] [--check-constraints] [--full] [--output results.json]
+ */
+
+#include "de/DifferentialEvolution.h"
+#include "de/TestFunctions.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace
+{
+    typedef std::chrono::steady_clock Clock;
+
+    /**
+     * Test function known to the benchmark. To benchmark a new test function add it to Registry().
+     */
+    struct TestFunction
+    {
+        std::string name;
+        std::function<de::IOptimizable*(unsigned int)> create;
+        std::function<double(unsigned int)> optimum;
+    };
+
+    std::vector<TestFunction> Registry()
+    {
+        std::vector<TestFunction> functions;
+        functions.push_back({ "rastrigin", [](unsigned int dims) -> de::IOptimizable* { return new de::Rastrigin(dims); },
+                              [](unsigned int) { return 0.0; } });
+        functions.push_back({ "vss", [](unsigned int dims) -> de::IOptimizable* { return new de::VSS(dims); },
+                              [](unsigned int dims) { return 1400.0 - 200.0 * dims; } });
+        functions.push_back({ "cosinemixture", [](unsigned int dims) -> de::IOptimizable* { return new de::CosineMixture(dims); },
+                              [](unsigned int dims) { return -0.1 * dims; } });
+        return functions;
+    }
+
+    /**
+     * Decorator measuring time spent inside the wrapped cost function and number of evaluations.
+     */
+    class TimedCost : public de::IOptimizable
+    {
+    public:
+        explicit TimedCost(const de::IOptimizable& cost) :
+            m_cost(cost),
+            m_nanoseconds(0),
+            m_evaluations(0)
+        {
+
+        }
+
+        double EvaluteCost(std::vector<double> inputs) const override
+        {
+            return EvaluateCost(inputs.data(), inputs.size());
+        }
+
+        double EvaluateCost(const double* inputs, std::size_t size) const override
+        {
+            Clock::time_point start = Clock::now();
+            double cost = m_cost.EvaluateCost(inputs, size);
+            Record(start, 1);
+            return cost;
+        }
+
+        void EvaluateBatch(const double* inputs, std::size_t count, std::size_t stride, double* costs) const override
+        {
+            Clock::time_point start = Clock::now();
+            m_cost.EvaluateBatch(inputs, count, stride, costs);
+            Record(start, count);
+        }
+
+        unsigned int NumberOfParameters() const override
+        {
+            return m_cost.NumberOfParameters();
+        }
+
+        std::vector<Constraints> GetConstraints() const override
+        {
+            return m_cost.GetConstraints();
+        }
+
+        double Seconds() const
+        {
+            return m_nanoseconds.load() * 1e-9;
+        }
+
+        unsigned long long Evaluations() const
+        {
+            return m_evaluations.load();
+        }
+
+    private:
+        void Record(Clock::time_point start, std::size_t count) const
+        {
+            m_nanoseconds += std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+            m_evaluations += count;
+        }
+
+        const de::IOptimizable& m_cost;
+        mutable std::atomic<long long> m_nanoseconds;
+        mutable std::atomic<unsigned long long> m_evaluations;
+    };
+
+    struct Options
+    {
+        std::vector<std::string> functions;
+        std::vector<unsigned int> dims;
+        std::vector<unsigned int> populations;
+        std::vector<unsigned int> threads;
+        int generations;
+        unsigned long long maxEvaluations;
+        double maxSeconds;
+        double tolerance;
+        int seed;
+        bool checkConstraints;
+        std::string output;
+    };
+
+    struct Result
+    {
+        std::string function;
+        unsigned int dims;
+        unsigned int population;
+        unsigned int threads;
+        int generations;
+        unsigned long long evaluations;
+        double wallSeconds;
+        double evaluationSeconds;
+        double bestCost;
+        double target;
+        double timeToTarget;
+        unsigned long long evaluationsToTarget;
+    };
+
+    std::vector<std::string> Split(const std::string& text)
+    {
+        std::vector<std::string> parts;
+        std::stringstream stream(text);
+        std::string part;
+        while (std::getline(stream, part, ','))
+        {
+            if (!part.empty())
+            {
+                parts.push_back(part);
+            }
+        }
+        return parts;
+    }
+
+    std::vector<unsigned int> SplitNumbers(const std::string& text)
+    {
+        std::vector<unsigned int> numbers;
+        for (const auto& part : Split(text))
+        {
+            numbers.push_back(static_cast<unsigned int>(std::strtoul(part.c_str(), nullptr, 10)));
+        }
+        return numbers;
+    }
+
+    Options ParseOptions(int argc, char** argv)
+    {
+        const unsigned int hardwareThreads = std::max(1u, std::thread::hardware_concurrency());
+
+        Options options;
+        options.functions = { "rastrigin", "vss", "cosinemixture" };
+        options.dims = { 2, 10, 100 };
+        options.populations = { 16, 100, 1000 };
+        options.threads = { 1 };
+        if (hardwareThreads > 1)
+        {
+            options.threads.push_back(hardwareThreads);
+        }
+        options.generations = 200;
+        options.maxEvaluations = 2000000;
+        options.maxSeconds = 10.0;
+        options.tolerance = 1e-4;
+        options.seed = 123;
+        options.checkConstraints = false;
+
+        for (int i = 1; i < argc; i++)
+        {
+            std::string argument = argv[i];
+            auto next = [&]() -> std::string
+            {
+                if (i + 1 >= argc)
+                {
+                    std::cerr << "Missing value for " << argument << std::endl;
+                    std::exit(1);
+                }
+                return argv[++i];
+            };
+
+            if (argument == "--functions")
+            {
+                options.functions = Split(next());
+            }
+            else if (argument == "--dims")
+            {
+                options.dims = SplitNumbers(next());
+            }
+            else if (argument == "--populations")
+            {
+                options.populations = SplitNumbers(next());
+            }
+            else if (argument == "--threads")
+            {
+                options.threads = SplitNumbers(next());
+            }
+            else if (argument == "--generations")
+            {
+                options.generations = std::atoi(next().c_str());
+            }
+            else if (argument == "--max-evaluations")
+            {
+                options.maxEvaluations = std::strtoull(next().c_str(), nullptr, 10);
+            }
+            else if (argument == "--max-seconds")
+            {
+                options.maxSeconds = std::atof(next().c_str());
+            }
+            else if (argument == "--tolerance")
+            {
+                options.tolerance = std::atof(next().c_str());
+            }
+            else if (argument == "--seed")
+            {
+                options.seed = std::atoi(next().c_str());
+            }
+            else if (argument == "--check-constraints")
+            {
+                options.checkConstraints = true;
+            }
+            else if (argument == "--full")
+            {
+                options.dims = { 2, 10, 100, 1000 };
+                options.populations = { 16, 100, 1000, 10000, 100000 };
+                options.threads = { 1, 2, 4, 8, 16, 32, 64 };
+            }
+            else if (argument == "--output")
+            {
+                options.output = next();
+            }
+            else
+            {
+                std::cerr << "Unknown argument " << argument << std::endl;
+                std::exit(1);
+            }
+        }
+
+        return options;
+    }
+
+    Result Run(const TestFunction& function, unsigned int dims, unsigned int population, unsigned int threads, const Options& options)
+    {
+        std::unique_ptr<de::IOptimizable> cost(function.create(dims));
+        TimedCost timedCost(*cost);
+
+        Result result;
+        result.function = function.name;
+        result.dims = dims;
+        result.population = population;
+        result.threads = threads;
+        result.generations = 0;
+        result.target = function.optimum(dims) + options.tolerance;
+        result.timeToTarget = -1.0;
+        result.evaluationsToTarget = 0;
+
+        de::DifferentialEvolution optimizer(timedCost, population, options.seed, options.checkConstraints);
+        optimizer.SetNumberOfThreads(threads);
+
+        Clock::time_point start = Clock::now();
+        optimizer.InitPopulation();
+
+        auto elapsed = [&]()
+        {
+            return std::chrono::duration<double>(Clock::now() - start).count();
+        };
+
+        for (int generation = 0; generation < options.generations; generation++)
+        {
+            if (timedCost.Evaluations() + population > options.maxEvaluations || elapsed() > options.maxSeconds)
+            {
+                break;
+            }
+
+            optimizer.SelectionAndCorssing();
+            result.generations++;
+
+            if (result.timeToTarget < 0.0 && optimizer.GetBestCost() <= result.target)
+            {
+                result.timeToTarget = elapsed();
+                result.evaluationsToTarget = timedCost.Evaluations();
+            }
+        }
+
+        result.wallSeconds = elapsed();
+        result.evaluations = timedCost.Evaluations();
+        result.evaluationSeconds = timedCost.Seconds();
+        result.bestCost = optimizer.GetBestCost();
+
+        return result;
+    }
+
+    void WriteJson(std::ostream& out, const std::vector<Result>& results)
+    {
+        out.precision(10);
+        out << "{\n";
+        out << "  \"simd_level\": " << static_cast<int>(de::DetectSimdLevel()) << ",\n";
+        out << "  \"hardware_threads\": " << std::thread::hardware_concurrency() << ",\n";
+        out << "  \"results\": [\n";
+
+        for (std::size_t i = 0; i < results.size(); i++)
+        {
+            const Result& r = results[i];
+
+            // Evaluation time is summed over threads, so it is divided by the thread count
+            // to estimate the wall time spent outside of the cost function.
+            const double agentSteps = static_cast<double>(r.generations) * r.population;
+            const double overheadSeconds = std::max(0.0, r.wallSeconds - r.evaluationSeconds / r.threads);
+
+            out << "    {";
+            out << "\"function\": \"" << r.function << "\", ";
+            out << "\"dims\": " << r.dims << ", ";
+            out << "\"population\": " << r.population << ", ";
+            out << "\"threads\": " << r.threads << ", ";
+            out << "\"generations\": " << r.generations << ", ";
+            out << "\"evaluations\": " << r.evaluations << ", ";
+            out << "\"wall_seconds\": " << r.wallSeconds << ", ";
+            out << "\"evaluation_seconds\": " << r.evaluationSeconds << ", ";
+            out << "\"generations_per_sec\": " << (r.wallSeconds > 0.0 ? r.generations / r.wallSeconds : 0.0) << ", ";
+            out << "\"evaluations_per_sec\": " << (r.wallSeconds > 0.0 ? r.evaluations / r.wallSeconds : 0.0) << ", ";
+            out << "\"overhead_ns_per_agent\": " << (agentSteps > 0.0 ? overheadSeconds * 1e9 / agentSteps : 0.0) << ", ";
+            out << "\"best_cost\": " << r.bestCost << ", ";
+            out << "\"target_cost\": " << r.target << ", ";
+            if (r.timeToTarget >= 0.0)
+            {
+                out << "\"time_to_target_sec\": " << r.timeToTarget << ", ";
+                out << "\"evaluations_to_target\": " << r.evaluationsToTarget;
+            }
+            else
+            {
+                out << "\"time_to_target_sec\": null, \"evaluations_to_target\": null";
+            }
+            out << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+        }
+
+        out << "  ]\n";
+        out << "}\n";
+    }
+}
+
+int main(int argc, char** argv)
+{
+    Options options = ParseOptions(argc, argv);
+    std::vector<TestFunction> registry = Registry();
+
+    std::vector<Result> results;
+    for (const auto& name : options.functions)
+    {
+        const TestFunction* function = nullptr;
+        for (const auto& candidate : registry)
+        {
+            if (candidate.name == name)
+            {
+                function = &candidate;
+            }
+        }
+
+        if (!function)
+        {
+            std::cerr << "Unknown test function " << name << std::endl;
+            return 1;
+        }
+
+        for (unsigned int dims : options.dims)
+        {
+            for (unsigned int population : options.populations)
+            {
+                for (unsigned int threads : options.threads)
+                {
+                    if (population < 4 || dims == 0 || threads == 0)
+                    {
+                        continue;
+                    }
+
+                    std::cerr << function->name << " dims=" << dims << " population=" << population << " threads=" << threads << std::endl;
+                    results.push_back(Run(*function, dims, population, threads, options));
+                }
+            }
+        }
+    }
+
+    if (options.output.empty())
+    {
+        WriteJson(std::cout, results);
+    }
+    else
+    {
+        std::ofstream file(options.output);
+        WriteJson(file, results);
+    }
+
+    return 0;
+}
@@ -0,0 +1,36 @@
+# Produces a profile guided optimized build in a single command:
+#
+#   cmake -P cmake/PGOBuild.cmake
+#
+# Stage 1 builds the instrumented binaries (preset pgo-generate) and runs the benchmark suite as
+# training workload, stage 2 rebuilds everything with the collected profile (preset pgo-use).
+# Both stages share the build/pgo directory so GCC finds the profiles under the same object paths.
+
+get_filename_component(source_dir "${CMAKE_CURRENT_LIST_DIR}/.." ABSOLUTE)
+set(profile_dir "${source_dir}/build/pgo-profile")
+
+function(run)
+    execute_process(COMMAND ${ARGN} WORKING_DIRECTORY ${source_dir} RESULT_VARIABLE result)
+    if(NOT result EQUAL 0)
+        string(REPLACE ";" " " command "${ARGN}")
+        message(FATAL_ERROR "Command failed: ${command}")
+    endif()
+endfunction()
+
+file(REMOVE_RECURSE ${profile_dir})
+
+run(${CMAKE_COMMAND} --preset pgo-generate)
+run(${CMAKE_COMMAND} --build --preset pgo-generate)
+run(${CMAKE_COMMAND} --build --preset pgo-train)
+
+# Clang writes raw profiles which have to be merged, GCC uses the .gcda files directly
+file(GLOB raw_profiles "${profile_dir}/*.profraw")
+if(raw_profiles)
+    find_program(LLVM_PROFDATA NAMES llvm-profdata REQUIRED)
+    run(${LLVM_PROFDATA} merge -output=${profile_dir}/default.profdata ${raw_profiles})
+endif()
+
+run(${CMAKE_COMMAND} --preset pgo-use)
+run(${CMAKE_COMMAND} --build --preset pgo-use)
+
+message(STATUS "PGO optimized build is in ${source_dir}/build/pgo")
@@ -0,0 +1,54 @@
+# Adds the compile and link options selected by DE_NATIVE, DE_LTO and DE_PGO to an interface target.
+
+function(de_apply_performance_flags target)
+    if(CMAKE_CXX_COMPILER_ID MATCHES "GNU|Clang")
+        if(DE_NATIVE)
+            # No FMA contraction so the scalar and SIMD kernels stay bit-identical
+            target_compile_options(${target} INTERFACE -O3 -march=native -ffp-contract=off)
+        endif()
+
+        # LTO flags are carried by the target so they also reach the drivers linking it
+        if(DE_LTO)
+            if(CMAKE_CXX_COMPILER_ID STREQUAL "GNU")
+                target_compile_options(${target} INTERFACE -flto=auto)
+                target_link_options(${target} INTERFACE -flto=auto)
+            else()
+                target_compile_options(${target} INTERFACE -flto=thin)
+                target_link_options(${target} INTERFACE -flto=thin)
+            endif()
+        endif()
+
+        string(TOUPPER "${DE_PGO}" pgo)
+        if(pgo STREQUAL "GENERATE")
+            target_compile_options(${target} INTERFACE -fprofile-generate=${DE_PGO_DIR})
+            target_link_options(${target} INTERFACE -fprofile-generate=${DE_PGO_DIR})
+        elseif(pgo STREQUAL "USE")
+            if(CMAKE_CXX_COMPILER_ID MATCHES "Clang")
+                set(profile ${DE_PGO_DIR}/default.profdata)
+            else()
+                set(profile ${DE_PGO_DIR})
+            endif()
+            if(NOT EXISTS ${profile})
+                message(WARNING "PGO profile ${profile} not found, run the GENERATE stage first")
+            endif()
+            target_compile_options(${target} INTERFACE -fprofile-use=${profile})
+            target_link_options(${target} INTERFACE -fprofile-use=${profile})
+            if(CMAKE_CXX_COMPILER_ID STREQUAL "GNU")
+                target_compile_options(${target} INTERFACE -fprofile-correction -Wno-missing-profile)
+            endif()
+        elseif(NOT pgo STREQUAL "OFF")
+            message(FATAL_ERROR "DE_PGO must be OFF, GENERATE or USE")
+        endif()
+    elseif(MSVC)
+        if(DE_NATIVE)
+            target_compile_options(${target} INTERFACE /O2 /fp:precise)
+        endif()
+        if(DE_LTO)
+            target_compile_options(${target} INTERFACE /GL)
+            target_link_options(${target} INTERFACE /LTCG)
+        endif()
+        if(NOT DE_PGO STREQUAL "OFF")
+            message(WARNING "DE_PGO is supported only with GCC and Clang")
+        endif()
+    endif()
+endfunction()
@@ -0,0 +1,372 @@
+/**
+ * \file ConvergenceLog.h
+ * \author Milos Stojanovic Stojke (milsto)
+ *
+ * Full precision log of the convergence of DifferentialEvolution written by a background thread.
+ */
+
+#pragma once
+
+#include <vector>
+#include <string>
+#include <memory>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <cstdio>
+#include <algorithm>
+
+#include "DifferentialEvolution.h"
+
+namespace de
+{
+    enum class LogFormat
+    {
+        Csv,
+        Binary
+    };
+
+    /**
+     * Header of every record of the binary log. The binary file starts with the 8 byte magic
+     * "DELOG001", followed by the uint32 version and the uint32 number of parameters, and then
+     * the records. Each record is followed by count entries of a cost and the parameters of an
+     * agent, all as doubles in host byte order. Size covers the header and the entries, so readers
+     * can skip records of unknown types.
+     */
+    struct LogRecordHeader
+    {
+        static const std::uint32_t g_best = 1;
+        static const std::uint32_t g_population = 2;
+
+        std::uint32_t size;
+        std::uint32_t type;
+        std::uint64_t generation;
+        std::uint64_t evaluations;
+        std::uint32_t count;
+        std::uint32_t bestAgentIndex;
+    };
+
+    /**
+     * Telemetry sink recording the best cost and agent of every generation and optionally snapshots
+     * of the whole population.
+     *
+     * The optimizer thread only copies records into a ring buffer. A background thread drains it and
+     * writes CSV or the compact binary format, so formatting and file output do not slow down the
+     * optimization. When the ring buffer is full the optimizer waits, no record is lost. The ring
+     * buffer holds snapshots of the maximum population size, construct the log after
+     * SetRestartStrategy when restarts grow the population.
+     *
+     * CSV has the columns record,generation,evaluations,agent,cost,x0,...,xn-1 where record is best
+     * or population. Numbers are written with 17 significant digits, so they read back exactly.
+     */
+    class ConvergenceLog : public ITelemetrySink
+    {
+    public:
+        static const std::uint32_t g_version = 1;
+
+        /**
+         * \param optimizer Optimizer the log is added to with AddTelemetrySink
+         * \param path Output file, replaced if it exists
+         * \param format File format
+         * \param snapshotInterval Number of generations between population snapshots, 0 for none
+         * \param bufferSize Size of the ring buffer in bytes, rounded up to a power of two large
+         * enough for a few population snapshots
+         */
+        ConvergenceLog(const DifferentialEvolution& optimizer, const std::string& path, LogFormat format = LogFormat::Binary,
+                       unsigned int snapshotInterval = 0, std::size_t bufferSize = 1 << 22) :
+            m_optimizer(optimizer),
+            m_format(format),
+            m_snapshotInterval(snapshotInterval),
+            m_numberOfParameters(static_cast<unsigned int>(optimizer.GetPopulation().Columns())),
+            m_file(std::fopen(path.c_str(), "wb")),
+            m_head(0),
+            m_tail(0),
+            m_stalls(0),
+            m_dropped(0),
+            m_failed(m_file == nullptr),
+            m_stop(false)
+        {
+            // Restarts grow the population up to the maximum, so the restart strategy has to be set first
+            const std::size_t largest = RecordSize(optimizer.GetMaxPopulationSize());
+            m_capacity = 1;
+            while (m_capacity < std::max(bufferSize, 4 * largest))
+            {
+                m_capacity *= 2;
+            }
+            m_buffer.reset(new char[m_capacity]);
+            m_record.resize(largest);
+
+            if (m_file)
+            {
+                std::setvbuf(m_file, nullptr, _IOFBF, 1 << 20);
+                WriteFileHeader();
+            }
+
+            m_thread = std::thread(&ConvergenceLog::Run, this);
+        }
+
+        /**
+         * Writes all recorded generations before returning.
+         */
+        ~ConvergenceLog()
+        {
+            m_stop.store(true, std::memory_order_release);
+            m_thread.join();
+            if (m_file)
+            {
+                std::fclose(m_file);
+            }
+        }
+
+        ConvergenceLog(const ConvergenceLog&) = delete;
+        ConvergenceLog& operator=(const ConvergenceLog&) = delete;
+
+        bool IsOpen() const
+        {
+            return m_file != nullptr;
+        }
+
+        void OnGeneration(const GenerationTelemetry& telemetry) override
+        {
+            const bool snapshot = m_snapshotInterval > 0 && telemetry.generation % m_snapshotInterval == 0;
+            const unsigned int bestAgentIndex = m_optimizer.GetBestAgentIndex();
+
+            Append(LogRecordHeader::g_best, telemetry, 1, bestAgentIndex, bestAgentIndex);
+            if (snapshot)
+            {
+                Append(LogRecordHeader::g_population, telemetry, m_optimizer.GetPopulationSize(), 0, bestAgentIndex);
+            }
+        }
+
+        /**
+         * Wait until all recorded generations are written to the file. Returns false if writing failed
+         * or a record was dropped.
+         */
+        bool Flush()
+        {
+            while (m_tail.load(std::memory_order_acquire) != m_head.load(std::memory_order_relaxed))
+            {
+                std::this_thread::sleep_for(std::chrono::microseconds(100));
+            }
+            return m_file && std::fflush(m_file) == 0 && !m_failed.load() && m_dropped == 0;
+        }
+
+        /**
+         * Number of times the optimizer waited for the writer because the ring buffer was full.
+         */
+        unsigned long long GetNumberOfStalls() const
+        {
+            return m_stalls;
+        }
+
+        /**
+         * Number of population snapshots dropped because they did not fit into the ring buffer. This
+         * happens only if the population grew beyond the maximum population size the log was
+         * constructed with.
+         */
+        unsigned long long GetNumberOfDroppedRecords() const
+        {
+            return m_dropped;
+        }
+
+    private:
+        std::size_t RecordSize(unsigned int count) const
+        {
+            return sizeof(LogRecordHeader) + static_cast<std::size_t>(count) * (m_numberOfParameters + 1) * sizeof(double);
+        }
+
+        /**
+         * Copy count agents starting at first into the ring buffer, called on the optimizer thread.
+         */
+        void Append(std::uint32_t type, const GenerationTelemetry& telemetry, unsigned int count, unsigned int first, unsigned int bestAgentIndex)
+        {
+            const std::size_t size = RecordSize(count);
+            if (size > m_capacity)
+            {
+                m_dropped++;
+                return;
+            }
+
+            const std::uint64_t head = m_head.load(std::memory_order_relaxed);
+
+            // Records are never dropped, wait for the writer if it falls behind
+            if (head + size - m_tail.load(std::memory_order_acquire) > m_capacity)
+            {
+                m_stalls++;
+                while (head + size - m_tail.load(std::memory_order_acquire) > m_capacity)
+                {
+                    std::this_thread::yield();
+                }
+            }
+
+            LogRecordHeader header;
+            header.size = static_cast<std::uint32_t>(size);
+            header.type = type;
+            header.generation = telemetry.generation;
+            header.evaluations = telemetry.totalEvaluations;
+            header.count = count;
+            header.bestAgentIndex = bestAgentIndex;
+
+            std::uint64_t position = head;
+            Write(position, &header, sizeof(header));
+            for (unsigned int i = first; i < first + count; i++)
+            {
+                const double cost = m_optimizer.GetAgentCost(i);
+                Write(position, &cost, sizeof(cost));
+                Write(position, m_optimizer.GetAgent(i).data(), m_numberOfParameters * sizeof(double));
+            }
+
+            m_head.store(head + size, std::memory_order_release);
+        }
+
+        void Write(std::uint64_t& position, const void* data, std::size_t size)
+        {
+            const std::size_t offset = static_cast<std::size_t>(position & (m_capacity - 1));
+            const std::size_t first = std::min(size, m_capacity - offset);
+            std::memcpy(m_buffer.get() + offset, data, first);
+            std::memcpy(m_buffer.get(), static_cast<const char*>(data) + first, size - first);
+            position += size;
+        }
+
+        void Read(std::uint64_t position, void* data, std::size_t size) const
+        {
+            const std::size_t offset = static_cast<std::size_t>(position & (m_capacity - 1));
+            const std::size_t first = std::min(size, m_capacity - offset);
+            std::memcpy(data, m_buffer.get() + offset, first);
+            std::memcpy(static_cast<char*>(data) + first, m_buffer.get(), size - first);
+        }
+
+        /**
+         * Writer thread. It polls the ring buffer instead of being notified, so recording a generation
+         * costs no system call.
+         */
+        void Run()
+        {
+            while (true)
+            {
+                const bool stop = m_stop.load(std::memory_order_acquire);
+                const std::uint64_t head = m_head.load(std::memory_order_acquire);
+                std::uint64_t tail = m_tail.load(std::memory_order_relaxed);
+
+                if (tail == head)
+                {
+                    if (stop)
+                    {
+                        return;
+                    }
+                    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                    continue;
+                }
+
+                while (tail != head)
+                {
+                    std::uint32_t size;
+                    Read(tail, &size, sizeof(size));
+                    if (size > m_record.size())
+                    {
+                        m_record.resize(size);
+                    }
+                    Read(tail, m_record.data(), size);
+                    WriteRecord();
+
+                    tail += size;
+                    m_tail.store(tail, std::memory_order_release);
+                }
+            }
+        }
+
+        void WriteFileHeader()
+        {
+            bool written = true;
+            if (m_format == LogFormat::Binary)
+            {
+                const std::uint32_t version = g_version;
+                const std::uint32_t numberOfParameters = m_numberOfParameters;
+                written = std::fwrite("DELOG001", 1, 8, m_file) == 8 &&
+                          std::fwrite(&version, sizeof(version), 1, m_file) == 1 &&
+                          std::fwrite(&numberOfParameters, sizeof(numberOfParameters), 1, m_file) == 1;
+            }
+            else
+            {
+                written = std::fputs("record,generation,evaluations,agent,cost", m_file) >= 0;
+                for (unsigned int i = 0; i < m_numberOfParameters; i++)
+                {
+                    written = written && std::fprintf(m_file, ",x%u", i) > 0;
+                }
+                written = written && std::fputc('\n', m_file) != EOF;
+            }
+            m_failed = m_failed.load() || !written;
+        }
+
+        /**
+         * Write the record in m_record to the file, called on the writer thread. After a failure
+         * records are still consumed so the optimizer never waits forever.
+         */
+        void WriteRecord()
+        {
+            if (m_failed.load(std::memory_order_relaxed))
+            {
+                return;
+            }
+
+            LogRecordHeader header;
+            std::memcpy(&header, m_record.data(), sizeof(header));
+
+            if (m_format == LogFormat::Binary)
+            {
+                if (std::fwrite(m_record.data(), 1, header.size, m_file) != header.size)
+                {
+                    m_failed = true;
+                }
+                return;
+            }
+
+            const char* kind = header.type == LogRecordHeader::g_best ? "best" : "population";
+            const char* entry = m_record.data() + sizeof(header);
+            for (std::uint32_t i = 0; i < header.count; i++)
+            {
+                const unsigned int agent = header.type == LogRecordHeader::g_best ? header.bestAgentIndex : i;
+                int result = std::fprintf(m_file, "%s,%llu,%llu,%u", kind, static_cast<unsigned long long>(header.generation),
+                                          static_cast<unsigned long long>(header.evaluations), agent);
+                for (unsigned int j = 0; j <= m_numberOfParameters && result > 0; j++)
+                {
+                    double value;
+                    std::memcpy(&value, entry + j * sizeof(double), sizeof(value));
+                    result = std::fprintf(m_file, ",%.17g", value);
+                }
+                if (result <= 0 || std::fputc('\n', m_file) == EOF)
+                {
+                    m_failed = true;
+                    return;
+                }
+                entry += (m_numberOfParameters + 1) * sizeof(double);
+            }
+        }
+
+        const DifferentialEvolution& m_optimizer;
+        LogFormat m_format;
+        unsigned int m_snapshotInterval;
+        unsigned int m_numberOfParameters;
+        std::FILE* m_file;
+
+        // Ring buffer positions only grow, the producer owns m_head and the writer thread m_tail
+        std::unique_ptr<char[]> m_buffer;
+        std::size_t m_capacity;
+        std::atomic<std::uint64_t> m_head;
+        char m_headPadding[g_cacheLineSize];
+        std::atomic<std::uint64_t> m_tail;
+        char m_tailPadding[g_cacheLineSize];
+        unsigned long long m_stalls;
+        unsigned long long m_dropped;
+
+        // Record being written, used by the writer thread only
+        std::vector<char> m_record;
+
+        std::atomic<bool> m_failed;
+        std::atomic<bool> m_stop;
+        std::thread m_thread;
+    };
+}
@@ -10,14 +10,246 @@
 #include <iostream>
 #include <vector>
 #include <cassert>
-#include <random>
 #include <iomanip>
 #include <utility>
 #include <memory>
 #include <limits>
+#include <functional>
+#include <algorithm>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <exception>
+#include <new>
+#include <cstdint>
+#include <cstring>
+#include <cstddef>
+#include <cmath>
+#include <cstdio>
+#include <string>
+#include <fstream>
+#include <type_traits>
+#include <chrono>
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#if !defined(DE_DISABLE_SIMD) && (defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86))
+#define DE_SIMD_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+#if defined(DE_SIMD_X86) && (defined(__GNUC__) || defined(__clang__))
+#define DE_TARGET(isa) __attribute__((target(isa)))
+#else
+#define DE_TARGET(isa)
+#endif
 
 namespace de
 {
+    /**
+     * Size of the cache line in bytes. Population storage rows are aligned to it.
+     */
+    static constexpr std::size_t g_cacheLineSize = 64;
+
+    /**
+     * Fixed size array of trivially copyable elements whose storage is aligned to the cache line.
+     */
+    template<typename T>
+    class AlignedBuffer
+    {
+    public:
+        AlignedBuffer() :
+            m_raw(nullptr),
+            m_data(nullptr),
+            m_size(0)
+        {
+
+        }
+
+        explicit AlignedBuffer(std::size_t size) :
+            AlignedBuffer()
+        {
+            Resize(size);
+        }
+
+        AlignedBuffer(AlignedBuffer&& other) :
+            m_raw(other.m_raw),
+            m_data(other.m_data),
+            m_size(other.m_size)
+        {
+            other.m_raw = nullptr;
+            other.m_data = nullptr;
+            other.m_size = 0;
+        }
+
+        AlignedBuffer& operator=(AlignedBuffer&& other)
+        {
+            std::swap(m_raw, other.m_raw);
+            std::swap(m_data, other.m_data);
+            std::swap(m_size, other.m_size);
+            return *this;
+        }
+
+        AlignedBuffer(const AlignedBuffer&) = delete;
+        AlignedBuffer& operator=(const AlignedBuffer&) = delete;
+
+        ~AlignedBuffer()
+        {
+            ::operator delete(m_raw);
+        }
+
+        /**
+         * Reallocate the buffer to hold size zero initialized elements. Previous content is lost.
+         */
+        void Resize(std::size_t size)
+        {
+            ::operator delete(m_raw);
+            m_raw = nullptr;
+            m_data = nullptr;
+            m_size = 0;
+
+            if (size == 0)
+            {
+                return;
+            }
+
+            m_raw = ::operator new(size * sizeof(T) + g_cacheLineSize);
+            std::uintptr_t address = reinterpret_cast<std::uintptr_t>(m_raw);
+            address = (address + g_cacheLineSize - 1) & ~static_cast<std::uintptr_t>(g_cacheLineSize - 1);
+            m_data = reinterpret_cast<T*>(address);
+            m_size = size;
+
+            std::fill(m_data, m_data + m_size, T());
+        }
+
+        T* data() { return m_data; }
+        const T* data() const { return m_data; }
+        std::size_t size() const { return m_size; }
+
+        T& operator[](std::size_t i) { return m_data[i]; }
+        const T& operator[](std::size_t i) const { return m_data[i]; }
+
+        T* begin() { return m_data; }
+        T* end() { return m_data + m_size; }
+        const T* begin() const { return m_data; }
+        const T* end() const { return m_data + m_size; }
+
+    private:
+        void* m_raw;
+        T* m_data;
+        std::size_t m_size;
+    };
+
+    /**
+     * Lightweight non-owning view of a single matrix row (an agent).
+     */
+    template<typename T>
+    class RowView
+    {
+    public:
+        RowView(T* data, std::size_t size) :
+            m_data(data),
+            m_size(size)
+        {
+
+        }
+
+        T* data() const { return m_data; }
+        std::size_t size() const { return m_size; }
+
+        T& operator[](std::size_t i) const { return m_data[i]; }
+
+        T* begin() const { return m_data; }
+        T* end() const { return m_data + m_size; }
+
+        std::vector<double> ToVector() const
+        {
+            return std::vector<double>(m_data, m_data + m_size);
+        }
+
+    private:
+        T* m_data;
+        std::size_t m_size;
+    };
+
+    typedef RowView<double> AgentView;
+    typedef RowView<const double> ConstAgentView;
+
+    /**
+     * Row major matrix of doubles stored in a single cache line aligned block.
+     * Each row holds one agent and rows are Stride() elements apart.
+     */
+    class AlignedMatrix
+    {
+    public:
+        AlignedMatrix() :
+            m_rows(0),
+            m_columns(0),
+            m_stride(0)
+        {
+
+        }
+
+        /**
+         * Reallocate the matrix. Previous content is lost.
+         *
+         * \param stride Distance between rows in elements. Zero selects the number of columns
+         * rounded up to a whole number of cache lines.
+         */
+        void Resize(std::size_t rows, std::size_t columns, std::size_t stride = 0)
+        {
+            if (stride == 0)
+            {
+                stride = DefaultStride(columns);
+            }
+            assert(stride >= columns);
+
+            m_rows = rows;
+            m_columns = columns;
+            m_stride = stride;
+            m_data.Resize(rows * stride);
+        }
+
+        static std::size_t DefaultStride(std::size_t columns)
+        {
+            const std::size_t perLine = g_cacheLineSize / sizeof(double);
+            return (columns + perLine - 1) / perLine * perLine;
+        }
+
+        std::size_t Rows() const { return m_rows; }
+        std::size_t Columns() const { return m_columns; }
+        std::size_t Stride() const { return m_stride; }
+
+        double* Data() { return m_data.data(); }
+        const double* Data() const { return m_data.data(); }
+
+        double* RowData(std::size_t row) { return m_data.data() + row * m_stride; }
+        const double* RowData(std::size_t row) const { return m_data.data() + row * m_stride; }
+
+        AgentView Row(std::size_t row) { return AgentView(RowData(row), m_columns); }
+        ConstAgentView Row(std::size_t row) const { return ConstAgentView(RowData(row), m_columns); }
+
+        void CopyRow(std::size_t row, const double* source)
+        {
+            std::memcpy(RowData(row), source, m_columns * sizeof(double));
+        }
+
+    private:
+        std::size_t m_rows;
+        std::size_t m_columns;
+        std::size_t m_stride;
+        AlignedBuffer<double> m_data;
+    };
+
     class IOptimizable
     {
     public:
@@ -31,7 +263,7 @@ namespace de
 
             }
 
-            bool Check(double candidate)
+            bool Check(double candidate) const
             {
                 if (isConstrained)
                 {
@@ -55,270 +287,4486 @@ namespace de
             bool isConstrained;
         };
 
-        virtual double EvaluteCost(std::vector<double> inputs) const = 0;
-        virtual unsigned int NumberOfParameters() const = 0;
-        virtual std::vector<Constraints> GetConstraints() const = 0;
-        virtual ~IOptimizable() {}
-    };
+        virtual double EvaluteCost(std::vector<double> inputs) const = 0;
+        virtual unsigned int NumberOfParameters() const = 0;
+        virtual std::vector<Constraints> GetConstraints() const = 0;
+
+        /**
+         * Evaluate cost of a single agent without copying it.
+         *
+         * Override it to avoid allocation and copy of the agent on each evaluation.
+         * Default implementation copies the agent into a vector and calls EvaluteCost.
+         *
+         * \param inputs Pointer to NumberOfParameters() values of the agent
+         * \param size Number of values
+         */
+        virtual double EvaluateCost(const double* inputs, std::size_t size) const
+        {
+            return EvaluteCost(std::vector<double>(inputs, inputs + size));
+        }
+
+        double EvaluateCost(ConstAgentView inputs) const
+        {
+            return EvaluateCost(inputs.data(), inputs.size());
+        }
+
+        /**
+         * Evaluate cost of a whole batch of agents with a single call.
+         *
+         * The optimizer builds all trial vectors of a generation first and then calls this method once.
+         * Override it when the cost function can amortize setup or vectorize across agents.
+         * Default implementation falls back to EvaluateCost for each agent.
+         *
+         * \param inputs Row major matrix of agents, each row holds NumberOfParameters() values
+         * \param count Number of agents (rows) in the batch
+         * \param stride Distance in elements between the starts of two consecutive rows
+         * \param costs Output array of count costs
+         */
+        virtual void EvaluateBatch(const double* inputs, std::size_t count, std::size_t stride, double* costs) const
+        {
+            const unsigned int numberOfParameters = NumberOfParameters();
+            for (std::size_t i = 0; i < count; i++)
+            {
+                costs[i] = EvaluateCost(inputs + i * stride, numberOfParameters);
+            }
+        }
+
+        virtual ~IOptimizable() {}
+    };
+
+    /**
+     * Cost function with general constraints in addition to the box constraints of the parameters.
+     *
+     * Constraints are evaluated before the objective. Each constraint reports a non-negative
+     * violation, zero when it is satisfied: max(0, g(x)) for an inequality g(x) <= 0 and
+     * max(0, |h(x)| - tolerance) for an equality h(x) = 0. The optimizer compares agents by the sum of
+     * the violations first, see ConstraintHandling, and does not evaluate the objective of trials which
+     * lose the comparison regardless of their cost.
+     */
+    class IConstrainedOptimizable : public IOptimizable
+    {
+    public:
+        virtual unsigned int NumberOfConstraints() const = 0;
+
+        /**
+         * Evaluate violations of all constraints.
+         *
+         * \param inputs Pointer to NumberOfParameters() values of the agent
+         * \param size Number of values
+         * \param violations Output array of NumberOfConstraints() non-negative violations
+         */
+        virtual void EvaluateConstraints(const double* inputs, std::size_t size, double* violations) const = 0;
+    };
+
+    /**
+     * Deb's feasibility rules: the smaller total violation wins, equal violations are compared by cost.
+     */
+    inline bool IsBetterByFeasibility(double cost, double violation, double otherCost, double otherViolation)
+    {
+        return violation == otherViolation ? cost < otherCost : violation < otherViolation;
+    }
+
+    /**
+     * Model approximating the cost function, used to pre-screen trial vectors before the real
+     * evaluation. See LocalRbfSurrogate in Surrogate.h.
+     *
+     * Add is called from the optimizer thread only, Predict may be called concurrently from
+     * several threads but never concurrently with Add.
+     */
+    class ISurrogate
+    {
+    public:
+        /**
+         * Add an evaluated agent to the model.
+         */
+        virtual void Add(const double* agent, double cost) = 0;
+
+        /**
+         * Predict cost of an agent. Returns false if the model can not predict yet.
+         */
+        virtual bool Predict(const double* agent, double& cost) const = 0;
+
+        virtual ~ISurrogate() {}
+    };
+
+    /**
+     * Selection of the trial vectors evaluated when a surrogate is set.
+     *
+     * PredictedBetter: trials predicted to beat their target agent.
+     * TopK: the k trials with the largest predicted improvement over their target.
+     */
+    enum class SurrogateScreening
+    {
+        PredictedBetter,
+        TopK
+    };
+
+    /**
+     * Instruction set used by the mutation and crossover kernels.
+     */
+    enum class SimdLevel
+    {
+        Scalar = 0,
+        SSE2 = 1,
+        AVX2 = 2,
+        AVX512 = 3
+    };
+
+    /**
+     * Vectorized kernels of the trial vector construction.
+     *
+     * Every instruction set computes the same operations in the same order as the scalar path,
+     * without fused multiply-add, so all of them give identical results. The compiler must not
+     * contract the scalar path either (use -ffp-contract=off with GCC and Clang when targeting
+     * FMA capable hardware). The crossover randoms are read from the trial row which is overwritten.
+     */
+    struct SimdKernels
+    {
+        // z = a + F * (b - c)
+        void (*donor)(double* z, const double* a, const double* b, const double* c, double F, std::size_t n);
+
+        // trial = trial < CR ? donor : x, where trial holds uniform random values on input
+        void (*crossover)(double* trial, const double* donor, const double* x, double CR, std::size_t n);
+
+        // trial = trial < CR ? a + F * (b - c) : x, fused donor and crossover
+        void (*donorCrossover)(double* trial, const double* a, const double* b, const double* c, const double* x, double F, double CR, std::size_t n);
+
+        SimdLevel level;
+    };
+
+    namespace kernels
+    {
+        inline void DonorScalar(double* z, const double* a, const double* b, const double* c, double F, std::size_t n)
+        {
+            for (std::size_t i = 0; i < n; i++)
+            {
+                z[i] = a[i] + F * (b[i] - c[i]);
+            }
+        }
+
+        inline void CrossoverScalar(double* trial, const double* donor, const double* x, double CR, std::size_t n)
+        {
+            for (std::size_t i = 0; i < n; i++)
+            {
+                trial[i] = trial[i] < CR ? donor[i] : x[i];
+            }
+        }
+
+        inline void DonorCrossoverScalar(double* trial, const double* a, const double* b, const double* c, const double* x, double F, double CR, std::size_t n)
+        {
+            for (std::size_t i = 0; i < n; i++)
+            {
+                trial[i] = trial[i] < CR ? a[i] + F * (b[i] - c[i]) : x[i];
+            }
+        }
+
+#if defined(DE_SIMD_X86)
+        DE_TARGET("sse2") inline void DonorSSE2(double* z, const double* a, const double* b, const double* c, double F, std::size_t n)
+        {
+            const __m128d f = _mm_set1_pd(F);
+            std::size_t i = 0;
+            for (; i + 2 <= n; i += 2)
+            {
+                __m128d d = _mm_sub_pd(_mm_loadu_pd(b + i), _mm_loadu_pd(c + i));
+                _mm_storeu_pd(z + i, _mm_add_pd(_mm_loadu_pd(a + i), _mm_mul_pd(f, d)));
+            }
+            DonorScalar(z + i, a + i, b + i, c + i, F, n - i);
+        }
+
+        DE_TARGET("sse2") inline void CrossoverSSE2(double* trial, const double* donor, const double* x, double CR, std::size_t n)
+        {
+            const __m128d cr = _mm_set1_pd(CR);
+            std::size_t i = 0;
+            for (; i + 2 <= n; i += 2)
+            {
+                __m128d mask = _mm_cmplt_pd(_mm_loadu_pd(trial + i), cr);
+                __m128d blend = _mm_or_pd(_mm_and_pd(mask, _mm_loadu_pd(donor + i)), _mm_andnot_pd(mask, _mm_loadu_pd(x + i)));
+                _mm_storeu_pd(trial + i, blend);
+            }
+            CrossoverScalar(trial + i, donor + i, x + i, CR, n - i);
+        }
+
+        DE_TARGET("sse2") inline void DonorCrossoverSSE2(double* trial, const double* a, const double* b, const double* c, const double* x, double F, double CR, std::size_t n)
+        {
+            const __m128d f = _mm_set1_pd(F);
+            const __m128d cr = _mm_set1_pd(CR);
+            std::size_t i = 0;
+            for (; i + 2 <= n; i += 2)
+            {
+                __m128d d = _mm_sub_pd(_mm_loadu_pd(b + i), _mm_loadu_pd(c + i));
+                __m128d z = _mm_add_pd(_mm_loadu_pd(a + i), _mm_mul_pd(f, d));
+                __m128d mask = _mm_cmplt_pd(_mm_loadu_pd(trial + i), cr);
+                __m128d blend = _mm_or_pd(_mm_and_pd(mask, z), _mm_andnot_pd(mask, _mm_loadu_pd(x + i)));
+                _mm_storeu_pd(trial + i, blend);
+            }
+            DonorCrossoverScalar(trial + i, a + i, b + i, c + i, x + i, F, CR, n - i);
+        }
+
+        DE_TARGET("avx2") inline void DonorAVX2(double* z, const double* a, const double* b, const double* c, double F, std::size_t n)
+        {
+            const __m256d f = _mm256_set1_pd(F);
+            std::size_t i = 0;
+            for (; i + 4 <= n; i += 4)
+            {
+                __m256d d = _mm256_sub_pd(_mm256_loadu_pd(b + i), _mm256_loadu_pd(c + i));
+                _mm256_storeu_pd(z + i, _mm256_add_pd(_mm256_loadu_pd(a + i), _mm256_mul_pd(f, d)));
+            }
+            DonorScalar(z + i, a + i, b + i, c + i, F, n - i);
+        }
+
+        DE_TARGET("avx2") inline void CrossoverAVX2(double* trial, const double* donor, const double* x, double CR, std::size_t n)
+        {
+            const __m256d cr = _mm256_set1_pd(CR);
+            std::size_t i = 0;
+            for (; i + 4 <= n; i += 4)
+            {
+                __m256d mask = _mm256_cmp_pd(_mm256_loadu_pd(trial + i), cr, _CMP_LT_OQ);
+                _mm256_storeu_pd(trial + i, _mm256_blendv_pd(_mm256_loadu_pd(x + i), _mm256_loadu_pd(donor + i), mask));
+            }
+            CrossoverScalar(trial + i, donor + i, x + i, CR, n - i);
+        }
+
+        DE_TARGET("avx2") inline void DonorCrossoverAVX2(double* trial, const double* a, const double* b, const double* c, const double* x, double F, double CR, std::size_t n)
+        {
+            const __m256d f = _mm256_set1_pd(F);
+            const __m256d cr = _mm256_set1_pd(CR);
+            std::size_t i = 0;
+            for (; i + 4 <= n; i += 4)
+            {
+                __m256d d = _mm256_sub_pd(_mm256_loadu_pd(b + i), _mm256_loadu_pd(c + i));
+                __m256d z = _mm256_add_pd(_mm256_loadu_pd(a + i), _mm256_mul_pd(f, d));
+                __m256d mask = _mm256_cmp_pd(_mm256_loadu_pd(trial + i), cr, _CMP_LT_OQ);
+                _mm256_storeu_pd(trial + i, _mm256_blendv_pd(_mm256_loadu_pd(x + i), z, mask));
+            }
+            DonorCrossoverScalar(trial + i, a + i, b + i, c + i, x + i, F, CR, n - i);
+        }
+
+        // AVX-512 kernels use masked arithmetic which the compiler never contracts into FMA,
+        // unlike the plain intrinsics that GCC implements as generic vector operations.
+        DE_TARGET("avx512f") inline void DonorAVX512(double* z, const double* a, const double* b, const double* c, double F, std::size_t n)
+        {
+            const __m512d f = _mm512_set1_pd(F);
+            for (std::size_t i = 0; i < n; i += 8)
+            {
+                __mmask8 tail = n - i >= 8 ? __mmask8(0xFF) : __mmask8((1u << (n - i)) - 1);
+                __m512d d = _mm512_maskz_sub_pd(tail, _mm512_maskz_loadu_pd(tail, b + i), _mm512_maskz_loadu_pd(tail, c + i));
+                _mm512_mask_storeu_pd(z + i, tail, _mm512_maskz_add_pd(tail, _mm512_maskz_loadu_pd(tail, a + i), _mm512_maskz_mul_pd(tail, f, d)));
+            }
+        }
+
+        DE_TARGET("avx512f") inline void CrossoverAVX512(double* trial, const double* donor, const double* x, double CR, std::size_t n)
+        {
+            const __m512d cr = _mm512_set1_pd(CR);
+            for (std::size_t i = 0; i < n; i += 8)
+            {
+                __mmask8 tail = n - i >= 8 ? __mmask8(0xFF) : __mmask8((1u << (n - i)) - 1);
+                __mmask8 mask = _mm512_mask_cmp_pd_mask(tail, _mm512_maskz_loadu_pd(tail, trial + i), cr, _CMP_LT_OQ);
+                __m512d blend = _mm512_mask_blend_pd(mask, _mm512_maskz_loadu_pd(tail, x + i), _mm512_maskz_loadu_pd(tail, donor + i));
+                _mm512_mask_storeu_pd(trial + i, tail, blend);
+            }
+        }
+
+        DE_TARGET("avx512f") inline void DonorCrossoverAVX512(double* trial, const double* a, const double* b, const double* c, const double* x, double F, double CR, std::size_t n)
+        {
+            const __m512d f = _mm512_set1_pd(F);
+            const __m512d cr = _mm512_set1_pd(CR);
+            for (std::size_t i = 0; i < n; i += 8)
+            {
+                __mmask8 tail = n - i >= 8 ? __mmask8(0xFF) : __mmask8((1u << (n - i)) - 1);
+                __m512d d = _mm512_maskz_sub_pd(tail, _mm512_maskz_loadu_pd(tail, b + i), _mm512_maskz_loadu_pd(tail, c + i));
+                __m512d z = _mm512_maskz_add_pd(tail, _mm512_maskz_loadu_pd(tail, a + i), _mm512_maskz_mul_pd(tail, f, d));
+                __mmask8 mask = _mm512_mask_cmp_pd_mask(tail, _mm512_maskz_loadu_pd(tail, trial + i), cr, _CMP_LT_OQ);
+                _mm512_mask_storeu_pd(trial + i, tail, _mm512_mask_blend_pd(mask, _mm512_maskz_loadu_pd(tail, x + i), z));
+            }
+        }
+#endif
+    }
+
+    /**
+     * Highest instruction set supported by both the CPU and the operating system.
+     */
+    inline SimdLevel DetectSimdLevel()
+    {
+#if defined(DE_SIMD_X86) && (defined(__GNUC__) || defined(__clang__))
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx512f"))
+        {
+            return SimdLevel::AVX512;
+        }
+        if (__builtin_cpu_supports("avx2"))
+        {
+            return SimdLevel::AVX2;
+        }
+        if (__builtin_cpu_supports("sse2"))
+        {
+            return SimdLevel::SSE2;
+        }
+        return SimdLevel::Scalar;
+#elif defined(DE_SIMD_X86) && defined(_MSC_VER)
+        int info[4];
+        __cpuid(info, 0);
+        const int maxLeaf = info[0];
+
+        __cpuidex(info, 1, 0);
+        const bool sse2 = (info[3] & (1 << 26)) != 0;
+        const bool osxsave = (info[2] & (1 << 27)) != 0;
+        const unsigned long long xcr0 = osxsave ? _xgetbv(0) : 0;
+
+        bool avx2 = false;
+        bool avx512 = false;
+        if (maxLeaf >= 7)
+        {
+            __cpuidex(info, 7, 0);
+            avx2 = (info[1] & (1 << 5)) != 0 && (xcr0 & 0x6) == 0x6;
+            avx512 = (info[1] & (1 << 16)) != 0 && (xcr0 & 0xE6) == 0xE6;
+        }
+
+        if (avx512)
+        {
+            return SimdLevel::AVX512;
+        }
+        if (avx2)
+        {
+            return SimdLevel::AVX2;
+        }
+        return sse2 ? SimdLevel::SSE2 : SimdLevel::Scalar;
+#else
+        return SimdLevel::Scalar;
+#endif
+    }
+
+    /**
+     * Kernels for the requested instruction set. Level is lowered to the one supported by the machine.
+     */
+    inline const SimdKernels& GetSimdKernels(SimdLevel level)
+    {
+        static const SimdLevel detected = DetectSimdLevel();
+        if (level > detected)
+        {
+            level = detected;
+        }
+
+        static const SimdKernels scalar = { &kernels::DonorScalar, &kernels::CrossoverScalar, &kernels::DonorCrossoverScalar, SimdLevel::Scalar };
+#if defined(DE_SIMD_X86)
+        static const SimdKernels sse2 = { &kernels::DonorSSE2, &kernels::CrossoverSSE2, &kernels::DonorCrossoverSSE2, SimdLevel::SSE2 };
+        static const SimdKernels avx2 = { &kernels::DonorAVX2, &kernels::CrossoverAVX2, &kernels::DonorCrossoverAVX2, SimdLevel::AVX2 };
+        static const SimdKernels avx512 = { &kernels::DonorAVX512, &kernels::CrossoverAVX512, &kernels::DonorCrossoverAVX512, SimdLevel::AVX512 };
+
+        switch (level)
+        {
+        case SimdLevel::AVX512:
+            return avx512;
+        case SimdLevel::AVX2:
+            return avx2;
+        case SimdLevel::SSE2:
+            return sse2;
+        default:
+            break;
+        }
+#endif
+        return scalar;
+    }
+
+    /**
+     * Counter-based Philox4x32-10 random engine (Salmon et al., "Parallel random numbers: as easy as 1, 2, 3").
+     *
+     * The 64-bit seed is the key and the stream index is the upper half of the 128-bit counter,
+     * so every (seed, stream) pair is an independent sequence and streams need no jump-ahead.
+     * Produces 64-bit values.
+     */
+    class Philox4x32
+    {
+    public:
+        typedef std::uint64_t result_type;
+
+        explicit Philox4x32(std::uint64_t seed = 0, std::uint64_t stream = 0)
+        {
+            Seed(seed, stream);
+        }
+
+        void Seed(std::uint64_t seed, std::uint64_t stream = 0)
+        {
+            m_key[0] = static_cast<std::uint32_t>(seed);
+            m_key[1] = static_cast<std::uint32_t>(seed >> 32);
+            m_counter[0] = 0;
+            m_counter[1] = 0;
+            m_counter[2] = static_cast<std::uint32_t>(stream);
+            m_counter[3] = static_cast<std::uint32_t>(stream >> 32);
+            m_index = 2;
+        }
+
+        static constexpr result_type min() { return 0; }
+        static constexpr result_type max() { return ~result_type(0); }
+
+        result_type operator()()
+        {
+            if (m_index == 2)
+            {
+                Refill();
+            }
+            return m_buffer[m_index++];
+        }
+
+        /**
+         * Skip n values in constant time.
+         */
+        void Discard(std::uint64_t n)
+        {
+            while (n > 0 && m_index < 2)
+            {
+                m_index++;
+                n--;
+            }
+
+            std::uint64_t blocks = n / 2;
+            std::uint64_t counter = (static_cast<std::uint64_t>(m_counter[1]) << 32 | m_counter[0]) + blocks;
+            m_counter[0] = static_cast<std::uint32_t>(counter);
+            m_counter[1] = static_cast<std::uint32_t>(counter >> 32);
+
+            if (n % 2 == 1)
+            {
+                Refill();
+                m_index = 1;
+            }
+        }
+
+        bool operator==(const Philox4x32& other) const
+        {
+            return std::equal(m_key, m_key + 2, other.m_key) && std::equal(m_counter, m_counter + 4, other.m_counter) &&
+                   m_index == other.m_index && std::equal(m_buffer + m_index, m_buffer + 2, other.m_buffer + other.m_index);
+        }
+
+    private:
+        static void MulHiLo(std::uint32_t a, std::uint32_t b, std::uint32_t& hi, std::uint32_t& lo)
+        {
+            std::uint64_t product = static_cast<std::uint64_t>(a) * b;
+            hi = static_cast<std::uint32_t>(product >> 32);
+            lo = static_cast<std::uint32_t>(product);
+        }
+
+        void Refill()
+        {
+            std::uint32_t x[4] = { m_counter[0], m_counter[1], m_counter[2], m_counter[3] };
+            std::uint32_t key[2] = { m_key[0], m_key[1] };
+
+            for (int round = 0; round < 10; round++)
+            {
+                std::uint32_t hi0, lo0, hi1, lo1;
+                MulHiLo(0xD2511F53u, x[0], hi0, lo0);
+                MulHiLo(0xCD9E8D57u, x[2], hi1, lo1);
+
+                std::uint32_t y[4] = { hi1 ^ x[1] ^ key[0], lo1, hi0 ^ x[3] ^ key[1], lo0 };
+                std::copy(y, y + 4, x);
+
+                key[0] += 0x9E3779B9u;
+                key[1] += 0xBB67AE85u;
+            }
+
+            m_buffer[0] = static_cast<std::uint64_t>(x[1]) << 32 | x[0];
+            m_buffer[1] = static_cast<std::uint64_t>(x[3]) << 32 | x[2];
+            m_index = 0;
+
+            // Advance the lower 64 bits of the counter, the upper half selects the stream
+            if (++m_counter[0] == 0)
+            {
+                ++m_counter[1];
+            }
+        }
+
+        std::uint32_t m_key[2];
+        std::uint32_t m_counter[4];
+        std::uint64_t m_buffer[2];
+        unsigned int m_index;
+    };
+
+    /**
+     * xoshiro256** random engine (Blackman and Vigna) with jump-ahead.
+     *
+     * State is initialized with SplitMix64 from the seed and the stream index. Jump() advances
+     * the state by 2^128 values and LongJump() by 2^192 values for provably disjoint streams.
+     */
+    class Xoshiro256StarStar
+    {
+    public:
+        typedef std::uint64_t result_type;
+
+        explicit Xoshiro256StarStar(std::uint64_t seed = 0, std::uint64_t stream = 0)
+        {
+            Seed(seed, stream);
+        }
+
+        void Seed(std::uint64_t seed, std::uint64_t stream = 0)
+        {
+            std::uint64_t splitMix = seed;
+            std::uint64_t streamMix = SplitMix64(stream);
+            for (auto& s : m_state)
+            {
+                s = SplitMix64(splitMix) ^ streamMix;
+            }
+
+            if ((m_state[0] | m_state[1] | m_state[2] | m_state[3]) == 0)
+            {
+                m_state[0] = 1;
+            }
+        }
+
+        static constexpr result_type min() { return 0; }
+        static constexpr result_type max() { return ~result_type(0); }
+
+        result_type operator()()
+        {
+            const std::uint64_t result = RotateLeft(m_state[1] * 5, 7) * 9;
+            const std::uint64_t t = m_state[1] << 17;
+
+            m_state[2] ^= m_state[0];
+            m_state[3] ^= m_state[1];
+            m_state[1] ^= m_state[2];
+            m_state[0] ^= m_state[3];
+            m_state[2] ^= t;
+            m_state[3] = RotateLeft(m_state[3], 45);
+
+            return result;
+        }
+
+        void Jump()
+        {
+            static const std::uint64_t polynomial[] = { 0x180ec6d33cfd0abaULL, 0xd5a61266f0c9392cULL, 0xa9582618e03fc9aaULL, 0x39abdc4529b1661cULL };
+            ApplyJump(polynomial);
+        }
+
+        void LongJump()
+        {
+            static const std::uint64_t polynomial[] = { 0x76e15d3efefdcbbfULL, 0xc5004e441c522fb3ULL, 0x77710069854ee241ULL, 0x39109bb02acbe635ULL };
+            ApplyJump(polynomial);
+        }
+
+        bool operator==(const Xoshiro256StarStar& other) const
+        {
+            return std::equal(m_state, m_state + 4, other.m_state);
+        }
+
+    private:
+        static std::uint64_t RotateLeft(std::uint64_t x, int k)
+        {
+            return (x << k) | (x >> (64 - k));
+        }
+
+        static std::uint64_t SplitMix64(std::uint64_t& x)
+        {
+            std::uint64_t z = (x += 0x9e3779b97f4a7c15ULL);
+            z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+            z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+            return z ^ (z >> 31);
+        }
+
+        void ApplyJump(const std::uint64_t* polynomial)
+        {
+            std::uint64_t s[4] = { 0, 0, 0, 0 };
+            for (int i = 0; i < 4; i++)
+            {
+                for (int b = 0; b < 64; b++)
+                {
+                    if (polynomial[i] & (std::uint64_t(1) << b))
+                    {
+                        for (int j = 0; j < 4; j++)
+                        {
+                            s[j] ^= m_state[j];
+                        }
+                    }
+                    (*this)();
+                }
+            }
+            std::copy(s, s + 4, m_state);
+        }
+
+        std::uint64_t m_state[4];
+    };
+
+    /**
+     * Engine used for the per-agent random streams. Any class constructible from (seed, stream)
+     * that returns 64-bit values from operator() can be plugged in by defining DE_RANDOM_ENGINE
+     * before including this header.
+     */
+#ifndef DE_RANDOM_ENGINE
+#define DE_RANDOM_ENGINE ::de::Philox4x32
+#endif
+    typedef DE_RANDOM_ENGINE RandomEngine;
+
+    /**
+     * Stream ids of engines sharing a seed, so no two of them draw the same numbers. Agent x uses
+     * stream x below 2^32, thread w of AsynchronousSteps g_threadStreams + w, island model migration
+     * g_migrationStreams (plus the island index in RemoteIsland) and restarts g_restartStream.
+     */
+    static constexpr std::uint64_t g_threadStreams = std::uint64_t(1) << 32;
+    static constexpr std::uint64_t g_migrationStreams = std::uint64_t(1) << 33;
+    static constexpr std::uint64_t g_restartStream = std::uint64_t(1) << 34;
+
+    /**
+     * Uniform double in [0, 1) built from the upper 53 bits of a single draw.
+     */
+    template<typename Engine>
+    inline double UniformReal(Engine& engine)
+    {
+        return static_cast<double>(static_cast<std::uint64_t>(engine()) >> 11) * (1.0 / 9007199254740992.0);
+    }
+
+    template<typename Engine>
+    inline double UniformReal(Engine& engine, double lower, double upper)
+    {
+        return lower + (upper - lower) * UniformReal(engine);
+    }
+
+    /**
+     * Exactly uniform integer in [0, n) using Lemire's multiply-shift method.
+     * It redraws with probability below n / 2^32, no division is needed in the common case.
+     */
+    template<typename Engine>
+    inline std::uint32_t UniformIndex(Engine& engine, std::uint32_t n)
+    {
+        std::uint64_t m = static_cast<std::uint64_t>(static_cast<std::uint32_t>(static_cast<std::uint64_t>(engine()) >> 32)) * n;
+        std::uint32_t low = static_cast<std::uint32_t>(m);
+        if (low < n)
+        {
+            const std::uint32_t threshold = static_cast<std::uint32_t>(-n) % n;
+            while (low < threshold)
+            {
+                m = static_cast<std::uint64_t>(static_cast<std::uint32_t>(static_cast<std::uint64_t>(engine()) >> 32)) * n;
+                low = static_cast<std::uint32_t>(m);
+            }
+        }
+        return static_cast<std::uint32_t>(m >> 32);
+    }
+
+    /**
+     * Normal random value using the Box-Muller transform. Consumes two draws.
+     */
+    template<typename Engine>
+    inline double NormalReal(Engine& engine, double mean, double sigma)
+    {
+        const double u1 = 1.0 - UniformReal(engine);
+        const double u2 = UniformReal(engine);
+        return mean + sigma * std::sqrt(-2.0 * std::log(u1)) * std::cos(6.283185307179586 * u2);
+    }
+
+    /**
+     * Cauchy random value by inversion. Consumes one draw.
+     */
+    template<typename Engine>
+    inline double CauchyReal(Engine& engine, double location, double scale)
+    {
+        return location + scale * std::tan(3.141592653589793 * (UniformReal(engine) - 0.5));
+    }
+
+    /**
+     * Draw k distinct indices from [0, n) excluding index exclude, uniformly over ordered k-tuples.
+     *
+     * Sequential selection without rejection: the j-th index is drawn from the n - 1 - j values that
+     * are still free and mapped onto them by skipping the already taken ones. Exactly k draws are made.
+     * Costs O(k^2), intended for the few indices needed by mutation strategies.
+     */
+    template<typename Engine>
+    inline void SampleDistinct(Engine& engine, std::uint32_t n, std::uint32_t exclude, std::uint32_t* out, unsigned int k)
+    {
+        static const unsigned int maxSamples = 15;
+        assert(k <= maxSamples && k + 1 <= n);
+
+        // Taken indices in ascending order, including the excluded one
+        std::uint32_t taken[maxSamples + 1];
+        unsigned int numberOfTaken = 0;
+
+        if (exclude < n)
+        {
+            taken[numberOfTaken++] = exclude;
+        }
+
+        for (unsigned int j = 0; j < k; j++)
+        {
+            std::uint32_t value = UniformIndex(engine, n - numberOfTaken);
+
+            unsigned int position = 0;
+            while (position < numberOfTaken && taken[position] <= value)
+            {
+                value++;
+                position++;
+            }
+
+            for (unsigned int p = numberOfTaken; p > position; p--)
+            {
+                taken[p] = taken[p - 1];
+            }
+            taken[position] = value;
+            numberOfTaken++;
+
+            out[j] = value;
+        }
+    }
+
+    /**
+     * Data available to mutation and crossover policies while a trial vector is built.
+     */
+    struct StrategyContext
+    {
+        const AlignedMatrix* population;
+        unsigned int populationSize;
+        unsigned int numberOfParameters;
+
+        // Index of the best agent of the previous generation
+        unsigned int best;
+
+        // Indices of the best p * populationSize agents, used by current-to-pbest
+        const std::uint32_t* pBestAgents;
+        unsigned int numberOfPBestAgents;
+
+        double F;
+        double CR;
+
+        const SimdKernels* kernels;
+
+        // Set by asynchronous workers, which refresh a row of their population snapshot before it is read
+        void (*refreshRow)(void* snapshot, unsigned int row);
+        void* snapshot;
+
+        const double* Row(unsigned int row) const
+        {
+            if (refreshRow)
+            {
+                refreshRow(snapshot, row);
+            }
+            return population->RowData(row);
+        }
+    };
+
+    /**
+     * Mutation policies compute the donor vector of target agent x.
+     *
+     * A policy provides
+     *     template<typename Engine>
+     *     static void Donor(const StrategyContext& context, unsigned int x, Engine& engine, double* donor);
+     * usesPBest telling whether it needs StrategyContext::pBestAgents and minimumPopulationSize,
+     * the number of distinct agents it needs including the target. Agents are read through
+     * StrategyContext::Row.
+     */
+    struct MutationRand1
+    {
+        static const bool usesPBest = false;
+        static const unsigned int minimumPopulationSize = 4;
+
+        // donor = a + F * (b - c)
+        template<typename Engine>
+        static void Donor(const StrategyContext& context, unsigned int x, Engine& engine, double* donor)
+        {
+            std::uint32_t r[3];
+            SampleDistinct(engine, context.populationSize, x, r, 3);
+
+            context.kernels->donor(donor, context.Row(r[0]), context.Row(r[1]), context.Row(r[2]), context.F, context.numberOfParameters);
+        }
+    };
+
+    struct MutationRand2
+    {
+        static const bool usesPBest = false;
+        static const unsigned int minimumPopulationSize = 6;
+
+        // donor = a + F * (b - c) + F * (d - e)
+        template<typename Engine>
+        static void Donor(const StrategyContext& context, unsigned int x, Engine& engine, double* donor)
+        {
+            std::uint32_t r[5];
+            SampleDistinct(engine, context.populationSize, x, r, 5);
+
+            context.kernels->donor(donor, context.Row(r[0]), context.Row(r[1]), context.Row(r[2]), context.F, context.numberOfParameters);
+            context.kernels->donor(donor, donor, context.Row(r[3]), context.Row(r[4]), context.F, context.numberOfParameters);
+        }
+    };
+
+    struct MutationBest1
+    {
+        static const bool usesPBest = false;
+        static const unsigned int minimumPopulationSize = 3;
+
+        // donor = best + F * (a - b)
+        template<typename Engine>
+        static void Donor(const StrategyContext& context, unsigned int x, Engine& engine, double* donor)
+        {
+            std::uint32_t r[2];
+            SampleDistinct(engine, context.populationSize, x, r, 2);
+
+            context.kernels->donor(donor, context.Row(context.best), context.Row(r[0]), context.Row(r[1]), context.F, context.numberOfParameters);
+        }
+    };
+
+    struct MutationBest2
+    {
+        static const bool usesPBest = false;
+        static const unsigned int minimumPopulationSize = 5;
+
+        // donor = best + F * (a - b) + F * (c - d)
+        template<typename Engine>
+        static void Donor(const StrategyContext& context, unsigned int x, Engine& engine, double* donor)
+        {
+            std::uint32_t r[4];
+            SampleDistinct(engine, context.populationSize, x, r, 4);
+
+            context.kernels->donor(donor, context.Row(context.best), context.Row(r[0]), context.Row(r[1]), context.F, context.numberOfParameters);
+            context.kernels->donor(donor, donor, context.Row(r[2]), context.Row(r[3]), context.F, context.numberOfParameters);
+        }
+    };
+
+    struct MutationCurrentToBest1
+    {
+        static const bool usesPBest = false;
+        static const unsigned int minimumPopulationSize = 3;
+
+        // donor = x + F * (best - x) + F * (a - b)
+        template<typename Engine>
+        static void Donor(const StrategyContext& context, unsigned int x, Engine& engine, double* donor)
+        {
+            std::uint32_t r[2];
+            SampleDistinct(engine, context.populationSize, x, r, 2);
+
+            context.kernels->donor(donor, context.Row(x), context.Row(context.best), context.Row(x), context.F, context.numberOfParameters);
+            context.kernels->donor(donor, donor, context.Row(r[0]), context.Row(r[1]), context.F, context.numberOfParameters);
+        }
+    };
+
+    struct MutationCurrentToPBest1
+    {
+        static const bool usesPBest = true;
+        static const unsigned int minimumPopulationSize = 3;
+
+        // donor = x + F * (pbest - x) + F * (a - b), pbest is a random agent among the p best ones
+        template<typename Engine>
+        static void Donor(const StrategyContext& context, unsigned int x, Engine& engine, double* donor)
+        {
+            const std::uint32_t pBest = context.pBestAgents[UniformIndex(engine, context.numberOfPBestAgents)];
+
+            std::uint32_t r[2];
+            SampleDistinct(engine, context.populationSize, x, r, 2);
+
+            context.kernels->donor(donor, context.Row(x), context.Row(pBest), context.Row(x), context.F, context.numberOfParameters);
+            context.kernels->donor(donor, donor, context.Row(r[0]), context.Row(r[1]), context.F, context.numberOfParameters);
+        }
+    };
+
+    struct MutationRandToBest2
+    {
+        static const bool usesPBest = false;
+        static const unsigned int minimumPopulationSize = 6;
+
+        // donor = a + F * (best - a) + F * (b - c) + F * (d - e)
+        template<typename Engine>
+        static void Donor(const StrategyContext& context, unsigned int x, Engine& engine, double* donor)
+        {
+            std::uint32_t r[5];
+            SampleDistinct(engine, context.populationSize, x, r, 5);
+
+            context.kernels->donor(donor, context.Row(r[0]), context.Row(context.best), context.Row(r[0]), context.F, context.numberOfParameters);
+            context.kernels->donor(donor, donor, context.Row(r[1]), context.Row(r[2]), context.F, context.numberOfParameters);
+            context.kernels->donor(donor, donor, context.Row(r[3]), context.Row(r[4]), context.F, context.numberOfParameters);
+        }
+    };
+
+    /**
+     * Crossover policies combine the donor with target agent x into the trial vector.
+     *
+     * A policy provides
+     *     template<typename Engine>
+     *     static void Apply(const StrategyContext& context, Engine& engine, const double* donor, const double* x, double* trial);
+     */
+    struct CrossoverBinomial
+    {
+        // Each dimension is taken from the donor with probability CR, one random dimension always
+        template<typename Engine>
+        static void Apply(const StrategyContext& context, Engine& engine, const double* donor, const double* x, double* trial)
+        {
+            const unsigned int R = UniformIndex(engine, context.numberOfParameters);
+
+            // Crossover randoms are stored in the trial until the blend overwrites them
+            for (unsigned int i = 0; i < context.numberOfParameters; i++)
+            {
+                trial[i] = UniformReal(engine);
+            }
+
+            context.kernels->crossover(trial, donor, x, context.CR, context.numberOfParameters);
+            trial[R] = donor[R];
+        }
+    };
+
+    struct CrossoverExponential
+    {
+        // Circular run of dimensions taken from the donor, starting at a random dimension and
+        // continuing while uniform random values are below CR
+        template<typename Engine>
+        static void Apply(const StrategyContext& context, Engine& engine, const double* donor, const double* x, double* trial)
+        {
+            const unsigned int n = context.numberOfParameters;
+            std::memcpy(trial, x, n * sizeof(double));
+
+            unsigned int i = UniformIndex(engine, n);
+            unsigned int length = 0;
+            do
+            {
+                trial[i] = donor[i];
+                i = i + 1 == n ? 0 : i + 1;
+                length++;
+            }
+            while (length < n && UniformReal(engine) < context.CR);
+        }
+    };
+
+    struct CrossoverArithmetic
+    {
+        // trial = x + K * (donor - x) with K uniform in [0, 1), rotation invariant
+        template<typename Engine>
+        static void Apply(const StrategyContext& context, Engine& engine, const double* donor, const double* x, double* trial)
+        {
+            const double K = UniformReal(engine);
+            context.kernels->donor(trial, x, donor, x, K, context.numberOfParameters);
+        }
+    };
+
+    /**
+     * Builds a trial vector from a mutation and a crossover policy.
+     */
+    template<typename Mutation, typename Crossover>
+    struct TrialBuilder
+    {
+        template<typename Engine>
+        static void Build(const StrategyContext& context, unsigned int x, Engine& engine, double* donor, double* trial)
+        {
+            Mutation::Donor(context, x, engine, donor);
+            Crossover::Apply(context, engine, donor, context.Row(x), trial);
+        }
+    };
+
+    /**
+     * DE/rand/1/bin computes donor and crossover in a single fused pass without the donor buffer.
+     * Random draws and arithmetic are the same as in the generic path.
+     */
+    template<>
+    struct TrialBuilder<MutationRand1, CrossoverBinomial>
+    {
+        template<typename Engine>
+        static void Build(const StrategyContext& context, unsigned int x, Engine& engine, double*, double* trial)
+        {
+            std::uint32_t r[3];
+            SampleDistinct(engine, context.populationSize, x, r, 3);
+
+            const double* agentA = context.Row(r[0]);
+            const double* agentB = context.Row(r[1]);
+            const double* agentC = context.Row(r[2]);
+
+            const unsigned int R = UniformIndex(engine, context.numberOfParameters);
+
+            for (unsigned int i = 0; i < context.numberOfParameters; i++)
+            {
+                trial[i] = UniformReal(engine);
+            }
+
+            context.kernels->donorCrossover(trial, agentA, agentB, agentC, context.Row(x), context.F, context.CR, context.numberOfParameters);
+            trial[R] = agentA[R] + context.F * (agentB[R] - agentC[R]);
+        }
+    };
+
+    /**
+     * Runtime selectable mutation strategies, see the Mutation* policies.
+     */
+    enum class MutationStrategy
+    {
+        Rand1,
+        Rand2,
+        Best1,
+        Best2,
+        CurrentToBest1,
+        CurrentToPBest1,
+        RandToBest2
+    };
+
+    /**
+     * Runtime selectable crossover strategies, see the Crossover* policies.
+     */
+    enum class CrossoverStrategy
+    {
+        Binomial,
+        Exponential,
+        Arithmetic
+    };
+
+    /**
+     * Control of the mutation factor F and the crossover rate CR.
+     *
+     * Fixed: F and CR set by SetF and SetCR are used for all agents.
+     * JDE: each agent carries its own F and CR, which are regenerated with probability 0.1 and
+     *      kept when the trial succeeds (Brest et al. 2006).
+     * JADE: F is sampled from Cauchy(muF, 0.1) and CR from Normal(muCR, 0.1) per trial, the means move
+     *       towards the Lehmer mean of successful F and arithmetic mean of successful CR (Zhang and Sanderson 2009).
+     * SHADE: as JADE but sampling around a random entry of a success history memory, updated once per
+     *        generation with improvement weighted means (Tanabe and Fukunaga 2013).
+     */
+    enum class ParameterControl
+    {
+        Fixed,
+        JDE,
+        JADE,
+        SHADE
+    };
+
+    /**
+     * Comparison of agents of an IConstrainedOptimizable.
+     *
+     * FeasibilityRules: Deb's rules, a feasible agent beats an infeasible one, feasible agents are
+     * compared by cost and infeasible ones by the total violation.
+     * Epsilon: epsilon constrained comparison, violations up to the epsilon level count as feasible.
+     * The level starts at the violation of a quantile of the initial population and decreases to zero.
+     */
+    enum class ConstraintHandling
+    {
+        FeasibilityRules,
+        Epsilon
+    };
+
+    /**
+     * Reason why the last Continue or Optimize call stopped.
+     */
+    enum class StopReason
+    {
+        None,
+        Generations,
+        TerminationCondition,
+        MaxEvaluations,
+        Deadline,
+        TargetCost,
+        StopToken,
+        CostSpread,
+        ParameterSpread,
+        Stagnation,
+        ImprovementRate
+    };
+
+    /**
+     * Restart of the optimization from a new random population when a convergence detector fires.
+     *
+     * None: the run stops instead.
+     * IPOP: the population grows by a constant factor with every restart.
+     * BIPOP: restarts alternate between the growing population and small populations of random size.
+     */
+    enum class RestartStrategy
+    {
+        None,
+        IPOP,
+        BIPOP
+    };
+
+    /**
+     * Handling of trial vectors violating the box constraints, used when constraints are checked.
+     * Parent is the target agent of the trial.
+     *
+     * Reject: build a new trial, after g_maxRejections attempts the trial is repaired with BounceBack.
+     * Clamp: set violating parameters to the violated bound.
+     * Reflect: mirror violating parameters at the violated bound.
+     * BounceBack: random point between the violated bound and the parent.
+     * Midpoint: midpoint between the violated bound and the parent.
+     * RandomReinit: uniform random value within the bounds.
+     * Wrap: periodic wrap around into the bounds.
+     */
+    enum class BoundHandling
+    {
+        Reject,
+        Clamp,
+        Reflect,
+        BounceBack,
+        Midpoint,
+        RandomReinit,
+        Wrap
+    };
+
+    /**
+     * Persistent pool of worker threads used to process the population in parallel.
+     *
+     * Work is distributed with ParallelFor which splits the index range into chunks that are
+     * taken dynamically by the workers and by the calling thread. No allocation is done per call.
+     */
+    class ThreadPool
+    {
+    public:
+        explicit ThreadPool(unsigned int numberOfThreads) :
+            m_numberOfThreads(numberOfThreads == 0 ? 1 : numberOfThreads),
+            m_invoke(nullptr),
+            m_context(nullptr),
+            m_count(0),
+            m_grain(1),
+            m_next(0),
+            m_jobId(0),
+            m_activeWorkers(0),
+            m_stop(false)
+        {
+            // Calling thread participates in the work so one thread less is spawned
+            for (unsigned int i = 1; i < m_numberOfThreads; i++)
+            {
+                m_workers.emplace_back(&ThreadPool::WorkerLoop, this, i);
+            }
+        }
+
+        ~ThreadPool()
+        {
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_stop = true;
+            }
+            m_wakeUp.notify_all();
+
+            for (auto& worker : m_workers)
+            {
+                worker.join();
+            }
+        }
+
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+
+        unsigned int NumberOfThreads() const
+        {
+            return m_numberOfThreads;
+        }
+
+        /**
+         * Call function(begin, end, threadIndex) for chunks of at most grain indices covering [0, count).
+         * Thread index is in [0, NumberOfThreads()) and identifies the thread processing the chunk,
+         * the calling thread has index 0. Returns after all chunks are processed.
+         * Exception thrown from any chunk is rethrown here.
+         */
+        template<typename Function>
+        void ParallelFor(std::size_t count, std::size_t grain, Function& function)
+        {
+            if (count == 0)
+            {
+                return;
+            }
+
+            if (m_workers.empty() || count <= grain)
+            {
+                function(std::size_t(0), count, 0u);
+                return;
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_invoke = &Invoke<Function>;
+                m_context = &function;
+                m_count = count;
+                m_grain = grain == 0 ? 1 : grain;
+                m_next.store(0);
+                m_exception = nullptr;
+                m_activeWorkers = static_cast<unsigned int>(m_workers.size());
+                m_jobId++;
+            }
+            m_wakeUp.notify_all();
+
+            ProcessChunks(0);
+
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_done.wait(lock, [this]() { return m_activeWorkers == 0; });
+
+            m_invoke = nullptr;
+            m_context = nullptr;
+
+            if (m_exception)
+            {
+                std::exception_ptr exception = m_exception;
+                m_exception = nullptr;
+                std::rethrow_exception(exception);
+            }
+        }
+
+    private:
+        template<typename Function>
+        static void Invoke(void* context, std::size_t begin, std::size_t end, unsigned int threadIndex)
+        {
+            (*static_cast<Function*>(context))(begin, end, threadIndex);
+        }
+
+        void ProcessChunks(unsigned int threadIndex)
+        {
+            while (true)
+            {
+                std::size_t begin = m_next.fetch_add(m_grain);
+                if (begin >= m_count)
+                {
+                    return;
+                }
+
+                std::size_t end = std::min(begin + m_grain, m_count);
+
+                try
+                {
+                    m_invoke(m_context, begin, end, threadIndex);
+                }
+                catch (...)
+                {
+                    std::lock_guard<std::mutex> lock(m_mutex);
+                    if (!m_exception)
+                    {
+                        m_exception = std::current_exception();
+                    }
+                }
+            }
+        }
+
+        void WorkerLoop(unsigned int threadIndex)
+        {
+            unsigned long long lastJobId = 0;
+
+            while (true)
+            {
+                {
+                    std::unique_lock<std::mutex> lock(m_mutex);
+                    m_wakeUp.wait(lock, [&]() { return m_stop || m_jobId != lastJobId; });
+
+                    if (m_stop)
+                    {
+                        return;
+                    }
+
+                    lastJobId = m_jobId;
+                }
+
+                ProcessChunks(threadIndex);
+
+                {
+                    std::lock_guard<std::mutex> lock(m_mutex);
+                    m_activeWorkers--;
+                    if (m_activeWorkers == 0)
+                    {
+                        m_done.notify_one();
+                    }
+                }
+            }
+        }
+
+        unsigned int m_numberOfThreads;
+        std::vector<std::thread> m_workers;
+
+        void (*m_invoke)(void*, std::size_t, std::size_t, unsigned int);
+        void* m_context;
+        std::size_t m_count;
+        std::size_t m_grain;
+        std::atomic<std::size_t> m_next;
+        std::exception_ptr m_exception;
+
+        unsigned long long m_jobId;
+        unsigned int m_activeWorkers;
+        bool m_stop;
+
+        std::mutex m_mutex;
+        std::condition_variable m_wakeUp;
+        std::condition_variable m_done;
+    };
+
+    /**
+     * Checkpoint file layout: CheckpointHeader followed by the payload written by
+     * DifferentialEvolution::SaveState. All values are in host byte order, the checksum is the CRC-32
+     * of the payload.
+     */
+    struct CheckpointHeader
+    {
+        static const std::uint32_t g_version = 5;
+
+        char magic[8];
+        std::uint32_t version;
+        std::uint32_t headerSize;
+        std::uint64_t payloadSize;
+        std::uint32_t checksum;
+        std::uint32_t engineSize;
+        std::uint64_t reserved;
+    };
+
+    static_assert(sizeof(CheckpointHeader) == 40, "Checkpoint header must be 40 bytes");
+
+    namespace checkpoint
+    {
+        static const char g_magic[8] = { 'D', 'E', 'C', 'H', 'E', 'C', 'K', '1' };
+
+        inline std::uint32_t Crc32(const char* data, std::size_t size)
+        {
+            struct Table
+            {
+                std::uint32_t values[256];
+
+                Table()
+                {
+                    for (std::uint32_t i = 0; i < 256; i++)
+                    {
+                        std::uint32_t value = i;
+                        for (int bit = 0; bit < 8; bit++)
+                        {
+                            value = value & 1 ? 0xEDB88320u ^ (value >> 1) : value >> 1;
+                        }
+                        values[i] = value;
+                    }
+                }
+            };
+            static const Table table;
+
+            std::uint32_t crc = 0xFFFFFFFFu;
+            for (std::size_t i = 0; i < size; i++)
+            {
+                crc = table.values[(crc ^ static_cast<unsigned char>(data[i])) & 0xFF] ^ (crc >> 8);
+            }
+            return ~crc;
+        }
+
+        inline void Append(std::vector<char>& bytes, std::size_t& offset, const void* data, std::size_t size)
+        {
+            std::memcpy(bytes.data() + offset, data, size);
+            offset += size;
+        }
+
+        inline void Read(const char* bytes, std::size_t& offset, void* data, std::size_t size)
+        {
+            std::memcpy(data, bytes + offset, size);
+            offset += size;
+        }
+
+        /**
+         * Fill in the checksum of a serialized state.
+         */
+        inline void Seal(std::vector<char>& bytes)
+        {
+            CheckpointHeader header;
+            std::memcpy(&header, bytes.data(), sizeof(header));
+            header.checksum = Crc32(bytes.data() + sizeof(header), bytes.size() - sizeof(header));
+            std::memcpy(bytes.data(), &header, sizeof(header));
+        }
+
+        /**
+         * Fill in the checksum of a serialized state and write it to path. The state is written to a
+         * temporary file which replaces path only when complete, so an interrupted write keeps the
+         * previous checkpoint.
+         */
+        inline bool WriteFile(const std::string& path, std::vector<char>& bytes)
+        {
+            Seal(bytes);
+
+            const std::string temporary = path + ".tmp";
+#if defined(_WIN32)
+            std::FILE* file = std::fopen(temporary.c_str(), "wb");
+            if (!file)
+            {
+                return false;
+            }
+            const bool written = std::fwrite(bytes.data(), 1, bytes.size(), file) == bytes.size() && std::fflush(file) == 0;
+            std::fclose(file);
+            std::remove(path.c_str());
+#else
+            const int fd = ::open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+            if (fd < 0)
+            {
+                return false;
+            }
+            bool written = true;
+            std::size_t offset = 0;
+            while (written && offset < bytes.size())
+            {
+                const ssize_t count = ::write(fd, bytes.data() + offset, bytes.size() - offset);
+                written = count > 0;
+                offset += written ? static_cast<std::size_t>(count) : 0;
+            }
+            written = written && ::fsync(fd) == 0;
+            ::close(fd);
+#endif
+            return written && std::rename(temporary.c_str(), path.c_str()) == 0;
+        }
+
+        /**
+         * Read only view of a checkpoint file, memory mapped where supported.
+         */
+        class MappedFile
+        {
+        public:
+            explicit MappedFile(const std::string& path) :
+                m_data(nullptr),
+                m_size(0)
+            {
+#if defined(_WIN32)
+                std::ifstream file(path, std::ios::binary | std::ios::ate);
+                if (file)
+                {
+                    m_buffer.resize(static_cast<std::size_t>(file.tellg()));
+                    file.seekg(0);
+                    if (file.read(m_buffer.data(), m_buffer.size()))
+                    {
+                        m_data = m_buffer.data();
+                        m_size = m_buffer.size();
+                    }
+                }
+#else
+                const int fd = ::open(path.c_str(), O_RDONLY);
+                if (fd < 0)
+                {
+                    return;
+                }
+                struct stat status;
+                if (::fstat(fd, &status) == 0 && status.st_size > 0)
+                {
+                    void* data = ::mmap(nullptr, static_cast<std::size_t>(status.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+                    if (data != MAP_FAILED)
+                    {
+                        m_data = static_cast<const char*>(data);
+                        m_size = static_cast<std::size_t>(status.st_size);
+                    }
+                }
+                ::close(fd);
+#endif
+            }
+
+            ~MappedFile()
+            {
+#if !defined(_WIN32)
+                if (m_data)
+                {
+                    ::munmap(const_cast<char*>(m_data), m_size);
+                }
+#endif
+            }
+
+            MappedFile(const MappedFile&) = delete;
+            MappedFile& operator=(const MappedFile&) = delete;
+
+            const char* Data() const { return m_data; }
+            std::size_t Size() const { return m_size; }
+
+        private:
+            const char* m_data;
+            std::size_t m_size;
+#if defined(_WIN32)
+            std::vector<char> m_buffer;
+#endif
+        };
+    }
+
+    /**
+     * Background thread writing checkpoints. The optimizer hands over serialized states and
+     * continues, the checksum and the file write happen on the writer thread. If a new state
+     * arrives before the previous one is written, only the newest one is written.
+     */
+    class CheckpointWriter
+    {
+    public:
+        explicit CheckpointWriter(const std::string& path) :
+            m_path(path),
+            m_hasPending(false),
+            m_busy(false),
+            m_failed(false),
+            m_stop(false)
+        {
+            m_thread = std::thread(&CheckpointWriter::Run, this);
+        }
+
+        /**
+         * Writes the pending state before returning.
+         */
+        ~CheckpointWriter()
+        {
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_stop = true;
+            }
+            m_wakeUp.notify_all();
+            m_thread.join();
+        }
+
+        CheckpointWriter(const CheckpointWriter&) = delete;
+        CheckpointWriter& operator=(const CheckpointWriter&) = delete;
+
+        /**
+         * Hand over a serialized state. Buffers are swapped rather than copied, state receives a
+         * previously used buffer so steady state checkpointing does not allocate.
+         */
+        void Submit(std::vector<char>& state)
+        {
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                std::swap(m_pending, state);
+                m_hasPending = true;
+            }
+            m_wakeUp.notify_one();
+        }
+
+        /**
+         * Wait until all submitted states are written. Returns false if any write has failed.
+         */
+        bool Flush()
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_done.wait(lock, [this]() { return !m_hasPending && !m_busy; });
+            return !m_failed;
+        }
+
+        const std::string& Path() const
+        {
+            return m_path;
+        }
+
+    private:
+        void Run()
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            while (true)
+            {
+                m_wakeUp.wait(lock, [this]() { return m_hasPending || m_stop; });
+                if (!m_hasPending)
+                {
+                    return;
+                }
+
+                std::swap(m_writing, m_pending);
+                m_hasPending = false;
+                m_busy = true;
+
+                lock.unlock();
+                const bool written = checkpoint::WriteFile(m_path, m_writing);
+                lock.lock();
+
+                m_busy = false;
+                m_failed = m_failed || !written;
+                m_done.notify_all();
+            }
+        }
+
+        std::string m_path;
+        std::vector<char> m_pending;
+        std::vector<char> m_writing;
+        bool m_hasPending;
+        bool m_busy;
+        bool m_failed;
+        bool m_stop;
+
+        std::thread m_thread;
+        std::mutex m_mutex;
+        std::condition_variable m_wakeUp;
+        std::condition_variable m_done;
+    };
+
+    /**
+     * Statistics of one generation of DifferentialEvolution::SelectionAndCorssing.
+     *
+     * Wall time of a generation is split into the time spent evaluating the cost function, including
+     * general constraints, and the remaining optimizer overhead (trial construction, selection,
+     * parameter control and checkpointing). With several threads the evaluation time is the wall time
+     * of the parallel evaluation, not the sum over threads.
+     */
+    struct GenerationTelemetry
+    {
+        unsigned long long generation;
+        unsigned int populationSize;
+
+        // Cost function evaluations in this generation and since InitPopulation
+        unsigned long long evaluations;
+        unsigned long long totalEvaluations;
+
+        // Trials which replaced their target agent
+        unsigned int replacements;
+
+        // Trials rebuilt or repaired because they violated the box constraints
+        unsigned long long rejections;
+        unsigned long long repairs;
+
+        double bestCost;
+        double meanCost;
+        double worstCost;
+
+        // Mean over parameters of the standard deviation of the population
+        double diversity;
+
+        double evaluationSeconds;
+        double overheadSeconds;
+    };
+
+    /**
+     * Receiver of per generation telemetry, see DifferentialEvolution::AddTelemetrySink.
+     * OnGeneration is called from the optimizer thread at the end of each generation.
+     */
+    class ITelemetrySink
+    {
+    public:
+        virtual void OnGeneration(const GenerationTelemetry& telemetry) = 0;
+
+        virtual ~ITelemetrySink() {}
+    };
+
+    class DifferentialEvolution
+    {
+    public:
+        /**
+         * Construct Differential Evolution optimizer
+         *
+         * \param costFunction Cost function to minimize
+         * \param populationSize Number of agents in each optimization step
+         * \param randomSeed Set random seed to a fix value to have repeatable (non stochastic) experiments
+         * \param shouldCheckConstraints Should constraints bee checked on for each new candidate.
+         * This check check may be turned off to increase performance if the cost function is defined
+         * and has no local minimum outside of the constraints.
+         * \param callback Optional callback to be called after each optimization iteration has finished.
+         * Optimization iteration is defined as processing of single population with SelectionAndCorssing method.
+         */
+        DifferentialEvolution(  const IOptimizable& costFunction,
+                                unsigned int populationSize,
+                                int randomSeed = 123,
+                                bool shouldCheckConstraints = true,
+                                std::function<void(const DifferentialEvolution&)> callback = nullptr,
+                                std::function<bool(const DifferentialEvolution&)> terminationCondition = nullptr) :
+            m_cost(costFunction),
+            m_populationSize(populationSize),
+            m_F(0.8),
+            m_CR(0.9),
+            m_bestAgentIndex(0),
+            m_minCost(std::numeric_limits<double>::infinity()),
+            m_shouldCheckConstraints(shouldCheckConstraints),
+            m_callback(callback),
+            m_terminationCondition(terminationCondition),
+            m_kernels(&GetSimdKernels(SimdLevel::AVX512)),
+            m_generation(&DifferentialEvolution::SelectionAndCorssing<MutationRand1, CrossoverBinomial>),
+            m_pBest(0.1),
+            m_parameterControl(ParameterControl::Fixed),
+            m_historyIndex(0),
+            m_maxPopulationSize(populationSize),
+            m_initialPopulationSize(populationSize),
+            m_minimumStrategyPopulationSize(MutationRand1::minimumPopulationSize),
+            m_evaluations(0),
+            m_randomSeed(randomSeed),
+            m_asynchronousSteps(&DifferentialEvolution::AsynchronousSteps<MutationRand1, CrossoverBinomial>),
+            m_numberOfGenerations(0),
+            m_checkpointInterval(0),
+            m_surrogate(nullptr),
+            m_surrogateScreening(SurrogateScreening::PredictedBetter),
+            m_surrogateTopK(0),
+            m_numberOfScreenedTrials(0),
+            m_numberOfSelectedTrials(0),
+            m_boundHandling(BoundHandling::Reject),
+            m_boundCounters(1),
+            m_constrainedCost(dynamic_cast<const IConstrainedOptimizable*>(&costFunction)),
+            m_numberOfConstraints(m_constrainedCost ? m_constrainedCost->NumberOfConstraints() : 0),
+            m_constraintHandling(ConstraintHandling::FeasibilityRules),
+            m_epsilonGenerations(0),
+            m_epsilonExponent(5.0),
+            m_epsilonQuantile(0.2),
+            m_initialEpsilon(0.0),
+            m_epsilon(0.0),
+            m_numberOfSkippedEvaluations(0),
+            m_telemetry(),
+            m_collectStatistics(false),
+            m_maxEvaluations(0),
+            m_deadline(std::chrono::steady_clock::time_point::max()),
+            m_targetCost(-std::numeric_limits<double>::infinity()),
+            m_stopToken(nullptr),
+            m_stopCheckBatchSize(1),
+            m_stopReason(StopReason::None),
+            m_evaluatedTrials(0),
+            m_worstAgentIndex(0),
+            m_costSpreadThreshold(-std::numeric_limits<double>::infinity()),
+            m_parameterSpreadThreshold(-std::numeric_limits<double>::infinity()),
+            m_stagnationGenerations(0),
+            m_generationsWithoutImprovement(0),
+            m_lastBestCost(std::numeric_limits<double>::infinity()),
+            m_improvementRateThreshold(-std::numeric_limits<double>::infinity()),
+            m_improvementRate(std::numeric_limits<double>::infinity()),
+            m_detectorGenerations(0),
+            m_restartStrategy(RestartStrategy::None),
+            m_populationIncrease(2.0),
+            m_numberOfRestarts(0),
+            m_largeRestarts(0),
+            m_smallRegime(false),
+            m_regimeStartEvaluations(0),
+            m_largeRegimeEvaluations(0),
+            m_smallRegimeEvaluations(0),
+            m_restartGenerator(static_cast<std::uint64_t>(randomSeed), g_restartStream),
+            m_restartBestCost(std::numeric_limits<double>::infinity()),
+            m_restartBestViolation(std::numeric_limits<double>::infinity())
+        {
+            assert(m_populationSize >= 4);
+
+            m_numberOfParameters = m_cost.NumberOfParameters();
+            ReservePopulation(m_populationSize);
+
+            if (m_constrainedCost)
+            {
+                m_constraintValues.Resize(1, std::max(1u, m_numberOfConstraints));
+            }
+
+            m_donors.Resize(1, m_numberOfParameters);
+            ResetSuccesses();
+
+            m_restartBest.Resize(m_numberOfParameters);
+
+            m_constraints = costFunction.GetConstraints();
+
+            m_parameterMeans.Resize(m_numberOfParameters);
+            m_parameterSquares.Resize(m_numberOfParameters);
+
+            // Bounds as arrays for branch free checks and repairs, unconstrained parameters are infinite
+            m_lowerBounds.Resize(m_numberOfParameters);
+            m_upperBounds.Resize(m_numberOfParameters);
+            for (unsigned int i = 0; i < m_numberOfParameters; i++)
+            {
+                const bool constrained = i < m_constraints.size() && m_constraints[i].isConstrained;
+                m_lowerBounds[i] = constrained ? m_constraints[i].lower : -std::numeric_limits<double>::infinity();
+                m_upperBounds[i] = constrained ? m_constraints[i].upper : std::numeric_limits<double>::infinity();
+            }
+        }
+
+        /**
+         * Set number of threads used to generate and evaluate the population.
+         * For given random seed results are identical for any number of threads.
+         * When more than one thread is used the cost function must be safe to call concurrently.
+         *
+         * \param numberOfThreads Number of threads, 0 selects the number of hardware threads
+         */
+        void SetNumberOfThreads(unsigned int numberOfThreads)
+        {
+            if (numberOfThreads == 0)
+            {
+                numberOfThreads = std::max(1u, std::thread::hardware_concurrency());
+            }
+
+            if (numberOfThreads == 1)
+            {
+                m_threadPool.reset();
+            }
+            else if (!m_threadPool || m_threadPool->NumberOfThreads() != numberOfThreads)
+            {
+                m_threadPool.reset(new ThreadPool(numberOfThreads));
+            }
+
+            // Each thread builds donors in its own row and counts bound violations separately
+            m_donors.Resize(numberOfThreads, m_numberOfParameters);
+            BoundCounters counters = GetBoundCounters();
+            m_boundCounters.assign(numberOfThreads, BoundCounters());
+            m_boundCounters[0] = counters;
+
+            if (m_constrainedCost)
+            {
+                m_constraintValues.Resize(numberOfThreads, std::max(1u, m_numberOfConstraints));
+            }
+        }
+
+        unsigned int GetNumberOfThreads() const
+        {
+            return m_threadPool ? m_threadPool->NumberOfThreads() : 1;
+        }
+
+        /**
+         * Set distance in elements between consecutive agents of the population and trial matrices.
+         * Must be called before InitPopulation as the matrices are reallocated.
+         *
+         * \param stride Row stride, at least NumberOfParameters(). Zero selects the number of
+         * parameters rounded up to a whole number of cache lines (default).
+         */
+        void SetPopulationStride(std::size_t stride)
+        {
+            m_population.Resize(m_maxPopulationSize, m_numberOfParameters, stride);
+            m_trials.Resize(m_maxPopulationSize, m_numberOfParameters, stride);
+        }
+
+        std::size_t GetPopulationStride() const
+        {
+            return m_population.Stride();
+        }
+
+        /**
+         * Select instruction set of the mutation and crossover kernels. By default the best one
+         * supported by the machine is used. All levels give identical results.
+         */
+        void SetSimdLevel(SimdLevel level)
+        {
+            m_kernels = &GetSimdKernels(level);
+        }
+
+        SimdLevel GetSimdLevel() const
+        {
+            return m_kernels->level;
+        }
+
+        /**
+         * Select mutation and crossover strategy at runtime. Default is DE/rand/1/bin.
+         * The selected pair is dispatched once per generation to the matching compile time instantiation.
+         */
+        void SetStrategy(MutationStrategy mutation, CrossoverStrategy crossover)
+        {
+            switch (crossover)
+            {
+            case CrossoverStrategy::Binomial:
+                SetMutation<CrossoverBinomial>(mutation);
+                break;
+            case CrossoverStrategy::Exponential:
+                SetMutation<CrossoverExponential>(mutation);
+                break;
+            case CrossoverStrategy::Arithmetic:
+                SetMutation<CrossoverArithmetic>(mutation);
+                break;
+            }
+        }
+
+        /**
+         * Select mutation and crossover policies at compile time, user defined policies may be used.
+         */
+        template<typename Mutation, typename Crossover>
+        void SetStrategy()
+        {
+            assert(Mutation::minimumPopulationSize <= m_populationSize);
+            m_generation = &DifferentialEvolution::SelectionAndCorssing<Mutation, Crossover>;
+            m_asynchronousSteps = &DifferentialEvolution::AsynchronousSteps<Mutation, Crossover>;
+            m_minimumStrategyPopulationSize = Mutation::minimumPopulationSize;
+        }
+
+        /**
+         * Set fraction of the best agents from which current-to-pbest selects pbest (default 0.1).
+         */
+        void SetPBest(double p)
+        {
+            assert(p > 0.0 && p <= 1.0);
+            m_pBest = p;
+        }
+
+        /**
+         * Set mutation factor F (default 0.8). With adaptive control it sets the initial per agent
+         * values or means, call it after SetParameterControl.
+         */
+        void SetF(double F)
+        {
+            m_F = F;
+            std::fill(m_agentF.begin(), m_agentF.end(), F);
+            std::fill(m_trialF.begin(), m_trialF.end(), F);
+            std::fill(m_historyF.begin(), m_historyF.end(), F);
+        }
+
+        /**
+         * Set crossover rate CR (default 0.9). With adaptive control it sets the initial per agent
+         * values or means, call it after SetParameterControl.
+         */
+        void SetCR(double CR)
+        {
+            m_CR = CR;
+            std::fill(m_agentCR.begin(), m_agentCR.end(), CR);
+            std::fill(m_trialCR.begin(), m_trialCR.end(), CR);
+            std::fill(m_historyCR.begin(), m_historyCR.end(), CR);
+        }
+
+        /**
+         * Current F. For JADE it is the adapted mean, for SHADE the mean of the history memory
+         * and for jDE the initial per agent value.
+         */
+        double GetF() const
+        {
+            return m_F;
+        }
+
+        double GetCR() const
+        {
+            return m_CR;
+        }
+
+        /**
+         * Select how F and CR are controlled, see ParameterControl. Initial values are the ones
+         * recommended by the authors: F = 0.5, CR = 0.9 for jDE and means of 0.5 for JADE and SHADE.
+         *
+         * \param control Control mode
+         * \param historySize Number of entries of the SHADE success history memory
+         */
+        void SetParameterControl(ParameterControl control, unsigned int historySize = 6)
+        {
+            m_parameterControl = control;
+            m_historyF.resize(std::max(1u, historySize));
+            m_historyCR.resize(std::max(1u, historySize));
+            m_historyIndex = 0;
+
+            switch (control)
+            {
+            case ParameterControl::JDE:
+                SetF(0.5);
+                SetCR(0.9);
+                break;
+            case ParameterControl::JADE:
+            case ParameterControl::SHADE:
+                SetF(0.5);
+                SetCR(0.5);
+                break;
+            default:
+                SetF(m_F);
+                SetCR(m_CR);
+                break;
+            }
+
+            ResetSuccesses();
+        }
+
+        ParameterControl GetParameterControl() const
+        {
+            return m_parameterControl;
+        }
+
+        /**
+         * Linearly reduce the population from its initial size to minPopulationSize as the number of
+         * evaluations approaches maxEvaluations (L-SHADE style). After each generation the worst agents
+         * are dropped by compacting the population storage in place, no memory is allocated.
+         */
+        void SetPopulationSizeSchedule(unsigned int minPopulationSize, unsigned long long maxEvaluations)
+        {
+            const unsigned int maxPopulationSize = m_initialPopulationSize;
+            SetPopulationSizeSchedule([=](unsigned long long evaluations)
+            {
+                const double progress = std::min(1.0, static_cast<double>(evaluations) / maxEvaluations);
+                return static_cast<unsigned int>(std::lround(maxPopulationSize + (static_cast<double>(minPopulationSize) - maxPopulationSize) * progress));
+            });
+        }
+
+        /**
+         * Custom population size schedule. It is called after each generation with the number of
+         * evaluations so far and returns the desired population size. The population only shrinks and
+         * never below the size required by the mutation strategy. Schedules can not be combined with
+         * restarts, which set the population size themselves.
+         */
+        void SetPopulationSizeSchedule(std::function<unsigned int(unsigned long long)> schedule)
+        {
+            assert(!schedule || m_restartStrategy == RestartStrategy::None);
+
+            m_populationSizeSchedule = schedule;
+        }
+
+        /**
+         * Restart from a new random population whenever one of the convergence detectors fires,
+         * instead of stopping, so a population stuck in a local minimum does not waste the remaining
+         * budget. At least one detector must be enabled. The best agent of all runs is kept and returned
+         * by GetBestAgent and GetBestCost. Generation and evaluation counters continue over restarts.
+         *
+         * With IPOP every restart multiplies the population size by populationIncrease. BIPOP
+         * interleaves such runs with runs of small populations of random size, always continuing the
+         * regime which used fewer evaluations so far. Buffers for maxPopulationSize agents are allocated
+         * here, restarts do not allocate memory. Call it before InitPopulation. Restarts can not be
+         * combined with a population size schedule, it would shrink every restarted population.
+         *
+         * \param strategy Restart strategy, None disables restarts (default)
+         * \param maxPopulationSize Largest population of a restart, 0 for 8 times the initial size
+         * \param populationIncrease Growth factor of the population per large restart
+         */
+        void SetRestartStrategy(RestartStrategy strategy, unsigned int maxPopulationSize = 0, double populationIncrease = 2.0)
+        {
+            assert(populationIncrease >= 1.0);
+            assert(strategy == RestartStrategy::None || !m_populationSizeSchedule);
+
+            m_restartStrategy = strategy;
+            m_populationIncrease = populationIncrease;
+            if (strategy == RestartStrategy::None)
+            {
+                return;
+            }
+
+            if (maxPopulationSize == 0)
+            {
+                maxPopulationSize = 8 * m_initialPopulationSize;
+            }
+            if (maxPopulationSize > m_maxPopulationSize)
+            {
+                ReservePopulation(maxPopulationSize);
+            }
+        }
+
+        RestartStrategy GetRestartStrategy() const
+        {
+            return m_restartStrategy;
+        }
+
+        /**
+         * Number of restarts since the last InitPopulation.
+         */
+        unsigned int GetNumberOfRestarts() const
+        {
+            return m_numberOfRestarts;
+        }
+
+        /**
+         * Pre-screen trial vectors with a surrogate model before evaluating them. Trials not selected
+         * by screening are discarded without evaluation, at least one trial is evaluated per
+         * generation. Every evaluated agent is added to the surrogate. Pass nullptr to disable.
+         *
+         * \param surrogate Model owned by the caller, it must outlive the optimizer use
+         * \param screening Selection of the evaluated trials
+         * \param topK Number of trials evaluated with SurrogateScreening::TopK, 0 for half the population
+         */
+        void SetSurrogate(ISurrogate* surrogate, SurrogateScreening screening = SurrogateScreening::PredictedBetter, unsigned int topK = 0)
+        {
+            // Predicted costs can not be compared with constraint violations
+            assert(!surrogate || !m_constrainedCost);
+
+            m_surrogate = surrogate;
+            m_surrogateScreening = screening;
+            m_surrogateTopK = topK;
+        }
+
+        /**
+         * Number of trials discarded by surrogate screening without evaluation.
+         */
+        unsigned long long GetNumberOfScreenedTrials() const
+        {
+            return m_numberOfScreenedTrials;
+        }
+
+        /**
+         * Select comparison of agents of an IConstrainedOptimizable (default FeasibilityRules).
+         * With Epsilon the level decreases as epsilon0 * (1 - t / controlGenerations)^exponent in
+         * generation t and is zero afterwards. Call it before InitPopulation.
+         *
+         * \param handling Comparison of agents
+         * \param controlGenerations Number of generations until the epsilon level reaches zero
+         * \param exponent Exponent of the decrease
+         * \param quantile Epsilon0 is the violation of this quantile of the initial population
+         */
+        void SetConstraintHandling(ConstraintHandling handling, unsigned long long controlGenerations = 1000, double exponent = 5.0, double quantile = 0.2)
+        {
+            assert(quantile >= 0.0 && quantile <= 1.0);
+
+            m_constraintHandling = handling;
+            m_epsilonGenerations = controlGenerations;
+            m_epsilonExponent = exponent;
+            m_epsilonQuantile = quantile;
+        }
+
+        ConstraintHandling GetConstraintHandling() const
+        {
+            return m_constraintHandling;
+        }
+
+        /**
+         * Current epsilon level, violations up to it count as feasible. Zero with FeasibilityRules.
+         */
+        double GetEpsilonLevel() const
+        {
+            return m_epsilon;
+        }
+
+        /**
+         * Number of trials whose objective was not evaluated because they violate the constraints
+         * more than the epsilon level.
+         */
+        unsigned long long GetNumberOfSkippedEvaluations() const
+        {
+            return m_numberOfSkippedEvaluations;
+        }
+
+        /**
+         * Stop after maxEvaluations cost function evaluations, 0 for no limit. The last generation
+         * evaluates only the first trials within the budget, so results are deterministic.
+         */
+        void SetMaxEvaluations(unsigned long long maxEvaluations)
+        {
+            m_maxEvaluations = maxEvaluations;
+        }
+
+        /**
+         * Stop at the deadline, checked between single evaluations.
+         */
+        void SetDeadline(std::chrono::steady_clock::time_point deadline)
+        {
+            m_deadline = deadline;
+        }
+
+        /**
+         * Stop after the given time from now, checked between single evaluations.
+         */
+        void SetTimeLimit(std::chrono::steady_clock::duration limit)
+        {
+            m_deadline = std::chrono::steady_clock::now() + limit;
+        }
+
+        void ClearDeadline()
+        {
+            m_deadline = std::chrono::steady_clock::time_point::max();
+        }
+
+        /**
+         * Stop as soon as a feasible agent with cost at most target is evaluated. Minus infinity, the
+         * default, disables the criterion.
+         */
+        void SetTargetCost(double target)
+        {
+            m_targetCost = target;
+        }
+
+        /**
+         * Stop when the token becomes true, e.g. set from another thread. The token is owned by the
+         * caller, nullptr removes it.
+         */
+        void SetStopToken(const std::atomic<bool>* token)
+        {
+            m_stopToken = token;
+        }
+
+        /**
+         * Number of trials evaluated by one EvaluateBatch call between checks of the deadline, target
+         * cost and stop token, 1 by default. Larger batches let batched cost functions amortize their
+         * overhead, a stop then takes effect only after the batch in progress.
+         */
+        void SetStopCheckBatchSize(unsigned int batchSize)
+        {
+            m_stopCheckBatchSize = std::max(1u, batchSize);
+        }
+
+        /**
+         * Why the last Continue or Optimize call stopped. Safe to call from other threads.
+         *
+         * Deadline, target cost and stop token are checked between single evaluations, so the
+         * generation in progress is cut short: its remaining trials are not evaluated and lose the
+         * selection, and the best agent found so far is available immediately. Cost functions are
+         * then called with batches of SetStopCheckBatchSize agents, single agents by default. When
+         * SelectionAndCorssing is called directly, a
+         * stopped generation is recognized by a reason other than None.
+         */
+        StopReason GetStopReason() const
+        {
+            return m_stopReason.load();
+        }
+
+        /**
+         * Stop when the difference of the worst and the best cost in the population is at most
+         * threshold. Minus infinity, the default, disables the criterion.
+         */
+        void SetCostSpreadThreshold(double threshold)
+        {
+            m_costSpreadThreshold = threshold;
+        }
+
+        /**
+         * Stop when the standard deviation of the population is at most threshold in every parameter.
+         * Minus infinity, the default, disables the criterion.
+         */
+        void SetParameterSpreadThreshold(double threshold)
+        {
+            m_parameterSpreadThreshold = threshold;
+        }
+
+        /**
+         * Stop when the best cost has not improved for the given number of generations, 0 disables
+         * the criterion (default).
+         */
+        void SetStagnationGenerations(unsigned int generations)
+        {
+            m_stagnationGenerations = generations;
+        }
+
+        /**
+         * Stop when the best cost improved by less than rate relative to the best cost window
+         * generations ago. Minus infinity, the default, disables the criterion.
+         */
+        void SetImprovementRateThreshold(double rate, unsigned int window = 10)
+        {
+            assert(window > 0);
+
+            m_improvementRateThreshold = rate;
+            m_bestCostWindow.assign(window, std::numeric_limits<double>::infinity());
+            m_detectorGenerations = 0;
+        }
+
+        /**
+         * Worst minus best cost of the population.
+         */
+        double GetCostSpread() const
+        {
+            return m_minCostPerAgent[m_worstAgentIndex] - m_minCostPerAgent[m_bestAgentIndex];
+        }
+
+        /**
+         * Largest standard deviation of the population over the parameters.
+         */
+        double GetParameterSpread() const
+        {
+            double largest = 0.0;
+            for (unsigned int i = 0; i < m_numberOfParameters; i++)
+            {
+                largest = std::max(largest, m_parameterSquares[i]);
+            }
+            return std::sqrt(largest / m_populationSize);
+        }
+
+        unsigned long long GetGenerationsWithoutImprovement() const
+        {
+            return m_generationsWithoutImprovement;
+        }
+
+        /**
+         * Relative improvement of the best cost over the window of SetImprovementRateThreshold,
+         * infinity until the window is filled.
+         */
+        double GetImprovementRate() const
+        {
+            return m_improvementRate;
+        }
+
+        /**
+         * Add a receiver of per generation telemetry. The sink is owned by the caller and must outlive
+         * the optimizer use. Cost statistics and diversity are computed only while a sink is added or
+         * SetTelemetryStatistics(true) was called.
+         */
+        void AddTelemetrySink(ITelemetrySink* sink)
+        {
+            assert(sink);
+
+            m_telemetrySinks.push_back(sink);
+            m_collectStatistics = true;
+        }
+
+        void RemoveTelemetrySink(ITelemetrySink* sink)
+        {
+            m_telemetrySinks.erase(std::remove(m_telemetrySinks.begin(), m_telemetrySinks.end(), sink), m_telemetrySinks.end());
+        }
+
+        /**
+         * Compute cost statistics and diversity of the population each generation without a sink,
+         * e.g. to read them from the callback with GetTelemetry.
+         */
+        void SetTelemetryStatistics(bool collect)
+        {
+            m_collectStatistics = collect;
+        }
+
+        /**
+         * Telemetry of the last generation.
+         */
+        const GenerationTelemetry& GetTelemetry() const
+        {
+            return m_telemetry;
+        }
+
+        /**
+         * Select how trials violating the box constraints are handled when constraints are checked
+         * (default Reject).
+         */
+        void SetBoundHandling(BoundHandling handling)
+        {
+            m_boundHandling = handling;
+        }
+
+        BoundHandling GetBoundHandling() const
+        {
+            return m_boundHandling;
+        }
+
+        /**
+         * Number of trials rebuilt because they violated the bounds and number of trials repaired.
+         */
+        struct BoundCounters
+        {
+            BoundCounters() :
+                rejections(0),
+                repairs(0)
+            {
+
+            }
+
+            unsigned long long rejections;
+            unsigned long long repairs;
+
+            // Counters of different threads are kept on separate cache lines
+            char padding[g_cacheLineSize - 2 * sizeof(unsigned long long)];
+        };
+
+        BoundCounters GetBoundCounters() const
+        {
+            BoundCounters total;
+            for (const auto& counters : m_boundCounters)
+            {
+                total.rejections += counters.rejections;
+                total.repairs += counters.repairs;
+            }
+            return total;
+        }
+
+        /**
+         * Number of SelectionAndCorssing steps since the last InitPopulation.
+         */
+        unsigned long long GetNumberOfGenerations() const
+        {
+            return m_numberOfGenerations;
+        }
+
+        /**
+         * Number of cost function evaluations since the last InitPopulation.
+         */
+        unsigned long long GetNumberOfEvaluations() const
+        {
+            return m_evaluations;
+        }
+
+        void InitPopulation()
+        {
+            // Schedules and restarts may have changed the population of a previous run
+            m_populationSize = m_initialPopulationSize;
+            m_evaluations = 0;
+            m_numberOfGenerations = 0;
+            m_numberOfScreenedTrials = 0;
+            m_numberOfSkippedEvaluations = 0;
+            m_telemetry = GenerationTelemetry();
+            m_telemetryBoundCounters = GetBoundCounters();
+            m_stopReason = StopReason::None;
+            m_numberOfRestarts = 0;
+            m_largeRestarts = 0;
+            m_smallRegime = false;
+            m_regimeStartEvaluations = 0;
+            m_largeRegimeEvaluations = 0;
+            m_smallRegimeEvaluations = 0;
+            m_restartBestCost = std::numeric_limits<double>::infinity();
+            m_restartBestViolation = std::numeric_limits<double>::infinity();
+
+            SampleAgents(true);
+        }
+
+        /**
+         * Single optimization step with the strategy selected by SetStrategy.
+         */
+        void SelectionAndCorssing()
+        {
+            (this->*m_generation)();
+        }
+
+        /**
+         * Single optimization step with compile time mutation and crossover policies.
+         */
+        template<typename Mutation, typename Crossover>
+        void SelectionAndCorssing()
+        {
+            const auto start = std::chrono::steady_clock::now();
+            const unsigned long long evaluations = m_evaluations;
+            m_stopReason = StopReason::None;
+
+            UpdateEpsilonLevel();
+
+            StrategyContext context = MakeStrategyContext(Mutation::usesPBest);
+
+            // Build trial vectors for the whole population before evaluating any of them
+            auto buildTrials = [this, &context](std::size_t begin, std::size_t end, unsigned int threadIndex)
+            {
+                double* donor = m_donors.RowData(threadIndex);
+                for (std::size_t x = begin; x < end; x++)
+                {
+                    BuildTrial<Mutation, Crossover>(context, static_cast<unsigned int>(x), donor, m_boundCounters[threadIndex]);
+                }
+            };
+            ParallelFor(m_populationSize, g_generationGrain, buildTrials);
+
+            // Calculate costs of all trial vectors, of the promising ones with a surrogate or of the
+            // ones within the epsilon level with general constraints
+            const auto evaluationStart = std::chrono::steady_clock::now();
+            if (m_constrainedCost)
+            {
+                EvaluateTrialViolations(m_trialViolations.data());
+                EvaluateFeasibleTrials(m_trialViolations.data(), m_trialCosts.data());
+            }
+            else if (m_surrogate)
+            {
+                EvaluateScreenedTrials();
+            }
+            else
+            {
+                EvaluateTrials(m_trialCosts.data());
+            }
+            const auto evaluationEnd = std::chrono::steady_clock::now();
+
+            if (m_maxEvaluations > 0 && m_evaluations >= m_maxEvaluations)
+            {
+                Stop(StopReason::MaxEvaluations);
+            }
+
+            unsigned int bestAgentIndex = 0;
+            unsigned int replacements = 0;
+            bool worstAgentReplaced = false;
+
+            for (unsigned int x = 0; x < m_populationSize; x++)
+            {
+                // Decide should the trial vector be kept.
+                if (IsBetter(m_trialCosts[x], m_trialViolations[x], m_minCostPerAgent[x], m_violationPerAgent[x]))
+                {
+                    RecordSuccess(x, Improvement(m_trialCosts[x], m_trialViolations[x], m_minCostPerAgent[x], m_violationPerAgent[x]));
+
+                    UpdatePopulationStatistics(m_population.RowData(x), m_trials.RowData(x));
+                    m_population.CopyRow(x, m_trials.RowData(x));
+                    m_minCostPerAgent[x] = m_trialCosts[x];
+                    m_violationPerAgent[x] = m_trialViolations[x];
+                    replacements++;
+
+                    // Under the epsilon level a replacement may also increase the cost
+                    worstAgentReplaced = worstAgentReplaced || x == m_worstAgentIndex || m_minCostPerAgent[x] > m_minCostPerAgent[m_worstAgentIndex];
+                }
+
+                // Track the global best agent.
+                if (IsAgentBetter(x, bestAgentIndex))
+                {
+                    bestAgentIndex = x;
+                }
+            }
+
+            m_minCost = m_minCostPerAgent[bestAgentIndex];
+            m_bestAgentIndex = bestAgentIndex;
+            if (worstAgentReplaced)
+            {
+                FindWorstAgent();
+            }
+
+            UpdateParameterControl();
+            ApplyPopulationSizeSchedule();
+
+            m_numberOfGenerations++;
+            UpdateConvergenceDetectors();
+            if (m_checkpointWriter && m_numberOfGenerations % m_checkpointInterval == 0)
+            {
+                SerializeState(m_checkpointBuffer);
+                m_checkpointWriter->Submit(m_checkpointBuffer);
+            }
+
+            const std::chrono::duration<double> total = std::chrono::steady_clock::now() - start;
+            const std::chrono::duration<double> evaluation = evaluationEnd - evaluationStart;
+            m_telemetry.evaluationSeconds = evaluation.count();
+            m_telemetry.overheadSeconds = total.count() - evaluation.count();
+            m_telemetry.evaluations = m_evaluations - evaluations;
+            m_telemetry.replacements = replacements;
+            PublishTelemetry();
+        }
+
+        /**
+         * Asynchronous steady-state optimization with the strategy selected by SetStrategy.
+         *
+         * Every thread repeatedly takes the next target agent, builds a trial from the current
+         * population, evaluates it and replaces the target if the trial is better. There is no barrier
+         * between generations, so threads never wait for a slow evaluation of another thread. Returns
+         * after the given number of evaluations. Call InitPopulation first.
+         *
+         * Results depend on thread timing and are not repeatable with more than one thread. F and CR set
+         * by SetF and SetCR are used, adaptive parameter control and population size schedules apply to
+         * SelectionAndCorssing only.
+         */
+        void AsynchronousSteps(unsigned long long evaluations)
+        {
+            (this->*m_asynchronousSteps)(evaluations);
+        }
+
+        /**
+         * Asynchronous steady-state optimization with compile time mutation and crossover policies.
+         */
+        template<typename Mutation, typename Crossover>
+        void AsynchronousSteps(unsigned long long evaluations)
+        {
+            // Rows are replaced by cost only
+            assert(!m_constrainedCost);
+
+            const unsigned int numberOfWorkers = GetNumberOfThreads();
+            if (m_asyncWorkers.size() != numberOfWorkers)
+            {
+                m_asyncWorkers.clear();
+                m_asyncWorkers.resize(numberOfWorkers);
+            }
+
+            // Threads exchange rows through the atomic copy of the population, m_population is only
+            // read until all threads finished
+            for (unsigned int x = 0; x < m_populationSize; x++)
+            {
+                StoreSharedRow(x, m_population.RowData(x), m_minCostPerAgent[x]);
+            }
+
+            for (unsigned int w = 0; w < numberOfWorkers; w++)
+            {
+                AsyncWorker& worker = m_asyncWorkers[w];
+                worker.Reset(this, m_maxPopulationSize, m_numberOfParameters, static_cast<std::uint64_t>(m_randomSeed), w);
+                for (unsigned int x = 0; x < m_populationSize; x++)
+                {
+                    worker.versions[x] = m_rowVersions[x].load(std::memory_order_relaxed);
+                }
+            }
+
+            evaluations = std::min(evaluations, RemainingEvaluations());
+            const bool checkStop = ChecksStopBetweenEvaluations();
+            m_evaluatedTrials = 0;
+            m_stopReason = StopReason::None;
+
+            std::atomic<unsigned long long> nextTicket(0);
+            std::atomic<unsigned int> bestAgentIndex(m_bestAgentIndex);
+            std::atomic<double> bestCost(m_minCostPerAgent[m_bestAgentIndex]);
+
+            auto work = [&](std::size_t begin, std::size_t, unsigned int)
+            {
+                AsyncWorker& worker = m_asyncWorkers[begin];
+
+                try
+                {
+                    // Full snapshot once, afterwards only the rows read by a trial are refreshed
+                    for (unsigned int x = 0; x < m_populationSize; x++)
+                    {
+                        worker.population.CopyRow(x, m_population.RowData(x));
+                        worker.costs[x] = m_minCostPerAgent[x];
+                    }
+                    if (Mutation::usesPBest)
+                    {
+                        RankSnapshot(worker);
+                    }
+
+                    StrategyContext context;
+                    context.population = &worker.population;
+                    context.populationSize = m_populationSize;
+                    context.numberOfParameters = m_numberOfParameters;
+                    context.pBestAgents = worker.rankedAgents.data();
+                    context.numberOfPBestAgents = worker.numberOfRankedAgents;
+                    context.F = m_F;
+                    context.CR = m_CR;
+                    context.kernels = m_kernels;
+                    context.refreshRow = &DifferentialEvolution::RefreshSnapshotRow;
+                    context.snapshot = &worker;
+
+                    for (unsigned long long ticket = nextTicket++; ticket < evaluations; ticket = nextTicket++)
+                    {
+                        if (checkStop && ShouldStop())
+                        {
+                            break;
+                        }
+
+                        const unsigned int x = static_cast<unsigned int>(ticket % m_populationSize);
+
+                        context.best = bestAgentIndex.load(std::memory_order_relaxed);
+                        if (Mutation::usesPBest)
+                        {
+                            // Offers the current best agent to the ranking
+                            RefreshRow(worker, context.best);
+                        }
+
+                        double* donor = worker.buffers.RowData(0);
+                        double* trial = worker.buffers.RowData(1);
+                        unsigned int attempts = 0;
+                        while (true)
+                        {
+                            TrialBuilder<Mutation, Crossover>::Build(context, x, worker.generator, donor, trial);
+                            if (EnforceBounds(trial, context.Row(x), worker.generator, attempts, worker.boundCounters))
+                            {
+                                break;
+                            }
+                        }
+
+                        const double cost = m_cost.EvaluateCost(trial, m_numberOfParameters);
+                        m_evaluatedTrials.fetch_add(1, std::memory_order_relaxed);
+                        if (cost <= m_targetCost)
+                        {
+                            Stop(StopReason::TargetCost);
+                        }
+
+                        if (CommitIfBetter(x, trial, cost))
+                        {
+                            double currentBest = bestCost.load(std::memory_order_relaxed);
+                            while (cost < currentBest)
+                            {
+                                if (bestCost.compare_exchange_weak(currentBest, cost))
+                                {
+                                    bestAgentIndex.store(x, std::memory_order_relaxed);
+                                    break;
+                                }
+                            }
+                        }
+                    }
+                }
+                catch (...)
+                {
+                    // Let the other threads finish early
+                    nextTicket.store(evaluations);
+                    throw;
+                }
+            };
+            ParallelFor(numberOfWorkers, 1, work);
+
+            for (unsigned int x = 0; x < m_populationSize; x++)
+            {
+                const std::atomic<double>* row = &m_sharedPopulation[static_cast<std::size_t>(x) * m_numberOfParameters];
+                double* agent = m_population.RowData(x);
+                for (unsigned int i = 0; i < m_numberOfParameters; i++)
+                {
+                    agent[i] = row[i].load(std::memory_order_relaxed);
+                }
+                m_minCostPerAgent[x] = m_sharedCosts[x].load(std::memory_order_relaxed);
+            }
+
+            m_evaluations += m_evaluatedTrials;
+
+            // The run was shortened to the remaining budget
+            if (m_maxEvaluations > 0 && m_evaluations >= m_maxEvaluations)
+            {
+                Stop(StopReason::MaxEvaluations);
+            }
+
+            for (const auto& worker : m_asyncWorkers)
+            {
+                m_boundCounters[0].rejections += worker.boundCounters.rejections;
+                m_boundCounters[0].repairs += worker.boundCounters.repairs;
+            }
+
+            // Concurrent best updates may race, so the best agent is found again exactly
+            FindBestAgent();
+            ResetPopulationStatistics();
+        }
+
+        /**
+         * Serialize the optimizer state into bytes: population, costs, best agent, generation,
+         * evaluation, screened trial, skipped evaluation and bound handling counters, random streams,
+         * adaptive control parameters, the restart state and the convergence detector history. Configuration such as the strategy, constraints handling,
+         * schedules or restarts is not stored and must be set up the same way before restoring. The
+         * buffer is reused, so repeated calls do not allocate.
+         */
+        void SaveState(std::vector<char>& bytes) const
+        {
+            SerializeState(bytes);
+            checkpoint::Seal(bytes);
+        }
+
+        /**
+         * Restore a state written by SaveState. Returns false and leaves the optimizer unchanged if the
+         * data is corrupted, has another version or belongs to a problem of another dimension, population
+         * size or improvement rate window. Optimization continues bit-identically to the run that saved
+         * the state. The archive of a surrogate set by SetSurrogate is not part of the state, screening
+         * only continues identically if the caller restores the surrogate as well.
+         */
+        bool RestoreState(const char* bytes, std::size_t size)
+        {
+            CheckpointHeader header;
+            if (size < sizeof(header))
+            {
+                return false;
+            }
+            std::memcpy(&header, bytes, sizeof(header));
+            if (std::memcmp(header.magic, checkpoint::g_magic, sizeof(header.magic)) != 0 || header.version != CheckpointHeader::g_version ||
+                header.headerSize != sizeof(header) || header.engineSize != sizeof(RandomEngine) ||
+                header.payloadSize != size - sizeof(header))
+            {
+                return false;
+            }
+
+            const char* payload = bytes + sizeof(header);
+            if (header.checksum != checkpoint::Crc32(payload, static_cast<std::size_t>(header.payloadSize)))
+            {
+                return false;
+            }
+
+            std::size_t offset = 0;
+            std::uint32_t numberOfParameters, maxPopulationSize, populationSize, bestAgentIndex, worstAgentIndex, parameterControl, historySize, windowSize;
+            std::uint64_t historyIndex, numberOfGenerations, evaluations;
+            checkpoint::Read(payload, offset, &numberOfParameters, sizeof(numberOfParameters));
+            checkpoint::Read(payload, offset, &maxPopulationSize, sizeof(maxPopulationSize));
+            checkpoint::Read(payload, offset, &populationSize, sizeof(populationSize));
+            checkpoint::Read(payload, offset, &bestAgentIndex, sizeof(bestAgentIndex));
+            checkpoint::Read(payload, offset, &worstAgentIndex, sizeof(worstAgentIndex));
+            checkpoint::Read(payload, offset, &parameterControl, sizeof(parameterControl));
+            checkpoint::Read(payload, offset, &historySize, sizeof(historySize));
+            checkpoint::Read(payload, offset, &windowSize, sizeof(windowSize));
+            checkpoint::Read(payload, offset, &historyIndex, sizeof(historyIndex));
+            checkpoint::Read(payload, offset, &numberOfGenerations, sizeof(numberOfGenerations));
+            checkpoint::Read(payload, offset, &evaluations, sizeof(evaluations));
+
+            if (numberOfParameters != m_numberOfParameters || maxPopulationSize != m_maxPopulationSize ||
+                populationSize > maxPopulationSize || bestAgentIndex >= populationSize || worstAgentIndex >= populationSize ||
+                windowSize != m_bestCostWindow.size() ||
+                (historySize == 0 ? historyIndex != 0 : historyIndex >= historySize) ||
+                parameterControl > static_cast<std::uint32_t>(ParameterControl::SHADE) ||
+                header.payloadSize != StatePayloadSize(numberOfParameters, maxPopulationSize, populationSize, historySize, windowSize))
+            {
+                return false;
+            }
+
+
+            m_populationSize = populationSize;
+            m_bestAgentIndex = bestAgentIndex;
+            m_parameterControl = static_cast<ParameterControl>(parameterControl);
+            m_historyIndex = static_cast<std::size_t>(historyIndex);
+            m_numberOfGenerations = numberOfGenerations;
+            m_evaluations = evaluations;
+            m_historyF.resize(historySize);
+            m_historyCR.resize(historySize);
+
+            checkpoint::Read(payload, offset, &m_minCost, sizeof(m_minCost));
+            checkpoint::Read(payload, offset, &m_F, sizeof(m_F));
+            checkpoint::Read(payload, offset, &m_CR, sizeof(m_CR));
+            checkpoint::Read(payload, offset, &m_initialEpsilon, sizeof(m_initialEpsilon));
+            checkpoint::Read(payload, offset, m_agentGenerators.data(), maxPopulationSize * sizeof(RandomEngine));
+            for (unsigned int x = 0; x < m_populationSize; x++)
+            {
+                checkpoint::Read(payload, offset, m_population.RowData(x), numberOfParameters * sizeof(double));
+            }
+            checkpoint::Read(payload, offset, m_minCostPerAgent.data(), populationSize * sizeof(double));
+            checkpoint::Read(payload, offset, m_violationPerAgent.data(), populationSize * sizeof(double));
+            checkpoint::Read(payload, offset, m_agentF.data(), maxPopulationSize * sizeof(double));
+            checkpoint::Read(payload, offset, m_agentCR.data(), maxPopulationSize * sizeof(double));
+            checkpoint::Read(payload, offset, m_historyF.data(), historySize * sizeof(double));
+            checkpoint::Read(payload, offset, m_historyCR.data(), historySize * sizeof(double));
+
+            std::uint32_t numberOfRestarts, largeRestarts, smallRegime;
+            std::uint64_t regimeEvaluations[3];
+            checkpoint::Read(payload, offset, &numberOfRestarts, sizeof(numberOfRestarts));
+            checkpoint::Read(payload, offset, &largeRestarts, sizeof(largeRestarts));
+            checkpoint::Read(payload, offset, &smallRegime, sizeof(smallRegime));
+            checkpoint::Read(payload, offset, regimeEvaluations, sizeof(regimeEvaluations));
+            checkpoint::Read(payload, offset, &m_restartGenerator, sizeof(m_restartGenerator));
+            checkpoint::Read(payload, offset, &m_restartBestCost, sizeof(m_restartBestCost));
+            checkpoint::Read(payload, offset, &m_restartBestViolation, sizeof(m_restartBestViolation));
+            checkpoint::Read(payload, offset, m_restartBest.data(), numberOfParameters * sizeof(double));
+            m_numberOfRestarts = numberOfRestarts;
+            m_largeRestarts = largeRestarts;
+            m_smallRegime = smallRegime != 0;
+            m_regimeStartEvaluations = regimeEvaluations[0];
+            m_largeRegimeEvaluations = regimeEvaluations[1];
+            m_smallRegimeEvaluations = regimeEvaluations[2];
+
+            std::uint64_t counters[4];
+            checkpoint::Read(payload, offset, counters, sizeof(counters));
+            m_numberOfScreenedTrials = counters[0];
+            m_numberOfSkippedEvaluations = counters[1];
+            std::fill(m_boundCounters.begin(), m_boundCounters.end(), BoundCounters());
+            m_boundCounters[0].rejections = counters[2];
+            m_boundCounters[0].repairs = counters[3];
+            m_telemetryBoundCounters = m_boundCounters[0];
+
+            std::uint64_t detectorCounters[2];
+            checkpoint::Read(payload, offset, detectorCounters, sizeof(detectorCounters));
+            checkpoint::Read(payload, offset, &m_lastBestCost, sizeof(m_lastBestCost));
+            checkpoint::Read(payload, offset, &m_improvementRate, sizeof(m_improvementRate));
+            checkpoint::Read(payload, offset, m_parameterMeans.data(), numberOfParameters * sizeof(double));
+            checkpoint::Read(payload, offset, m_parameterSquares.data(), numberOfParameters * sizeof(double));
+            checkpoint::Read(payload, offset, m_bestCostWindow.data(), windowSize * sizeof(double));
+            m_worstAgentIndex = worstAgentIndex;
+            m_generationsWithoutImprovement = detectorCounters[0];
+            m_detectorGenerations = detectorCounters[1];
+
+            // Level of the last completed generation, the next one updates it as in the saved run
+            m_epsilon = EpsilonLevel(numberOfGenerations > 0 ? numberOfGenerations - 1 : 0);
+
+            ResetSuccesses();
+            return true;
+        }
+
+        /**
+         * Write the state to a checkpoint file synchronously. Returns false if writing failed.
+         */
+        bool SaveCheckpoint(const std::string& path) const
+        {
+            std::vector<char> bytes;
+            SerializeState(bytes);
+            return checkpoint::WriteFile(path, bytes);
+        }
+
+        /**
+         * Restore the state from a checkpoint file, which is memory mapped for reading. Returns false
+         * if the file does not exist or is not a valid checkpoint of this problem.
+         */
+        bool LoadCheckpoint(const std::string& path)
+        {
+            checkpoint::MappedFile file(path);
+            return file.Data() && RestoreState(file.Data(), file.Size());
+        }
+
+        /**
+         * Write a checkpoint every interval generations from a background thread. The optimizer only
+         * copies its state into a buffer, checksum and file output do not block optimization.
+         * Empty path or zero interval disables checkpointing.
+         */
+        void SetCheckpointing(const std::string& path, unsigned int interval)
+        {
+            m_checkpointWriter.reset();
+            m_checkpointInterval = interval;
+            if (!path.empty() && interval > 0)
+            {
+                m_checkpointWriter.reset(new CheckpointWriter(path));
+            }
+        }
+
+        /**
+         * Wait for the background checkpoint writes. Returns false if any of them failed.
+         */
+        bool FlushCheckpoints()
+        {
+            return !m_checkpointWriter || m_checkpointWriter->Flush();
+        }
+
+        /**
+         * Best agent found, with restarts also in the previous runs.
+         */
+        std::vector<double> GetBestAgent() const
+        {
+            return GetBestAgentView().ToVector();
+        }
+
+        /**
+         * Non-owning view of the best agent. It is valid until the next optimization step.
+         */
+        ConstAgentView GetBestAgentView() const
+        {
+            return IsRestartBestBetter() ? ConstAgentView(m_restartBest.data(), m_numberOfParameters) : m_population.Row(m_bestAgentIndex);
+        }
+
+        ConstAgentView GetAgent(unsigned int index) const
+        {
+            return m_population.Row(index);
+        }
+
+        double GetAgentCost(unsigned int index) const
+        {
+            return m_minCostPerAgent[index];
+        }
+
+        /**
+         * Total constraint violation of the agent, zero for feasible agents and cost functions
+         * without general constraints.
+         */
+        double GetAgentViolation(unsigned int index) const
+        {
+            return m_violationPerAgent[index];
+        }
+
+        /**
+         * Compare two agents given by cost and total constraint violation the way selection does.
+         * Violations up to the epsilon level count as zero, without general constraints agents are
+         * compared by cost.
+         */
+        bool IsBetter(double cost, double violation, double otherCost, double otherViolation) const
+        {
+            return IsBetterByFeasibility(cost, violation <= m_epsilon ? 0.0 : violation,
+                                         otherCost, otherViolation <= m_epsilon ? 0.0 : otherViolation);
+        }
+
+        bool IsAgentBetter(unsigned int x, unsigned int y) const
+        {
+            return IsBetter(m_minCostPerAgent[x], m_violationPerAgent[x], m_minCostPerAgent[y], m_violationPerAgent[y]);
+        }
+
+        /**
+         * Replace agent at index with the given parameters and known cost, used for migration between
+         * populations. Best agent is updated accordingly. Violation of general constraints is evaluated.
+         */
+        void ReplaceAgent(unsigned int index, const double* agent, double cost)
+        {
+            ReplaceAgent(index, agent, cost, m_constrainedCost ? EvaluateViolation(agent, m_constraintValues.RowData(0)) : 0.0);
+        }
+
+        /**
+         * Replace agent at index with the given parameters, known cost and known total constraint violation.
+         */
+        void ReplaceAgent(unsigned int index, const double* agent, double cost, double violation)
+        {
+            assert(index < m_populationSize);
+
+            UpdatePopulationStatistics(m_population.RowData(index), agent);
+            m_population.CopyRow(index, agent);
+            m_minCostPerAgent[index] = cost;
+            m_violationPerAgent[index] = violation;
+
+            if (index == m_worstAgentIndex || cost > m_minCostPerAgent[m_worstAgentIndex])
+            {
+                FindWorstAgent();
+            }
+
+            if (IsAgentBetter(index, m_bestAgentIndex))
+            {
+                m_minCost = cost;
+                m_bestAgentIndex = index;
+            }
+            else if (index == m_bestAgentIndex)
+            {
+                FindBestAgent();
+            }
+        }
+
+        /**
+         * Index of the best agent of the current population.
+         */
+        unsigned int GetBestAgentIndex() const
+        {
+            return m_bestAgentIndex;
+        }
+
+        unsigned int GetPopulationSize() const
+        {
+            return m_populationSize;
+        }
+
+        /**
+         * Largest population the buffers are allocated for, restarts grow the population up to it.
+         */
+        unsigned int GetMaxPopulationSize() const
+        {
+            return m_maxPopulationSize;
+        }
+
+        /**
+         * Population matrix, one agent per row. Useful for zero-copy access to the whole population.
+         */
+        const AlignedMatrix& GetPopulation() const
+        {
+            return m_population;
+        }
+
+        double GetBestCost() const
+        {
+            return IsRestartBestBetter() ? m_restartBestCost : m_minCostPerAgent[m_bestAgentIndex];
+        }
+
+        double GetBestViolation() const
+        {
+            return IsRestartBestBetter() ? m_restartBestViolation : m_violationPerAgent[m_bestAgentIndex];
+        }
+
+        std::vector<std::pair<std::vector<double>, double>> GetPopulationWithCosts() const
+        {
+            std::vector<std::pair<std::vector<double>, double>> toRet;
+            for (unsigned int i = 0; i < m_populationSize; i++)
+            {
+                toRet.push_back(std::make_pair(m_population.Row(i).ToVector(), m_minCostPerAgent[i]));
+            }
+
+            return toRet;
+        }
+
+        void PrintPopulation() const
+        {
+            for (unsigned int i = 0; i < m_populationSize; i++)
+            {
+                for (auto& var : m_population.Row(i))
+                {
+                    std::cout << var << " ";
+                }
+                std::cout << std::endl;
+            }
+        }
+
+        /**
+         * Initialize the population and run the given number of iterations, see Continue.
+         *
+         * With a deadline, target cost or stop token set, the cost function is called with batches of
+         * SetStopCheckBatchSize trials, single trials by default, so the stop is checked between them.
+         * Cost functions with a large per call overhead should set a larger batch size.
+         */
+        void Optimize(int iterations, bool verbose = true)
+        {
+            InitPopulation();
+            Continue(iterations, verbose);
+        }
+
+        /**
+         * Run more optimization iterations from the current state, e.g. after LoadCheckpoint.
+         */
+        void Continue(int iterations, bool verbose = true)
+        {
+            // Stop criteria are checked again, e.g. a continued run may have a new deadline
+            m_stopReason = StopReason::None;
+
+            // Optimization loop
+            for (int i = 0; i < iterations; i++)
+            {
+                if (ShouldStopBeforeGeneration())
+                {
+                    break;
+                }
+
+                // Optimization step
+                SelectionAndCorssing();
+
+                if (verbose)
+                {
+                    // Lines are not flushed one by one, console output would dominate fast runs
+                    std::cout << std::fixed << std::setprecision(5);
+                    std::cout << "Current minimal cost: " << GetBestCost() << "\t\t";
+                    std::cout << "Best agent: ";
+                    for (double value : GetBestAgentView())
+                    {
+                        std::cout << value << " ";
+                    }
+                    std::cout << '\n';
+                }
+
+                if (m_callback)
+                {
+                    m_callback(*this);
+                }
+
+                if (m_stopReason.load() != StopReason::None)
+                {
+                    break;
+                }
+
+                if (m_terminationCondition)
+                {
+                    if (m_terminationCondition(*this))
+                    {
+                        Stop(StopReason::TerminationCondition);
+                        break;
+                    }
+                }
+            }
+
+            if (m_stopReason.load() == StopReason::None)
+            {
+                Stop(StopReason::Generations);
+            }
+
+            if (verbose)
+            {
+                switch (m_stopReason.load())
+                {
+                case StopReason::TerminationCondition:
+                    std::cout << "Terminated due to positive evaluation of the termination condition." << std::endl;
+                    break;
+                case StopReason::MaxEvaluations:
+                    std::cout << "Terminated due to exceeding the maximal number of evaluations." << std::endl;
+                    break;
+                case StopReason::Deadline:
+                    std::cout << "Terminated due to reaching the deadline." << std::endl;
+                    break;
+                case StopReason::TargetCost:
+                    std::cout << "Terminated due to reaching the target cost." << std::endl;
+                    break;
+                case StopReason::StopToken:
+                    std::cout << "Terminated due to the stop token." << std::endl;
+                    break;
+                case StopReason::CostSpread:
+                case StopReason::ParameterSpread:
+                case StopReason::Stagnation:
+                case StopReason::ImprovementRate:
+                    std::cout << "Terminated due to convergence of the population." << std::endl;
+                    break;
+                default:
+                    std::cout << "Terminated due to exceeding total number of generations." << std::endl;
+                    break;
+                }
+            }
+        }
+
+    private:
+        template<typename Crossover>
+        void SetMutation(MutationStrategy mutation)
+        {
+            switch (mutation)
+            {
+            case MutationStrategy::Rand1:
+                SetStrategy<MutationRand1, Crossover>();
+                break;
+            case MutationStrategy::Rand2:
+                SetStrategy<MutationRand2, Crossover>();
+                break;
+            case MutationStrategy::Best1:
+                SetStrategy<MutationBest1, Crossover>();
+                break;
+            case MutationStrategy::Best2:
+                SetStrategy<MutationBest2, Crossover>();
+                break;
+            case MutationStrategy::CurrentToBest1:
+                SetStrategy<MutationCurrentToBest1, Crossover>();
+                break;
+            case MutationStrategy::CurrentToPBest1:
+                SetStrategy<MutationCurrentToPBest1, Crossover>();
+                break;
+            case MutationStrategy::RandToBest2:
+                SetStrategy<MutationRandToBest2, Crossover>();
+                break;
+            }
+        }
+
+        /**
+         * Sample F and CR used by the trial of agent x from the agent's random stream.
+         */
+        void SampleControlParameters(unsigned int x, RandomEngine& generator)
+        {
+            switch (m_parameterControl)
+            {
+            case ParameterControl::JDE:
+                m_trialF[x] = UniformReal(generator) < g_jdeTau ? 0.1 + 0.9 * UniformReal(generator) : m_agentF[x];
+                m_trialCR[x] = UniformReal(generator) < g_jdeTau ? UniformReal(generator) : m_agentCR[x];
+                break;
+            case ParameterControl::JADE:
+                m_trialF[x] = SampleCauchyF(generator, m_F);
+                m_trialCR[x] = std::min(1.0, std::max(0.0, NormalReal(generator, m_CR, 0.1)));
+                break;
+            case ParameterControl::SHADE:
+            {
+                const unsigned int r = UniformIndex(generator, static_cast<std::uint32_t>(m_historyF.size()));
+                m_trialF[x] = SampleCauchyF(generator, m_historyF[r]);
+                m_trialCR[x] = std::min(1.0, std::max(0.0, NormalReal(generator, m_historyCR[r], 0.1)));
+                break;
+            }
+            default:
+                break;
+            }
+        }
+
+        static double SampleCauchyF(RandomEngine& generator, double location)
+        {
+            // Non-positive values are regenerated and values above one truncated
+            double F = 0.0;
+            while (F <= 0.0)
+            {
+                F = CauchyReal(generator, location, 0.1);
+            }
+            return std::min(F, 1.0);
+        }
+
+        /**
+         * Collect F and CR of a successful trial, called from the selection step.
+         */
+        void RecordSuccess(unsigned int x, double improvement)
+        {
+            if (m_parameterControl == ParameterControl::Fixed)
+            {
+                return;
+            }
+
+            const double F = m_trialF[x];
+            const double CR = m_trialCR[x];
+
+            if (m_parameterControl == ParameterControl::JDE)
+            {
+                m_agentF[x] = F;
+                m_agentCR[x] = CR;
+                return;
+            }
+
+            // JADE uses plain means, SHADE weights successes by the cost improvement
+            double weight = 1.0;
+            if (m_parameterControl == ParameterControl::SHADE && std::isfinite(improvement))
+            {
+                weight = improvement;
+            }
+
+            m_successWeight += weight;
+            m_successCR += weight * CR;
+            m_successF += weight * F;
+            m_successF2 += weight * F * F;
+            m_numberOfSuccesses++;
+        }
+
+        void UpdateParameterControl()
+        {
+            if (m_numberOfSuccesses > 0 && m_successWeight > 0.0 && m_successF > 0.0)
+            {
+                const double meanCR = m_successCR / m_successWeight;
+                const double lehmerF = m_successF2 / m_successF;
+
+                if (m_parameterControl == ParameterControl::JADE)
+                {
+                    m_CR = (1.0 - g_jadeRate) * m_CR + g_jadeRate * meanCR;
+                    m_F = (1.0 - g_jadeRate) * m_F + g_jadeRate * lehmerF;
+                }
+                else if (m_parameterControl == ParameterControl::SHADE)
+                {
+                    m_historyCR[m_historyIndex] = meanCR;
+                    m_historyF[m_historyIndex] = lehmerF;
+                    m_historyIndex = (m_historyIndex + 1) % m_historyF.size();
+
+                    double sumF = 0.0;
+                    double sumCR = 0.0;
+                    for (std::size_t k = 0; k < m_historyF.size(); k++)
+                    {
+                        sumF += m_historyF[k];
+                        sumCR += m_historyCR[k];
+                    }
+                    m_F = sumF / m_historyF.size();
+                    m_CR = sumCR / m_historyCR.size();
+                }
+            }
+
+            ResetSuccesses();
+        }
+
+        void ResetSuccesses()
+        {
+            m_successWeight = 0.0;
+            m_successCR = 0.0;
+            m_successF = 0.0;
+            m_successF2 = 0.0;
+            m_numberOfSuccesses = 0;
+        }
+
+        StrategyContext MakeStrategyContext(bool usesPBest)
+        {
+            StrategyContext context;
+            context.population = &m_population;
+            context.populationSize = m_populationSize;
+            context.numberOfParameters = m_numberOfParameters;
+            context.best = m_bestAgentIndex;
+            context.pBestAgents = m_rankedAgents.data();
+            context.numberOfPBestAgents = 0;
+            context.F = m_F;
+            context.CR = m_CR;
+            context.kernels = m_kernels;
+            context.refreshRow = nullptr;
+            context.snapshot = nullptr;
+
+            if (usesPBest)
+            {
+                // Move the p best agents to the front of the ranking
+                unsigned int count = static_cast<unsigned int>(m_pBest * m_populationSize + 0.5);
+                count = std::max(1u, std::min(count, m_populationSize));
+
+                for (unsigned int i = 0; i < m_populationSize; i++)
+                {
+                    m_rankedAgents[i] = i;
+                }
+                std::nth_element(m_rankedAgents.begin(), m_rankedAgents.begin() + (count - 1), m_rankedAgents.begin() + m_populationSize,
+                    [this](std::uint32_t left, std::uint32_t right)
+                    {
+                        return IsAgentBetter(left, right) || (!IsAgentBetter(right, left) && left < right);
+                    });
+
+                context.numberOfPBestAgents = count;
+            }
+
+            return context;
+        }
+
+        /**
+         * Build trial vector for agent x into its row of m_trials using the agent's own random stream.
+         * No memory is allocated so the generation loop is allocation free after construction.
+         */
+        template<typename Mutation, typename Crossover>
+        void BuildTrial(const StrategyContext& context, unsigned int x, double* donor, BoundCounters& counters)
+        {
+            RandomEngine& generator = m_agentGenerators[x];
+            double* newX = m_trials.RowData(x);
+
+            StrategyContext agentContext = context;
+            if (m_parameterControl != ParameterControl::Fixed)
+            {
+                SampleControlParameters(x, generator);
+                agentContext.F = m_trialF[x];
+                agentContext.CR = m_trialCR[x];
+            }
+
+            unsigned int attempts = 0;
+            while (true)
+            {
+                TrialBuilder<Mutation, Crossover>::Build(agentContext, x, generator, donor, newX);
+
+                if (EnforceBounds(newX, m_population.RowData(x), generator, attempts, counters))
+                {
+                    return;
+                }
+            }
+        }
+
+        /**
+         * Check the trial against the box constraints and repair it according to the bound handling.
+         * Returns false if the trial is rejected and has to be built again.
+         */
+        template<typename Engine>
+        bool EnforceBounds(double* trial, const double* parent, Engine& engine, unsigned int& attempts, BoundCounters& counters)
+        {
+            if (!m_shouldCheckConstraints || CheckConstraints(trial))
+            {
+                return true;
+            }
+
+            BoundHandling handling = m_boundHandling;
+            if (handling == BoundHandling::Reject)
+            {
+                // Rejection is bounded, near the bounds it could otherwise retry for a very long time
+                if (++attempts < g_maxRejections)
+                {
+                    counters.rejections++;
+                    return false;
+                }
+                handling = BoundHandling::BounceBack;
+            }
+
+            RepairBounds(handling, trial, parent, engine);
+            counters.repairs++;
+            return true;
+        }
+
+        /**
+         * Move violating parameters of the trial into the bounds. Deterministic strategies are written
+         * without branches so the loops vectorize.
+         */
+        template<typename Engine>
+        void RepairBounds(BoundHandling handling, double* trial, const double* parent, Engine& engine) const
+        {
+            const double* lower = m_lowerBounds.data();
+            const double* upper = m_upperBounds.data();
+            const unsigned int n = m_numberOfParameters;
+
+            switch (handling)
+            {
+            case BoundHandling::Clamp:
+                for (unsigned int i = 0; i < n; i++)
+                {
+                    const double value = trial[i] < lower[i] ? lower[i] : trial[i];
+                    trial[i] = value > upper[i] ? upper[i] : value;
+                }
+                break;
+            case BoundHandling::Reflect:
+                for (unsigned int i = 0; i < n; i++)
+                {
+                    double value = trial[i] < lower[i] ? 2.0 * lower[i] - trial[i] : trial[i];
+                    value = value > upper[i] ? 2.0 * upper[i] - value : value;
+
+                    // Reflection further than the width of the box ends up clamped
+                    value = value < lower[i] ? lower[i] : value;
+                    trial[i] = value > upper[i] ? upper[i] : value;
+                }
+                break;
+            case BoundHandling::Midpoint:
+                for (unsigned int i = 0; i < n; i++)
+                {
+                    const double value = trial[i] < lower[i] ? 0.5 * (lower[i] + parent[i]) : trial[i];
+                    trial[i] = value > upper[i] ? 0.5 * (upper[i] + parent[i]) : value;
+                }
+                break;
+            case BoundHandling::BounceBack:
+                for (unsigned int i = 0; i < n; i++)
+                {
+                    if (trial[i] < lower[i])
+                    {
+                        trial[i] = lower[i] + UniformReal(engine) * (parent[i] - lower[i]);
+                    }
+                    else if (trial[i] > upper[i])
+                    {
+                        trial[i] = upper[i] - UniformReal(engine) * (upper[i] - parent[i]);
+                    }
+                }
+                break;
+            case BoundHandling::RandomReinit:
+                for (unsigned int i = 0; i < n; i++)
+                {
+                    if (trial[i] < lower[i] || trial[i] > upper[i])
+                    {
+                        trial[i] = UniformReal(engine, lower[i], upper[i]);
+                    }
+                }
+                break;
+            case BoundHandling::Wrap:
+                for (unsigned int i = 0; i < n; i++)
+                {
+                    const double width = upper[i] - lower[i];
+                    if ((trial[i] < lower[i] || trial[i] > upper[i]) && width == 0.0)
+                    {
+                        // Fixed parameter, fmod by zero width would give NaN
+                        trial[i] = lower[i];
+                    }
+                    else if (trial[i] < lower[i])
+                    {
+                        trial[i] = upper[i] - std::fmod(lower[i] - trial[i], width);
+                    }
+                    else if (trial[i] > upper[i])
+                    {
+                        trial[i] = lower[i] + std::fmod(trial[i] - upper[i], width);
+                    }
+                }
+                break;
+            case BoundHandling::Reject:
+                break;
+            }
+        }
+
+        /**
+         * Evaluate all rows of m_trials in place. With a thread pool the batch is split into chunks
+         * evaluated concurrently, otherwise a single EvaluateBatch call is made.
+         */
+        void EvaluateTrials(double* costs)
+        {
+            auto evaluate = [this, costs](std::size_t begin, std::size_t end, unsigned int)
+            {
+                EvaluateRows(begin, end, costs, nullptr);
+            };
+
+            // Only a prefix of the trials fits into the evaluation budget, the rest is not evaluated
+            const unsigned int count = static_cast<unsigned int>(std::min<unsigned long long>(m_populationSize, RemainingEvaluations()));
+            for (unsigned int x = count; x < m_populationSize; x++)
+            {
+                costs[x] = std::numeric_limits<double>::infinity();
+            }
+
+            m_evaluatedTrials = 0;
+            if (count > 0)
+            {
+                ParallelFor(count, EvaluationGrain(), evaluate);
+            }
+
+            m_evaluations += m_evaluatedTrials;
+        }
+
+        /**
+         * Evaluate rows [begin, end) of m_trials. When stop criteria are checked between evaluations
+         * rows are evaluated in batches of m_stopCheckBatchSize and rows after a stop get infinite cost
+         * and violation, so they never replace an agent.
+         */
+        void EvaluateRows(std::size_t begin, std::size_t end, double* costs, double* violations)
+        {
+            if (!ChecksStopBetweenEvaluations())
+            {
+                m_cost.EvaluateBatch(m_trials.RowData(begin), end - begin, m_trials.Stride(), costs + begin);
+                m_evaluatedTrials.fetch_add(end - begin, std::memory_order_relaxed);
+                return;
+            }
+
+            unsigned long long evaluated = 0;
+            for (std::size_t x = begin; x < end;)
+            {
+                const std::size_t last = std::min<std::size_t>(x + m_stopCheckBatchSize, end);
+                if (ShouldStop())
+                {
+                    for (; x < last; x++)
+                    {
+                        costs[x] = std::numeric_limits<double>::infinity();
+                        if (violations)
+                        {
+                            violations[x] = std::numeric_limits<double>::infinity();
+                        }
+                    }
+                    continue;
+                }
+
+                m_cost.EvaluateBatch(m_trials.RowData(x), last - x, m_trials.Stride(), costs + x);
+                evaluated += last - x;
+
+                for (; x < last; x++)
+                {
+                    if (costs[x] <= m_targetCost && (!violations || violations[x] == 0.0))
+                    {
+                        Stop(StopReason::TargetCost);
+                    }
+                }
+            }
+            m_evaluatedTrials.fetch_add(evaluated, std::memory_order_relaxed);
+        }
+
+        std::size_t EvaluationGrain() const
+        {
+            if (!m_threadPool)
+            {
+                return m_populationSize;
+            }
+
+            // Several chunks per thread balance varying evaluation times
+            return std::max<std::size_t>(1, m_populationSize / (4 * m_threadPool->NumberOfThreads()));
+        }
+
+        unsigned long long RemainingEvaluations() const
+        {
+            if (m_maxEvaluations == 0)
+            {
+                return std::numeric_limits<unsigned long long>::max();
+            }
+            return m_maxEvaluations > m_evaluations ? m_maxEvaluations - m_evaluations : 0;
+        }
+
+        bool ChecksStopBetweenEvaluations() const
+        {
+            return m_stopToken || m_deadline != std::chrono::steady_clock::time_point::max() ||
+                   m_targetCost > -std::numeric_limits<double>::infinity();
+        }
+
+        /**
+         * Record the reason of a stop, the first one wins. Called from any thread.
+         */
+        void Stop(StopReason reason)
+        {
+            StopReason expected = StopReason::None;
+            m_stopReason.compare_exchange_strong(expected, reason);
+        }
+
+        /**
+         * Check the stop token and the deadline. Called from any thread between evaluations.
+         */
+        bool ShouldStop()
+        {
+            if (m_stopReason.load(std::memory_order_relaxed) != StopReason::None)
+            {
+                return true;
+            }
+
+            if (m_stopToken && m_stopToken->load(std::memory_order_relaxed))
+            {
+                Stop(StopReason::StopToken);
+                return true;
+            }
+
+            if (m_deadline != std::chrono::steady_clock::time_point::max() && std::chrono::steady_clock::now() >= m_deadline)
+            {
+                Stop(StopReason::Deadline);
+                return true;
+            }
+
+            return false;
+        }
+
+        /**
+         * Check all stop criteria between generations.
+         */
+        bool ShouldStopBeforeGeneration()
+        {
+            if (m_maxEvaluations > 0 && m_evaluations >= m_maxEvaluations)
+            {
+                Stop(StopReason::MaxEvaluations);
+            }
+            // Best of all runs, an earlier run may already have reached the target
+            if (GetBestCost() <= m_targetCost && GetBestViolation() == 0.0)
+            {
+                Stop(StopReason::TargetCost);
+            }
+            return ShouldStop();
+        }
+
+        /**
+         * Per thread state of AsynchronousSteps. Each thread builds trials from its own copy of the
+         * population, refreshing a row only when a trial reads it and another thread changed it since.
+         * Buffers are allocated on the first call and when the population or dimension changes.
+         */
+        struct AsyncWorker
+        {
+            DifferentialEvolution* optimizer;
+            AlignedMatrix population;
+            AlignedBuffer<double> costs;
+            std::vector<std::uint32_t> versions;
+            AlignedMatrix buffers;
+            RandomEngine generator;
+            BoundCounters boundCounters;
+
+            // The p best agents of the snapshot, updated as refreshed rows improve
+            std::vector<std::uint32_t> rankedAgents;
+            std::vector<std::uint8_t> isRanked;
+            unsigned int numberOfRankedAgents;
+            unsigned int worstRanked;
+
+            void Reset(DifferentialEvolution* owner, unsigned int populationSize, unsigned int numberOfParameters, std::uint64_t seed, unsigned int index)
+            {
+                optimizer = owner;
+                if (population.Rows() != populationSize || population.Columns() != numberOfParameters)
+                {
+                    population.Resize(populationSize, numberOfParameters);
+                    costs.Resize(populationSize);
+                    buffers.Resize(3, numberOfParameters);
+                    versions.resize(populationSize);
+                    rankedAgents.resize(populationSize);
+                    isRanked.resize(populationSize);
+                }
+
+                std::fill(isRanked.begin(), isRanked.end(), 0);
+                numberOfRankedAgents = 0;
+                worstRanked = 0;
+
+                generator = RandomEngine(seed, g_threadStreams + index);
+                boundCounters = BoundCounters();
+            }
+
+            bool IsBetter(std::uint32_t left, std::uint32_t right) const
+            {
+                return costs[left] < costs[right] || (costs[left] == costs[right] && left < right);
+            }
+
+            void FindWorstRanked()
+            {
+                worstRanked = 0;
+                for (unsigned int i = 1; i < numberOfRankedAgents; i++)
+                {
+                    if (IsBetter(rankedAgents[worstRanked], rankedAgents[i]))
+                    {
+                        worstRanked = i;
+                    }
+                }
+            }
+
+            /**
+             * Update the ranking after the cost of row x decreased.
+             */
+            void Improved(std::uint32_t x)
+            {
+                if (numberOfRankedAgents == 0)
+                {
+                    return;
+                }
+
+                const std::uint32_t worst = rankedAgents[worstRanked];
+                if (isRanked[x])
+                {
+                    if (x == worst)
+                    {
+                        FindWorstRanked();
+                    }
+                }
+                else if (IsBetter(x, worst))
+                {
+                    isRanked[worst] = 0;
+                    isRanked[x] = 1;
+                    rankedAgents[worstRanked] = x;
+                    FindWorstRanked();
+                }
+            }
+        };
+
+        static void RefreshSnapshotRow(void* snapshot, unsigned int x)
+        {
+            AsyncWorker& worker = *static_cast<AsyncWorker*>(snapshot);
+            worker.optimizer->RefreshRow(worker, x);
+        }
+
+        /**
+         * Copy row x of the shared population into the worker snapshot if its version changed. Rows
+         * are guarded by sequence locks: the version is odd while a row is written and the copy is
+         * discarded if the version changed while it was read. Readers never wait, a row being written
+         * keeps its previous copy until a later trial reads it again.
+         */
+        void RefreshRow(AsyncWorker& worker, unsigned int x)
+        {
+            const std::uint32_t version = m_rowVersions[x].load(std::memory_order_acquire);
+            if (version == worker.versions[x] || (version & 1))
+            {
+                return;
+            }
+
+            double* scratch = worker.buffers.RowData(2);
+            const std::atomic<double>* row = &m_sharedPopulation[static_cast<std::size_t>(x) * m_numberOfParameters];
+            for (unsigned int i = 0; i < m_numberOfParameters; i++)
+            {
+                scratch[i] = row[i].load(std::memory_order_relaxed);
+            }
+            const double cost = m_sharedCosts[x].load(std::memory_order_relaxed);
+
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (m_rowVersions[x].load(std::memory_order_relaxed) != version)
+            {
+                return;
+            }
+
+            worker.population.CopyRow(x, scratch);
+            worker.costs[x] = cost;
+            worker.versions[x] = version;
+            worker.Improved(x);
+        }
+
+        void StoreSharedRow(unsigned int x, const double* agent, double cost)
+        {
+            std::atomic<double>* row = &m_sharedPopulation[static_cast<std::size_t>(x) * m_numberOfParameters];
+            for (unsigned int i = 0; i < m_numberOfParameters; i++)
+            {
+                row[i].store(agent[i], std::memory_order_relaxed);
+            }
+            m_sharedCosts[x].store(cost, std::memory_order_relaxed);
+        }
+
+        /**
+         * Rank the p best agents of the worker snapshot, later refreshes keep the ranking up to date.
+         */
+        void RankSnapshot(AsyncWorker& worker)
+        {
+            unsigned int count = static_cast<unsigned int>(m_pBest * m_populationSize + 0.5);
+            count = std::max(1u, std::min(count, m_populationSize));
+
+            for (unsigned int i = 0; i < m_populationSize; i++)
+            {
+                worker.rankedAgents[i] = i;
+            }
+            std::nth_element(worker.rankedAgents.begin(), worker.rankedAgents.begin() + (count - 1), worker.rankedAgents.begin() + m_populationSize,
+                [&worker](std::uint32_t left, std::uint32_t right)
+                {
+                    return worker.IsBetter(left, right);
+                });
+
+            for (unsigned int i = 0; i < count; i++)
+            {
+                worker.isRanked[worker.rankedAgents[i]] = 1;
+            }
+            worker.numberOfRankedAgents = count;
+            worker.FindWorstRanked();
+        }
+
+        /**
+         * Replace agent x with the trial if the trial is better than the agent's current cost. Writers
+         * make the version odd, which excludes other writers of the row, and publish version + 2.
+         */
+        bool CommitIfBetter(unsigned int x, const double* trial, double cost)
+        {
+            std::uint32_t version = m_rowVersions[x].load(std::memory_order_relaxed);
+            while ((version & 1) || !m_rowVersions[x].compare_exchange_weak(version, version + 1, std::memory_order_acquire, std::memory_order_relaxed))
+            {
+                if (version & 1)
+                {
+                    std::this_thread::yield();
+                    version = m_rowVersions[x].load(std::memory_order_relaxed);
+                }
+            }
+            std::atomic_thread_fence(std::memory_order_release);
+
+            const bool better = cost < m_sharedCosts[x].load(std::memory_order_relaxed);
+            if (better)
+            {
+                StoreSharedRow(x, trial, cost);
+            }
+
+            m_rowVersions[x].store(better ? version + 2 : version, std::memory_order_release);
+            return better;
+        }
+
+        /**
+         * Predict costs of all trials, evaluate only the selected ones and discard the others by
+         * giving them infinite cost.
+         */
+        void EvaluateScreenedTrials()
+        {
+            // Score is predicted improvement over the target, trials the model can not predict
+            // are always evaluated
+            auto predict = [this](std::size_t begin, std::size_t end, unsigned int)
+            {
+                for (std::size_t x = begin; x < end; x++)
+                {
+                    double prediction;
+                    m_trialScores[x] = m_surrogate->Predict(m_trials.RowData(x), prediction) ?
+                        prediction - m_minCostPerAgent[x] : -std::numeric_limits<double>::infinity();
+                }
+            };
+            ParallelFor(m_populationSize, g_generationGrain, predict);
+
+            m_numberOfSelectedTrials = 0;
+            if (m_surrogateScreening == SurrogateScreening::PredictedBetter)
+            {
+                for (unsigned int x = 0; x < m_populationSize; x++)
+                {
+                    if (m_trialScores[x] < 0.0)
+                    {
+                        m_selectedTrials[m_numberOfSelectedTrials++] = x;
+                    }
+                }
+            }
+            else
+            {
+                unsigned int count = m_surrogateTopK > 0 ? m_surrogateTopK : (m_populationSize + 1) / 2;
+                for (unsigned int x = 0; x < m_populationSize; x++)
+                {
+                    m_rankedAgents[x] = x;
+                    if (std::isinf(m_trialScores[x]) && m_trialScores[x] < 0.0)
+                    {
+                        count++;
+                    }
+                }
+                count = std::min(count, m_populationSize);
+
+                std::nth_element(m_rankedAgents.begin(), m_rankedAgents.begin() + (count - 1), m_rankedAgents.begin() + m_populationSize,
+                    [this](std::uint32_t left, std::uint32_t right)
+                    {
+                        return m_trialScores[left] < m_trialScores[right] || (m_trialScores[left] == m_trialScores[right] && left < right);
+                    });
+                std::copy(m_rankedAgents.begin(), m_rankedAgents.begin() + count, m_selectedTrials.begin());
+                std::sort(m_selectedTrials.begin(), m_selectedTrials.begin() + count);
+                m_numberOfSelectedTrials = count;
+            }
+
+            if (m_numberOfSelectedTrials == 0)
+            {
+                m_selectedTrials[0] = static_cast<std::uint32_t>(std::min_element(m_trialScores.data(), m_trialScores.data() + m_populationSize) - m_trialScores.data());
+                m_numberOfSelectedTrials = 1;
+            }
+
+            for (unsigned int x = 0; x < m_populationSize; x++)
+            {
+                m_trialCosts[x] = std::numeric_limits<double>::infinity();
+            }
+
+            // Trials cut by the budget or a stop request are not counted as screened out
+            m_numberOfScreenedTrials += m_populationSize - m_numberOfSelectedTrials;
+
+            // Selected trials are in index order, the budget keeps the first ones
+            m_numberOfSelectedTrials = static_cast<unsigned int>(std::min<unsigned long long>(m_numberOfSelectedTrials, RemainingEvaluations()));
+
+            auto evaluate = [this](std::size_t begin, std::size_t end, unsigned int)
+            {
+                for (std::size_t i = begin; i < end; i++)
+                {
+                    const std::uint32_t x = m_selectedTrials[i];
+                    EvaluateRows(x, x + 1, m_trialCosts.data(), nullptr);
+                }
+            };
+            m_evaluatedTrials = 0;
+            ParallelFor(m_numberOfSelectedTrials, 1, evaluate);
+
+            for (unsigned int i = 0; i < m_numberOfSelectedTrials; i++)
+            {
+                const std::uint32_t x = m_selectedTrials[i];
+                if (std::isfinite(m_trialCosts[x]))
+                {
+                    m_surrogate->Add(m_trials.RowData(x), m_trialCosts[x]);
+                }
+            }
+
+            m_evaluations += m_evaluatedTrials;
+        }
+
+        /**
+         * SaveState without the checksum, which the checkpoint writer fills in on its own thread.
+         */
+        void SerializeState(std::vector<char>& bytes) const
+        {
+            static_assert(std::is_trivially_copyable<RandomEngine>::value, "Random engine state must be trivially copyable");
+
+            const std::uint32_t numberOfParameters = m_numberOfParameters;
+            const std::uint32_t maxPopulationSize = m_maxPopulationSize;
+            const std::uint32_t populationSize = m_populationSize;
+            const std::uint32_t bestAgentIndex = m_bestAgentIndex;
+            const std::uint32_t worstAgentIndex = m_worstAgentIndex;
+            const std::uint32_t parameterControl = static_cast<std::uint32_t>(m_parameterControl);
+            const std::uint32_t historySize = static_cast<std::uint32_t>(m_historyF.size());
+            const std::uint32_t windowSize = static_cast<std::uint32_t>(m_bestCostWindow.size());
+            const std::uint64_t historyIndex = m_historyIndex;
+            const std::uint64_t numberOfGenerations = m_numberOfGenerations;
+            const std::uint64_t evaluations = m_evaluations;
+
+            bytes.resize(sizeof(CheckpointHeader) + StatePayloadSize(numberOfParameters, maxPopulationSize, populationSize, historySize, windowSize));
+
+            CheckpointHeader header;
+            std::memcpy(header.magic, checkpoint::g_magic, sizeof(header.magic));
+            header.version = CheckpointHeader::g_version;
+            header.headerSize = sizeof(CheckpointHeader);
+            header.payloadSize = bytes.size() - sizeof(CheckpointHeader);
+            header.checksum = 0;
+            header.engineSize = sizeof(RandomEngine);
+            header.reserved = 0;
+
+            std::size_t offset = 0;
+            checkpoint::Append(bytes, offset, &header, sizeof(header));
+            checkpoint::Append(bytes, offset, &numberOfParameters, sizeof(numberOfParameters));
+            checkpoint::Append(bytes, offset, &maxPopulationSize, sizeof(maxPopulationSize));
+            checkpoint::Append(bytes, offset, &populationSize, sizeof(populationSize));
+            checkpoint::Append(bytes, offset, &bestAgentIndex, sizeof(bestAgentIndex));
+            checkpoint::Append(bytes, offset, &worstAgentIndex, sizeof(worstAgentIndex));
+            checkpoint::Append(bytes, offset, &parameterControl, sizeof(parameterControl));
+            checkpoint::Append(bytes, offset, &historySize, sizeof(historySize));
+            checkpoint::Append(bytes, offset, &windowSize, sizeof(windowSize));
+            checkpoint::Append(bytes, offset, &historyIndex, sizeof(historyIndex));
+            checkpoint::Append(bytes, offset, &numberOfGenerations, sizeof(numberOfGenerations));
+            checkpoint::Append(bytes, offset, &evaluations, sizeof(evaluations));
+            checkpoint::Append(bytes, offset, &m_minCost, sizeof(m_minCost));
+            checkpoint::Append(bytes, offset, &m_F, sizeof(m_F));
+            checkpoint::Append(bytes, offset, &m_CR, sizeof(m_CR));
+            checkpoint::Append(bytes, offset, &m_initialEpsilon, sizeof(m_initialEpsilon));
+            checkpoint::Append(bytes, offset, m_agentGenerators.data(), maxPopulationSize * sizeof(RandomEngine));
+            for (unsigned int x = 0; x < m_populationSize; x++)
+            {
+                checkpoint::Append(bytes, offset, m_population.RowData(x), numberOfParameters * sizeof(double));
+            }
+            checkpoint::Append(bytes, offset, m_minCostPerAgent.data(), populationSize * sizeof(double));
+            checkpoint::Append(bytes, offset, m_violationPerAgent.data(), populationSize * sizeof(double));
+            checkpoint::Append(bytes, offset, m_agentF.data(), maxPopulationSize * sizeof(double));
+            checkpoint::Append(bytes, offset, m_agentCR.data(), maxPopulationSize * sizeof(double));
+            checkpoint::Append(bytes, offset, m_historyF.data(), historySize * sizeof(double));
+            checkpoint::Append(bytes, offset, m_historyCR.data(), historySize * sizeof(double));
+
+            const std::uint32_t numberOfRestarts = m_numberOfRestarts;
+            const std::uint32_t largeRestarts = m_largeRestarts;
+            const std::uint32_t smallRegime = m_smallRegime ? 1 : 0;
+            const std::uint64_t regimeEvaluations[3] = { m_regimeStartEvaluations, m_largeRegimeEvaluations, m_smallRegimeEvaluations };
+            checkpoint::Append(bytes, offset, &numberOfRestarts, sizeof(numberOfRestarts));
+            checkpoint::Append(bytes, offset, &largeRestarts, sizeof(largeRestarts));
+            checkpoint::Append(bytes, offset, &smallRegime, sizeof(smallRegime));
+            checkpoint::Append(bytes, offset, regimeEvaluations, sizeof(regimeEvaluations));
+            checkpoint::Append(bytes, offset, &m_restartGenerator, sizeof(m_restartGenerator));
+            checkpoint::Append(bytes, offset, &m_restartBestCost, sizeof(m_restartBestCost));
+            checkpoint::Append(bytes, offset, &m_restartBestViolation, sizeof(m_restartBestViolation));
+            checkpoint::Append(bytes, offset, m_restartBest.data(), numberOfParameters * sizeof(double));
+
+            const BoundCounters boundCounters = GetBoundCounters();
+            const std::uint64_t counters[4] = { m_numberOfScreenedTrials, m_numberOfSkippedEvaluations, boundCounters.rejections, boundCounters.repairs };
+            checkpoint::Append(bytes, offset, counters, sizeof(counters));
+
+            const std::uint64_t detectorCounters[2] = { m_generationsWithoutImprovement, m_detectorGenerations };
+            checkpoint::Append(bytes, offset, detectorCounters, sizeof(detectorCounters));
+            checkpoint::Append(bytes, offset, &m_lastBestCost, sizeof(m_lastBestCost));
+            checkpoint::Append(bytes, offset, &m_improvementRate, sizeof(m_improvementRate));
+            checkpoint::Append(bytes, offset, m_parameterMeans.data(), numberOfParameters * sizeof(double));
+            checkpoint::Append(bytes, offset, m_parameterSquares.data(), numberOfParameters * sizeof(double));
+            checkpoint::Append(bytes, offset, m_bestCostWindow.data(), windowSize * sizeof(double));
+        }
+
+        static std::size_t StatePayloadSize(std::size_t numberOfParameters, std::size_t maxPopulationSize, std::size_t populationSize,
+                                            std::size_t historySize, std::size_t windowSize)
+        {
+            return 11 * sizeof(std::uint32_t) + 12 * sizeof(std::uint64_t) + 8 * sizeof(double) +
+                   (maxPopulationSize + 1) * sizeof(RandomEngine) +
+                   populationSize * (numberOfParameters + 2) * sizeof(double) +
+                   3 * numberOfParameters * sizeof(double) +
+                   2 * maxPopulationSize * sizeof(double) +
+                   2 * historySize * sizeof(double) +
+                   windowSize * sizeof(double);
+        }
+
+        void ApplyPopulationSizeSchedule()
+        {
+            // Restarts own the population size, see SetRestartStrategy
+            if (!m_populationSizeSchedule || m_restartStrategy != RestartStrategy::None)
+            {
+                return;
+            }
+
+            unsigned int newSize = m_populationSizeSchedule(m_evaluations);
+            newSize = std::max(newSize, std::max(4u, m_minimumStrategyPopulationSize));
+            if (newSize >= m_populationSize)
+            {
+                return;
+            }
+
+            // Select the best newSize agents and keep them in their original order
+            for (unsigned int i = 0; i < m_populationSize; i++)
+            {
+                m_rankedAgents[i] = i;
+            }
+            std::nth_element(m_rankedAgents.begin(), m_rankedAgents.begin() + newSize, m_rankedAgents.begin() + m_populationSize,
+                [this](std::uint32_t left, std::uint32_t right)
+                {
+                    return IsAgentBetter(left, right) || (!IsAgentBetter(right, left) && left < right);
+                });
+            std::sort(m_rankedAgents.begin(), m_rankedAgents.begin() + newSize);
+
+            // Compact survivors to the front, each agent keeps its random stream and control parameters
+            for (unsigned int i = 0; i < newSize; i++)
+            {
+                const unsigned int from = m_rankedAgents[i];
+                if (from == i)
+                {
+                    continue;
+                }
+
+                m_population.CopyRow(i, m_population.RowData(from));
+                m_minCostPerAgent[i] = m_minCostPerAgent[from];
+                m_violationPerAgent[i] = m_violationPerAgent[from];
+                // Swapped so the random streams of all agents stay distinct after InitPopulation
+                std::swap(m_agentGenerators[i], m_agentGenerators[from]);
+                m_agentF[i] = m_agentF[from];
+                m_agentCR[i] = m_agentCR[from];
+            }
+
+            m_populationSize = newSize;
+            FindBestAgent();
+            ResetPopulationStatistics();
+        }
+
+        /**
+         * Allocate the per agent buffers for capacity agents. Agents keep their random streams, the
+         * content of the other buffers is lost.
+         */
+        void ReservePopulation(unsigned int capacity)
+        {
+            m_maxPopulationSize = capacity;
+
+            // Each agent has its own random stream so results do not depend on the number of threads
+            m_agentGenerators.reserve(capacity);
+            for (unsigned int x = static_cast<unsigned int>(m_agentGenerators.size()); x < capacity; x++)
+            {
+                m_agentGenerators.push_back(RandomEngine(static_cast<std::uint64_t>(m_randomSeed), x));
+            }
+
+            m_population.Resize(capacity, m_numberOfParameters, m_population.Stride());
+            m_trials.Resize(capacity, m_numberOfParameters, m_trials.Stride());
+
+            m_minCostPerAgent.Resize(capacity);
+            m_trialCosts.Resize(capacity);
+
+            // Violations stay zero without general constraints, so agents are compared by cost only
+            m_violationPerAgent.Resize(capacity);
+            m_trialViolations.Resize(capacity);
+            std::fill(m_violationPerAgent.begin(), m_violationPerAgent.end(), 0.0);
+            std::fill(m_trialViolations.begin(), m_trialViolations.end(), 0.0);
+
+            m_rankedAgents.resize(capacity);
+
+            m_agentF.Resize(capacity);
+            m_agentCR.Resize(capacity);
+            m_trialF.Resize(capacity);
+            m_trialCR.Resize(capacity);
+            std::fill(m_agentF.begin(), m_agentF.end(), m_F);
+            std::fill(m_agentCR.begin(), m_agentCR.end(), m_CR);
+            std::fill(m_trialF.begin(), m_trialF.end(), m_F);
+            std::fill(m_trialCR.begin(), m_trialCR.end(), m_CR);
+
+            m_trialScores.Resize(capacity);
+            m_selectedTrials.resize(capacity);
+
+            m_rowVersions.reset(new std::atomic<std::uint32_t>[capacity]);
+            for (unsigned int x = 0; x < capacity; x++)
+            {
+                m_rowVersions[x].store(0, std::memory_order_relaxed);
+            }
+            m_sharedPopulation.reset(new std::atomic<double>[static_cast<std::size_t>(capacity) * m_numberOfParameters]);
+            m_sharedCosts.reset(new std::atomic<double>[capacity]);
+        }
 
-    class DifferentialEvolution
-    {
-    public:
         /**
-         * Construct Differential Evolution optimizer
-         *
-         * \param costFunction Cost function to minimize
-         * \param populationSize Number of agents in each optimization step
-         * \param randomSeed Set random seed to a fix value to have repeatable (non stochastic) experiments
-         * \param shouldCheckConstraints Should constraints bee checked on for each new candidate.
-         * This check check may be turned off to increase performance if the cost function is defined
-         * and has no local minimum outside of the constraints.
-         * \param callback Optional callback to be called after each optimization iteration has finished.
-         * Optimization iteration is defined as processing of single population with SelectionAndCorssing method.
+         * True if the best agent of the previous runs is better than the best agent of the population.
          */
-        DifferentialEvolution(  const IOptimizable& costFunction,
-                                unsigned int populationSize,
-                                int randomSeed = 123,
-                                bool shouldCheckConstraints = true,
-                                std::function<void(const DifferentialEvolution&)> callback = nullptr,
-                                std::function<bool(const DifferentialEvolution&)> terminationCondition = nullptr) :
-            m_cost(costFunction),
-            m_populationSize(populationSize),
-            m_F(0.8),
-            m_CR(0.9),
-            m_bestAgentIndex(0),
-            m_minCost(-std::numeric_limits<double>::infinity()),
-            m_shouldCheckConstraints(shouldCheckConstraints),
-            m_callback(callback),
-            m_terminationCondition(terminationCondition)
+        bool IsRestartBestBetter() const
         {
-            m_generator.seed(randomSeed);
-            assert(m_populationSize >= 4);
+            return IsBetter(m_restartBestCost, m_restartBestViolation, m_minCostPerAgent[m_bestAgentIndex], m_violationPerAgent[m_bestAgentIndex]);
+        }
 
-            m_numberOfParameters = m_cost.NumberOfParameters();
+        /**
+         * Size of the next population. The evaluations of the finished run are charged to its regime,
+         * BIPOP then continues the regime which used fewer evaluations.
+         */
+        unsigned int NextRestartPopulationSize()
+        {
+            (m_smallRegime ? m_smallRegimeEvaluations : m_largeRegimeEvaluations) += m_evaluations - m_regimeStartEvaluations;
+            m_regimeStartEvaluations = m_evaluations;
 
-            m_population.resize(populationSize);
-            for (auto& agent : m_population)
+            m_smallRegime = m_restartStrategy == RestartStrategy::BIPOP && m_smallRegimeEvaluations < m_largeRegimeEvaluations;
+            if (!m_smallRegime)
             {
-                agent.resize(m_numberOfParameters);
+                m_largeRestarts++;
             }
 
-            m_minCostPerAgent.resize(m_populationSize);
+            const double large = std::min<double>(m_maxPopulationSize, m_initialPopulationSize * std::pow(m_populationIncrease, m_largeRestarts));
+            double size = large;
+            if (m_smallRegime)
+            {
+                // Sizes between the initial and half the current large population, biased to small ones
+                const double u = UniformReal(m_restartGenerator);
+                size = m_initialPopulationSize * std::pow(0.5 * large / m_initialPopulationSize, u * u);
+            }
 
-            m_constraints = costFunction.GetConstraints();
+            const double minimum = std::max(4u, m_minimumStrategyPopulationSize);
+            return static_cast<unsigned int>(std::lround(std::max(minimum, std::min<double>(size, m_maxPopulationSize))));
         }
 
-        void InitPopulation()
+        /**
+         * Remember the best agent of the finished run and start a new run from a random population.
+         * Per agent control parameters start over from the current F and CR, the SHADE history is kept.
+         */
+        void Restart()
         {
-            // Init population based on random sampling of the cost function
-            std::shared_ptr<std::uniform_real_distribution<double>> distribution;
+            if (!IsRestartBestBetter())
+            {
+                std::memcpy(m_restartBest.data(), m_population.RowData(m_bestAgentIndex), m_numberOfParameters * sizeof(double));
+                m_restartBestCost = m_minCostPerAgent[m_bestAgentIndex];
+                m_restartBestViolation = m_violationPerAgent[m_bestAgentIndex];
+            }
+
+            m_populationSize = NextRestartPopulationSize();
+            m_numberOfRestarts++;
+
+            std::fill(m_agentF.data(), m_agentF.data() + m_populationSize, m_F);
+            std::fill(m_agentCR.data(), m_agentCR.data() + m_populationSize, m_CR);
 
-            for (auto& agent : m_population)
+            SampleAgents(false);
+        }
+
+        /**
+         * Sample m_populationSize agents uniformly within the constraints, evaluate them and make
+         * them the population.
+         */
+        void SampleAgents(bool initEpsilonLevel)
+        {
+            auto initAgents = [this](std::size_t begin, std::size_t end, unsigned int)
             {
-                for (int i = 0; i < m_numberOfParameters; i++)
+                for (std::size_t x = begin; x < end; x++)
                 {
-                    if (m_constraints[i].isConstrained)
-                    {
-                        distribution = std::make_shared<std::uniform_real_distribution<double>>(std::uniform_real_distribution<double>(m_constraints[i].lower, m_constraints[i].upper));
-                    }
-                    else
+                    double* agent = m_trials.RowData(x);
+                    for (unsigned int i = 0; i < m_numberOfParameters; i++)
                     {
-                        distribution = std::make_shared<std::uniform_real_distribution<double>>(std::uniform_real_distribution<double>(g_defaultLowerConstraint, g_defaultUpperConstarint));
+                        double lower = m_constraints[i].isConstrained ? m_constraints[i].lower : g_defaultLowerConstraint;
+                        double upper = m_constraints[i].isConstrained ? m_constraints[i].upper : g_defaultUpperConstarint;
+
+                        agent[i] = UniformReal(m_agentGenerators[x], lower, upper);
                     }
+                }
+            };
+            ParallelFor(m_populationSize, g_generationGrain, initAgents);
 
-                    agent[i] = (*distribution)(m_generator);
+            if (m_constrainedCost)
+            {
+                EvaluateTrialViolations(m_violationPerAgent.data());
+                if (initEpsilonLevel)
+                {
+                    InitEpsilonLevel();
                 }
+                EvaluateFeasibleTrials(m_violationPerAgent.data(), m_minCostPerAgent.data());
             }
-
-            // Initialize minimum cost, best agent and best agent index
-            for (int i = 0; i < m_populationSize; i++)
+            else
             {
-                m_minCostPerAgent[i] = m_cost.EvaluteCost(m_population[i]);
+                EvaluateTrials(m_minCostPerAgent.data());
+            }
 
-                if (m_minCostPerAgent[i] < m_minCost)
+            if (m_surrogate)
+            {
+                for (unsigned int x = 0; x < m_populationSize; x++)
                 {
-                    m_minCost = m_minCostPerAgent[i];
-                    m_bestAgentIndex = i;
+                    m_surrogate->Add(m_trials.RowData(x), m_minCostPerAgent[x]);
                 }
             }
+
+            // Initialize minimum cost, best agent and best agent index
+            for (unsigned int i = 0; i < m_populationSize; i++)
+            {
+                m_population.CopyRow(i, m_trials.RowData(i));
+            }
+            FindBestAgent();
+            ResetPopulationStatistics();
+            ResetConvergenceDetectors();
         }
 
-        void SelectionAndCorssing()
+        /**
+         * Exact mean and sum of squared deviations from the mean of every parameter over the population,
+         * in two passes along the rows. Replacements update them incrementally afterwards.
+         */
+        void ResetPopulationStatistics()
         {
-            std::uniform_real_distribution<double> distribution(0, m_populationSize);
-
-            double minCost = m_minCostPerAgent[0];
-            int bestAgentIndex = 0;
-
-            for (int x = 0; x < m_populationSize; x++)
+            double* mean = m_parameterMeans.data();
+            double* squares = m_parameterSquares.data();
+            std::fill(mean, mean + m_numberOfParameters, 0.0);
+            std::fill(squares, squares + m_numberOfParameters, 0.0);
+            for (unsigned int x = 0; x < m_populationSize; x++)
             {
-                // For x in population select 3 random agents (a, b, c) different from x
-                int a = x;
-                int b = x;
-                int c = x;
-
-                // Agents must be different from each other and from x
-                while (a == x || b == x || c == x || a == b || a == c || b == c)
+                const double* agent = m_population.RowData(x);
+                for (unsigned int i = 0; i < m_numberOfParameters; i++)
                 {
-                    a = distribution(m_generator);
-                    b = distribution(m_generator);
-                    c = distribution(m_generator);
+                    mean[i] += agent[i];
                 }
-
-                // Form intermediate solution z
-                std::vector<double> z(m_numberOfParameters);
-                for (int i = 0; i < m_numberOfParameters; i ++)
+            }
+            for (unsigned int i = 0; i < m_numberOfParameters; i++)
+            {
+                mean[i] /= m_populationSize;
+            }
+            for (unsigned int x = 0; x < m_populationSize; x++)
+            {
+                const double* agent = m_population.RowData(x);
+                for (unsigned int i = 0; i < m_numberOfParameters; i++)
                 {
-                    z[i] = m_population[a][i] + m_F * (m_population[b][i] - m_population[c][i]);
+                    squares[i] += (agent[i] - mean[i]) * (agent[i] - mean[i]);
                 }
+            }
+
+            FindWorstAgent();
+        }
 
-                // Chose random R
-                std::uniform_real_distribution<double> distributionParam(0, m_numberOfParameters);
-                int R = distributionParam(m_generator);
+        /**
+         * Welford update of the population statistics for an agent replaced by another one.
+         */
+        void UpdatePopulationStatistics(const double* oldAgent, const double* newAgent)
+        {
+            const double n = m_populationSize;
+            double* mean = m_parameterMeans.data();
+            double* squares = m_parameterSquares.data();
+            for (unsigned int i = 0; i < m_numberOfParameters; i++)
+            {
+                const double delta = newAgent[i] - oldAgent[i];
+                const double oldMean = mean[i];
+                mean[i] = oldMean + delta / n;
+                squares[i] = std::max(0.0, squares[i] + delta * (newAgent[i] - mean[i] + oldAgent[i] - oldMean));
+            }
+        }
 
-                // Chose random r for each dimension
-                std::vector<double> r(m_numberOfParameters);
-                std::uniform_real_distribution<double> distributionPerX(0, 1);
-                for (auto& var : r)
+        void FindWorstAgent()
+        {
+            m_worstAgentIndex = 0;
+            for (unsigned int i = 1; i < m_populationSize; i++)
+            {
+                if (m_minCostPerAgent[i] > m_minCostPerAgent[m_worstAgentIndex])
                 {
-                    var = distributionPerX(m_generator);
+                    m_worstAgentIndex = i;
                 }
+            }
+        }
 
-                std::vector<double> newX(m_numberOfParameters);
+        void ResetConvergenceDetectors()
+        {
+            m_generationsWithoutImprovement = 0;
+            m_lastBestCost = m_minCostPerAgent[m_bestAgentIndex];
+            m_improvementRate = std::numeric_limits<double>::infinity();
+            m_detectorGenerations = 0;
+        }
 
-                // Execute crossing
-                for (int i = 0; i < m_numberOfParameters; i++)
-                {
-                    if (r[i] < m_CR || i == R)
-                    {
-                        newX[i] = z[i];
-                    }
-                    else
-                    {
-                        newX[i] = m_population[x][i];
-                    }
-                }
+        /**
+         * Update the detectors at the end of a generation and stop if one of them fires. Statistics
+         * are recomputed exactly from time to time so rounding errors of the updates do not accumulate.
+         */
+        void UpdateConvergenceDetectors()
+        {
+            if (m_numberOfGenerations % g_statisticsRefreshInterval == 0)
+            {
+                ResetPopulationStatistics();
+            }
+
+            const double best = m_minCostPerAgent[m_bestAgentIndex];
+            if (best < m_lastBestCost)
+            {
+                m_lastBestCost = best;
+                m_generationsWithoutImprovement = 0;
+            }
+            else
+            {
+                m_generationsWithoutImprovement++;
+            }
 
-                // Check if newX candidate satisfies constraints and skip it if not.
-                // If agent is skipped loop iteration x is decreased so that it is ensured
-                // that the population has constant size (equal to m_populationSize).
-                if (m_shouldCheckConstraints && !CheckConstraints(newX))
+            if (!m_bestCostWindow.empty())
+            {
+                const std::size_t slot = static_cast<std::size_t>(m_detectorGenerations % m_bestCostWindow.size());
+                if (m_detectorGenerations >= m_bestCostWindow.size() && std::isfinite(m_bestCostWindow[slot]) && std::isfinite(best))
                 {
-                    x--;
-                    continue;
+                    const double previous = m_bestCostWindow[slot];
+                    m_improvementRate = (previous - best) / std::max(std::abs(previous), std::numeric_limits<double>::min());
                 }
+                m_bestCostWindow[slot] = best;
+                m_detectorGenerations++;
+            }
+
+            StopReason converged = StopReason::None;
+            if (GetCostSpread() <= m_costSpreadThreshold)
+            {
+                converged = StopReason::CostSpread;
+            }
+            else if (m_parameterSpreadThreshold > -std::numeric_limits<double>::infinity() && GetParameterSpread() <= m_parameterSpreadThreshold)
+            {
+                converged = StopReason::ParameterSpread;
+            }
+            else if (m_stagnationGenerations > 0 && m_generationsWithoutImprovement >= m_stagnationGenerations)
+            {
+                converged = StopReason::Stagnation;
+            }
+            else if (m_improvementRate < m_improvementRateThreshold)
+            {
+                converged = StopReason::ImprovementRate;
+            }
 
-                // Calculate new cost and decide should the newX be kept.
-                double newCost = m_cost.EvaluteCost(newX);
-                if (newCost < m_minCostPerAgent[x])
+            if (converged == StopReason::None)
+            {
+                return;
+            }
+
+            // A run already stopped by another criterion is not restarted
+            if (m_restartStrategy != RestartStrategy::None && m_stopReason.load() == StopReason::None)
+            {
+                Restart();
+            }
+            else
+            {
+                Stop(converged);
+            }
+        }
+
+        /**
+         * Fill in the counters and statistics of the generation just finished and pass them to the sinks.
+         */
+        void PublishTelemetry()
+        {
+            const BoundCounters counters = GetBoundCounters();
+            m_telemetry.rejections = counters.rejections - m_telemetryBoundCounters.rejections;
+            m_telemetry.repairs = counters.repairs - m_telemetryBoundCounters.repairs;
+            m_telemetryBoundCounters = counters;
+
+            m_telemetry.generation = m_numberOfGenerations;
+            m_telemetry.populationSize = m_populationSize;
+            m_telemetry.totalEvaluations = m_evaluations;
+            m_telemetry.bestCost = m_minCostPerAgent[m_bestAgentIndex];
+
+            if (m_collectStatistics)
+            {
+                double sum = 0.0;
+                double worst = -std::numeric_limits<double>::infinity();
+                for (unsigned int x = 0; x < m_populationSize; x++)
                 {
-                    m_population[x] = newX;
-                    m_minCostPerAgent[x] = newCost;
+                    sum += m_minCostPerAgent[x];
+                    worst = std::max(worst, m_minCostPerAgent[x]);
                 }
+                m_telemetry.meanCost = sum / m_populationSize;
+                m_telemetry.worstCost = worst;
 
-                // Track the global best agent.
-                if (m_minCostPerAgent[x] < minCost)
+                double diversity = 0.0;
+                for (unsigned int i = 0; i < m_numberOfParameters; i++)
                 {
-                    minCost = m_minCostPerAgent[x];
-                    bestAgentIndex = x;
+                    diversity += std::sqrt(m_parameterSquares[i] / m_populationSize);
                 }
+                m_telemetry.diversity = diversity / m_numberOfParameters;
             }
 
-            m_minCost = minCost;
-            m_bestAgentIndex = bestAgentIndex;
+            for (ITelemetrySink* sink : m_telemetrySinks)
+            {
+                sink->OnGeneration(m_telemetry);
+            }
         }
 
-        std::vector<double> GetBestAgent() const
+
+        /**
+         * Improvement of a successful trial over its target for SHADE weights, in cost if the target is
+         * within the epsilon level and in violation otherwise.
+         */
+        double Improvement(double cost, double violation, double targetCost, double targetViolation) const
         {
-            return m_population[m_bestAgentIndex];
+            return targetViolation <= m_epsilon ? targetCost - cost : targetViolation - violation;
         }
 
-        double GetBestCost() const
+        void FindBestAgent()
         {
-            return m_minCostPerAgent[m_bestAgentIndex];
+            m_bestAgentIndex = 0;
+            for (unsigned int i = 1; i < m_populationSize; i++)
+            {
+                if (IsAgentBetter(i, m_bestAgentIndex))
+                {
+                    m_bestAgentIndex = i;
+                }
+            }
+            m_minCost = m_minCostPerAgent[m_bestAgentIndex];
         }
 
-        std::vector<std::pair<std::vector<double>, double>> GetPopulationWithCosts() const
+        double EvaluateViolation(const double* agent, double* values) const
         {
-            std::vector<std::pair<std::vector<double>, double>> toRet;
-            for (int i = 0; i < m_populationSize; i++)
+            m_constrainedCost->EvaluateConstraints(agent, m_numberOfParameters, values);
+
+            double violation = 0.0;
+            for (unsigned int i = 0; i < m_numberOfConstraints; i++)
             {
-                toRet.push_back(std::make_pair(m_population[i], m_minCostPerAgent[i]));
+                violation += values[i];
             }
-
-            return toRet;
+            return violation;
         }
 
-        void PrintPopulation() const
+        /**
+         * Evaluate total constraint violations of all rows of m_trials.
+         */
+        void EvaluateTrialViolations(double* violations)
         {
-            for (auto agent : m_population)
+            auto evaluate = [this, violations](std::size_t begin, std::size_t end, unsigned int threadIndex)
             {
-                for (auto& var : agent)
+                double* values = m_constraintValues.RowData(threadIndex);
+                for (std::size_t x = begin; x < end; x++)
                 {
-                    std::cout << var << " ";
+                    violations[x] = EvaluateViolation(m_trials.RowData(x), values);
                 }
-                std::cout << std::endl;
-            }
+            };
+            ParallelFor(m_populationSize, g_generationGrain, evaluate);
         }
 
-        void Optimize(int iterations, bool verbose = true)
+        /**
+         * Evaluate costs of rows of m_trials within the epsilon level, consecutive ones as a batch.
+         * Rows violating the constraints more lose against any agent they could replace regardless of
+         * their cost, as the level never increases, so they get infinite cost without evaluation.
+         */
+        void EvaluateFeasibleTrials(double* violations, double* costs)
         {
-            InitPopulation();
-
-            // Optimization loop
-            for (int i = 0; i < iterations; i++)
+            // Only trials up to the evaluation budget are evaluated, the following ones lose the selection
+            std::size_t count = m_populationSize;
+            unsigned long long remaining = RemainingEvaluations();
+            for (std::size_t x = 0; x < m_populationSize; x++)
             {
-                // Optimization step
-                SelectionAndCorssing();
-
-                if (verbose)
+                if (violations[x] > m_epsilon)
                 {
-                    std::cout << std::fixed << std::setprecision(5);
-                    std::cout << "Current minimal cost: " << m_minCost << "\t\t";
-                    std::cout << "Best agent: ";
-                    for (int i = 0; i < m_numberOfParameters; i++)
+                    m_numberOfSkippedEvaluations++;
+                }
+                else
+                {
+                    if (remaining == 0)
                     {
-                        std::cout<< m_population[m_bestAgentIndex][i] << " ";
+                        count = x;
+                        break;
                     }
-                    std::cout << std::endl;
+                    remaining--;
                 }
+            }
+            for (std::size_t x = count; x < m_populationSize; x++)
+            {
+                costs[x] = std::numeric_limits<double>::infinity();
+                violations[x] = std::numeric_limits<double>::infinity();
+            }
 
-                if (m_callback)
+            auto evaluate = [this, violations, costs](std::size_t begin, std::size_t end, unsigned int)
+            {
+                std::size_t x = begin;
+                while (x < end)
                 {
-                    m_callback(*this);
-                }
+                    if (violations[x] > m_epsilon)
+                    {
+                        costs[x] = std::numeric_limits<double>::infinity();
+                        x++;
+                        continue;
+                    }
 
-                if (m_terminationCondition)
-                {
-                    if (m_terminationCondition(*this))
+                    std::size_t last = x + 1;
+                    while (last < end && violations[last] <= m_epsilon)
                     {
-                        if (verbose)
-                        {
-                            std::cout << "Terminated due to positive evaluation of the termination condition." << std::endl;
-                        }
-                        return;
+                        last++;
                     }
+                    EvaluateRows(x, last, costs, violations);
+                    x = last;
                 }
+            };
+
+            m_evaluatedTrials = 0;
+            if (count > 0)
+            {
+                ParallelFor(count, EvaluationGrain(), evaluate);
             }
 
-            if (verbose)
+            m_evaluations += m_evaluatedTrials;
+        }
+
+        /**
+         * Epsilon level of a generation, see SetConstraintHandling.
+         */
+        double EpsilonLevel(unsigned long long generation) const
+        {
+            if (m_constraintHandling != ConstraintHandling::Epsilon || generation >= m_epsilonGenerations)
             {
-                std::cout << "Terminated due to exceeding total number of generations." << std::endl;
+                return 0.0;
             }
+
+            return m_initialEpsilon * std::pow(1.0 - static_cast<double>(generation) / m_epsilonGenerations, m_epsilonExponent);
         }
 
-    private:
-        bool CheckConstraints(std::vector<double> agent)
+        /**
+         * Initial epsilon level from the violations of the initial population.
+         */
+        void InitEpsilonLevel()
         {
-            for (int i = 0; i < agent.size(); i++)
+            m_initialEpsilon = 0.0;
+            if (m_constraintHandling == ConstraintHandling::Epsilon)
             {
-                if (!m_constraints[i].Check(agent[i]))
+                for (unsigned int i = 0; i < m_populationSize; i++)
                 {
-                    return false;
+                    m_rankedAgents[i] = i;
                 }
+                const unsigned int k = std::min(m_populationSize - 1, static_cast<unsigned int>(m_epsilonQuantile * m_populationSize));
+                std::nth_element(m_rankedAgents.begin(), m_rankedAgents.begin() + k, m_rankedAgents.begin() + m_populationSize,
+                    [this](std::uint32_t left, std::uint32_t right)
+                    {
+                        return m_violationPerAgent[left] < m_violationPerAgent[right];
+                    });
+                m_initialEpsilon = m_violationPerAgent[m_rankedAgents[k]];
             }
+            m_epsilon = EpsilonLevel(0);
+        }
 
-            return true;
+        /**
+         * Set the epsilon level of the current generation, the best agent may change with the level.
+         */
+        void UpdateEpsilonLevel()
+        {
+            const double epsilon = EpsilonLevel(m_numberOfGenerations);
+            if (epsilon != m_epsilon)
+            {
+                m_epsilon = epsilon;
+                FindBestAgent();
+            }
+        }
+
+        template<typename Function>
+        void ParallelFor(std::size_t count, std::size_t grain, Function& function)
+        {
+            if (m_threadPool)
+            {
+                m_threadPool->ParallelFor(count, grain, function);
+            }
+            else
+            {
+                function(std::size_t(0), count, 0u);
+            }
+        }
+
+        bool CheckConstraints(const double* agent) const
+        {
+            // No early exit so the loop vectorizes
+            bool valid = true;
+            for (unsigned int i = 0; i < m_numberOfParameters; i++)
+            {
+                valid &= (agent[i] >= m_lowerBounds[i]) & (agent[i] <= m_upperBounds[i]);
+            }
+
+            return valid;
         }
 
         const IOptimizable& m_cost;
@@ -326,6 +4774,9 @@ namespace de
         double m_F;
         double m_CR;
 
+        unsigned int m_bestAgentIndex;
+        double m_minCost;
+
         unsigned int m_numberOfParameters;
 
         bool m_shouldCheckConstraints;
@@ -333,17 +4784,152 @@ namespace de
         std::function<void(const DifferentialEvolution&)> m_callback;
         std::function<bool(const DifferentialEvolution&)> m_terminationCondition;
 
-        std::default_random_engine m_generator;
-        std::vector<std::vector<double>> m_population;
+        std::vector<RandomEngine> m_agentGenerators;
+        std::unique_ptr<ThreadPool> m_threadPool;
+        const SimdKernels* m_kernels;
 
-        std::vector<double> m_minCostPerAgent;
+        // Generation step of the selected strategy
+        void (DifferentialEvolution::*m_generation)();
+        double m_pBest;
 
-        std::vector<IOptimizable::Constraints> m_constraints;
+        // Per thread donor vectors and agent indices ranked by cost for current-to-pbest
+        AlignedMatrix m_donors;
+        std::vector<std::uint32_t> m_rankedAgents;
 
-        int m_bestAgentIndex;
-        double m_minCost;
+        // Adaptive control parameters: per agent values (jDE), values used by the current trials
+        // and SHADE success history memory
+        ParameterControl m_parameterControl;
+        AlignedBuffer<double> m_agentF;
+        AlignedBuffer<double> m_agentCR;
+        AlignedBuffer<double> m_trialF;
+        AlignedBuffer<double> m_trialCR;
+        std::vector<double> m_historyF;
+        std::vector<double> m_historyCR;
+        std::size_t m_historyIndex;
+
+        // Population size schedule and restarts, buffers are allocated for m_maxPopulationSize agents
+        unsigned int m_maxPopulationSize;
+        unsigned int m_initialPopulationSize;
+        unsigned int m_minimumStrategyPopulationSize;
+        std::function<unsigned int(unsigned long long)> m_populationSizeSchedule;
+        unsigned long long m_evaluations;
+
+        // Asynchronous steady-state mode: population shared by the threads, sequence lock version of
+        // each row and per thread state
+        int m_randomSeed;
+        void (DifferentialEvolution::*m_asynchronousSteps)(unsigned long long);
+        std::unique_ptr<std::atomic<std::uint32_t>[]> m_rowVersions;
+        std::unique_ptr<std::atomic<double>[]> m_sharedPopulation;
+        std::unique_ptr<std::atomic<double>[]> m_sharedCosts;
+        std::vector<AsyncWorker> m_asyncWorkers;
+
+        // Generation counter and background checkpointing
+        unsigned long long m_numberOfGenerations;
+        unsigned int m_checkpointInterval;
+        std::vector<char> m_checkpointBuffer;
+        std::unique_ptr<CheckpointWriter> m_checkpointWriter;
+
+        // Surrogate pre-screening: predicted improvement of each trial and trials selected for evaluation
+        ISurrogate* m_surrogate;
+        SurrogateScreening m_surrogateScreening;
+        unsigned int m_surrogateTopK;
+        unsigned long long m_numberOfScreenedTrials;
+        AlignedBuffer<double> m_trialScores;
+        std::vector<std::uint32_t> m_selectedTrials;
+        unsigned int m_numberOfSelectedTrials;
+
+        // Box constraints as arrays and per thread counters of bound violations
+        BoundHandling m_boundHandling;
+        std::vector<BoundCounters> m_boundCounters;
+        AlignedBuffer<double> m_lowerBounds;
+        AlignedBuffer<double> m_upperBounds;
+
+        // General constraints: total violation of each agent and trial, per thread constraint values
+        const IConstrainedOptimizable* m_constrainedCost;
+        unsigned int m_numberOfConstraints;
+        ConstraintHandling m_constraintHandling;
+        unsigned long long m_epsilonGenerations;
+        double m_epsilonExponent;
+        double m_epsilonQuantile;
+        double m_initialEpsilon;
+        double m_epsilon;
+        unsigned long long m_numberOfSkippedEvaluations;
+        AlignedBuffer<double> m_violationPerAgent;
+        AlignedBuffer<double> m_trialViolations;
+        AlignedMatrix m_constraintValues;
+
+        // Telemetry of the last generation and bound counters at its end
+        GenerationTelemetry m_telemetry;
+        BoundCounters m_telemetryBoundCounters;
+        bool m_collectStatistics;
+        std::vector<ITelemetrySink*> m_telemetrySinks;
+        AlignedBuffer<double> m_parameterMeans;
+        AlignedBuffer<double> m_parameterSquares;
+
+        // Stop criteria, the deadline is time_point::max() and the target cost minus infinity when unset
+        unsigned long long m_maxEvaluations;
+        std::chrono::steady_clock::time_point m_deadline;
+        double m_targetCost;
+        const std::atomic<bool>* m_stopToken;
+        unsigned int m_stopCheckBatchSize;
+        std::atomic<StopReason> m_stopReason;
+        std::atomic<unsigned long long> m_evaluatedTrials;
+
+        // Convergence detectors, m_parameterMeans and m_parameterSquares hold the running statistics
+        unsigned int m_worstAgentIndex;
+        double m_costSpreadThreshold;
+        double m_parameterSpreadThreshold;
+        unsigned int m_stagnationGenerations;
+        unsigned long long m_generationsWithoutImprovement;
+        double m_lastBestCost;
+        double m_improvementRateThreshold;
+        double m_improvementRate;
+        unsigned long long m_detectorGenerations;
+        std::vector<double> m_bestCostWindow;
+
+        // Restarts: BIPOP regime bookkeeping and the best agent of the previous runs
+        RestartStrategy m_restartStrategy;
+        double m_populationIncrease;
+        unsigned int m_numberOfRestarts;
+        unsigned int m_largeRestarts;
+        bool m_smallRegime;
+        unsigned long long m_regimeStartEvaluations;
+        unsigned long long m_largeRegimeEvaluations;
+        unsigned long long m_smallRegimeEvaluations;
+        RandomEngine m_restartGenerator;
+        AlignedBuffer<double> m_restartBest;
+        double m_restartBestCost;
+        double m_restartBestViolation;
+
+        // Weighted sums of successful F and CR of the current generation
+        double m_successWeight;
+        double m_successCR;
+        double m_successF;
+        double m_successF2;
+        unsigned int m_numberOfSuccesses;
+        AlignedMatrix m_population;
+        AlignedBuffer<double> m_minCostPerAgent;
+
+        // Trial vectors of the current generation stored row by row and their costs
+        AlignedMatrix m_trials;
+        AlignedBuffer<double> m_trialCosts;
+
+        std::vector<IOptimizable::Constraints> m_constraints;
 
         static constexpr double g_defaultLowerConstraint = -std::numeric_limits<double>::infinity();
         static constexpr double g_defaultUpperConstarint = std::numeric_limits<double>::infinity();
+
+        // Number of agents processed by a single task when generating trial vectors
+        static constexpr std::size_t g_generationGrain = 64;
+
+        // Generations between exact recomputations of the incrementally updated population statistics
+        static constexpr unsigned int g_statisticsRefreshInterval = 64;
+
+        // Number of rejected trials of an agent before BoundHandling::Reject repairs the trial
+        static constexpr unsigned int g_maxRejections = 100;
+
+        // Regeneration probability of jDE and adaptation rate of JADE
+        static constexpr double g_jdeTau = 0.1;
+        static constexpr double g_jadeRate = 0.1;
     };
 }
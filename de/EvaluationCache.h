@@ -0,0 +1,485 @@
+/**
+ * \file EvaluationCache.h
+ * \author Milos Stojanovic Stojke (milsto)
+ *
+ * Bounded cache of cost function and constraint evaluations for deterministic, expensive cost
+ * functions.
+ */
+
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <thread>
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+#include <limits>
+
+#include "DifferentialEvolution.h"
+
+namespace de
+{
+    /**
+     * Bounded set associative cache mapping agents to a fixed number of values.
+     *
+     * The hash of an agent selects a set of g_ways entries, and a full set evicts with the CLOCK policy
+     * (second chance), which approximates LRU without moving entries. Memory is allocated once for the
+     * given capacity. Every set has its own spin lock, so parallel evaluators rarely contend.
+     *
+     * With quantum 0 agents match only if all parameters are bitwise equal. With a positive quantum
+     * parameters are rounded to multiples of quantum and agents in the same cell share the values of
+     * the first one inserted.
+     */
+    class EvaluationCache
+    {
+    public:
+        static const unsigned int g_ways = 8;
+
+        struct Statistics
+        {
+            std::uint64_t hits;
+            std::uint64_t misses;
+            std::uint64_t evictions;
+        };
+
+        /**
+         * \param numberOfParameters Dimension of the agents
+         * \param numberOfValues Number of values stored per agent
+         * \param capacity Maximal number of cached agents, rounded up to a multiple of g_ways
+         * \param quantum Grid of the cache keys, 0 for exact keys
+         */
+        EvaluationCache(unsigned int numberOfParameters, unsigned int numberOfValues, std::size_t capacity, double quantum) :
+            m_numberOfParameters(numberOfParameters),
+            m_numberOfValues(numberOfValues),
+            m_quantum(quantum),
+            m_numberOfSets(std::max<std::size_t>(1, (capacity + g_ways - 1) / g_ways)),
+            m_hits(0),
+            m_misses(0),
+            m_evictions(0)
+        {
+            assert(quantum >= 0.0);
+
+            m_keys.Resize(m_numberOfSets * g_ways, m_numberOfParameters);
+            m_values.Resize(m_numberOfSets * g_ways, std::max(1u, m_numberOfValues));
+            m_entries.reset(new Entry[m_numberOfSets * g_ways]);
+            m_sets.reset(new Set[m_numberOfSets]);
+            Clear();
+        }
+
+        /**
+         * Copy the values of a cached agent, returns false if the agent is not cached.
+         */
+        bool Lookup(const double* inputs, double* values)
+        {
+            const std::uint64_t hash = Hash(inputs);
+            const std::size_t set = static_cast<std::size_t>(hash % m_numberOfSets);
+
+            {
+                SetLock lock(m_sets[set]);
+                for (unsigned int way = 0; way < g_ways; way++)
+                {
+                    Entry& entry = m_entries[set * g_ways + way];
+                    if (entry.valid && entry.hash == hash && KeyEquals(set * g_ways + way, inputs))
+                    {
+                        entry.referenced = true;
+                        std::memcpy(values, m_values.RowData(set * g_ways + way), m_numberOfValues * sizeof(double));
+                        m_hits.fetch_add(1, std::memory_order_relaxed);
+                        return true;
+                    }
+                }
+            }
+
+            m_misses.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+
+        void Insert(const double* inputs, const double* values)
+        {
+            const std::uint64_t hash = Hash(inputs);
+            const std::size_t set = static_cast<std::size_t>(hash % m_numberOfSets);
+
+            SetLock lock(m_sets[set]);
+            Set& state = m_sets[set];
+
+            // Another thread may have inserted the same agent meanwhile
+            unsigned int victim = g_ways;
+            for (unsigned int way = 0; way < g_ways; way++)
+            {
+                const Entry& entry = m_entries[set * g_ways + way];
+                if (!entry.valid)
+                {
+                    victim = std::min(victim, way);
+                }
+                else if (entry.hash == hash && KeyEquals(set * g_ways + way, inputs))
+                {
+                    return;
+                }
+            }
+
+            if (victim == g_ways)
+            {
+                // CLOCK: clear reference bits until an entry not used since the last sweep is found
+                while (m_entries[set * g_ways + state.hand].referenced)
+                {
+                    m_entries[set * g_ways + state.hand].referenced = false;
+                    state.hand = (state.hand + 1) % g_ways;
+                }
+                victim = state.hand;
+                state.hand = (state.hand + 1) % g_ways;
+                m_evictions.fetch_add(1, std::memory_order_relaxed);
+            }
+
+            const std::size_t index = set * g_ways + victim;
+            double* key = m_keys.RowData(index);
+            for (unsigned int i = 0; i < m_numberOfParameters; i++)
+            {
+                key[i] = KeyValue(inputs[i]);
+            }
+            std::memcpy(m_values.RowData(index), values, m_numberOfValues * sizeof(double));
+
+            Entry& entry = m_entries[index];
+            entry.hash = hash;
+            entry.valid = true;
+            entry.referenced = false;
+        }
+
+        Statistics GetStatistics() const
+        {
+            Statistics statistics;
+            statistics.hits = m_hits.load(std::memory_order_relaxed);
+            statistics.misses = m_misses.load(std::memory_order_relaxed);
+            statistics.evictions = m_evictions.load(std::memory_order_relaxed);
+            return statistics;
+        }
+
+        void ResetStatistics()
+        {
+            m_hits.store(0);
+            m_misses.store(0);
+            m_evictions.store(0);
+        }
+
+        /**
+         * Remove all cached agents. Must not be called concurrently with lookups or inserts.
+         */
+        void Clear()
+        {
+            for (std::size_t i = 0; i < m_numberOfSets * g_ways; i++)
+            {
+                m_entries[i].valid = false;
+                m_entries[i].referenced = false;
+            }
+            for (std::size_t s = 0; s < m_numberOfSets; s++)
+            {
+                m_sets[s].lock.clear();
+                m_sets[s].hand = 0;
+            }
+        }
+
+    private:
+        struct Entry
+        {
+            std::uint64_t hash;
+            bool valid;
+            bool referenced;
+        };
+
+        struct Set
+        {
+            std::atomic_flag lock;
+            unsigned int hand;
+        };
+
+        class SetLock
+        {
+        public:
+            explicit SetLock(Set& set) :
+                m_set(set)
+            {
+                while (m_set.lock.test_and_set(std::memory_order_acquire))
+                {
+                    std::this_thread::yield();
+                }
+            }
+
+            ~SetLock()
+            {
+                m_set.lock.clear(std::memory_order_release);
+            }
+
+        private:
+            Set& m_set;
+        };
+
+        double KeyValue(double value) const
+        {
+            return m_quantum > 0.0 ? std::floor(value / m_quantum + 0.5) : value;
+        }
+
+        std::uint64_t Hash(const double* inputs) const
+        {
+            std::uint64_t hash = 0x9E3779B97F4A7C15ull;
+            for (unsigned int i = 0; i < m_numberOfParameters; i++)
+            {
+                const double value = KeyValue(inputs[i]);
+                std::uint64_t bits;
+                std::memcpy(&bits, &value, sizeof(bits));
+                hash = (hash ^ bits) * 0xBF58476D1CE4E5B9ull;
+                hash ^= hash >> 31;
+            }
+            return hash;
+        }
+
+        bool KeyEquals(std::size_t entry, const double* inputs) const
+        {
+            const double* key = m_keys.RowData(entry);
+            for (unsigned int i = 0; i < m_numberOfParameters; i++)
+            {
+                const double value = KeyValue(inputs[i]);
+                if (std::memcmp(&key[i], &value, sizeof(double)) != 0)
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        unsigned int m_numberOfParameters;
+        unsigned int m_numberOfValues;
+        double m_quantum;
+        std::size_t m_numberOfSets;
+
+        AlignedMatrix m_keys;
+        AlignedMatrix m_values;
+        std::unique_ptr<Entry[]> m_entries;
+        std::unique_ptr<Set[]> m_sets;
+
+        std::atomic<std::uint64_t> m_hits;
+        std::atomic<std::uint64_t> m_misses;
+        std::atomic<std::uint64_t> m_evictions;
+    };
+
+    /**
+     * Cost function decorator remembering costs of already evaluated agents in an EvaluationCache.
+     * Two threads missing the same agent at the same time both evaluate it.
+     *
+     * The wrapped cost function must be deterministic. Wrap cost functions with general constraints
+     * in CachedConstrainedOptimizable, this class hides the constraints from the optimizer.
+     */
+    class CachedOptimizable : public IOptimizable
+    {
+    public:
+        static const unsigned int g_ways = EvaluationCache::g_ways;
+
+        typedef EvaluationCache::Statistics Statistics;
+
+        /**
+         * \param cost Wrapped cost function
+         * \param capacity Maximal number of cached agents, rounded up to a multiple of g_ways
+         * \param quantum Grid of the cache keys, 0 for exact keys
+         */
+        explicit CachedOptimizable(const IOptimizable& cost, std::size_t capacity = 1 << 16, double quantum = 0.0) :
+            m_cost(cost),
+            m_cache(cost.NumberOfParameters(), 1, capacity, quantum)
+        {
+            // General constraints would be hidden from the optimizer, use CachedConstrainedOptimizable
+            assert(dynamic_cast<const IConstrainedOptimizable*>(&cost) == nullptr);
+        }
+
+        double EvaluteCost(std::vector<double> inputs) const override
+        {
+            return EvaluateCost(inputs.data(), inputs.size());
+        }
+
+        double EvaluateCost(const double* inputs, std::size_t size) const override
+        {
+            assert(size == m_cost.NumberOfParameters());
+
+            double cost;
+            if (m_cache.Lookup(inputs, &cost))
+            {
+                return cost;
+            }
+
+            cost = m_cost.EvaluateCost(inputs, size);
+            m_cache.Insert(inputs, &cost);
+            return cost;
+        }
+
+        using IOptimizable::EvaluateCost;
+
+        /**
+         * Cached agents are answered from the cache, consecutive misses are passed to the wrapped
+         * cost function as one batch.
+         */
+        void EvaluateBatch(const double* inputs, std::size_t count, std::size_t stride, double* costs) const override
+        {
+            std::size_t i = 0;
+            while (i < count)
+            {
+                if (m_cache.Lookup(inputs + i * stride, costs + i))
+                {
+                    i++;
+                    continue;
+                }
+
+                std::size_t end = i + 1;
+                while (end < count && !m_cache.Lookup(inputs + end * stride, costs + end))
+                {
+                    end++;
+                }
+
+                m_cost.EvaluateBatch(inputs + i * stride, end - i, stride, costs + i);
+                for (std::size_t j = i; j < end; j++)
+                {
+                    m_cache.Insert(inputs + j * stride, costs + j);
+                }
+
+                // Row end, if any, was a hit and its cost is already set
+                i = end + 1;
+            }
+        }
+
+        unsigned int NumberOfParameters() const override
+        {
+            return m_cost.NumberOfParameters();
+        }
+
+        std::vector<Constraints> GetConstraints() const override
+        {
+            return m_cost.GetConstraints();
+        }
+
+        Statistics GetStatistics() const
+        {
+            return m_cache.GetStatistics();
+        }
+
+        void ResetStatistics()
+        {
+            m_cache.ResetStatistics();
+        }
+
+        /**
+         * Remove all cached agents. Must not be called concurrently with evaluations.
+         */
+        void Clear()
+        {
+            m_cache.Clear();
+        }
+
+    private:
+        const IOptimizable& m_cost;
+
+        // Cache storage is logically const, it does not change results
+        mutable EvaluationCache m_cache;
+    };
+
+    /**
+     * Decorator of a cost function with general constraints, caching the objective like
+     * CachedOptimizable and the constraint violations in a second cache of the same capacity.
+     * The optimizer evaluates constraints before the objective, and skips the objective of some
+     * agents, so the two are cached independently.
+     */
+    class CachedConstrainedOptimizable : public IConstrainedOptimizable
+    {
+    public:
+        typedef EvaluationCache::Statistics Statistics;
+
+        /**
+         * \param cost Wrapped cost function
+         * \param capacity Maximal number of cached agents of each cache, rounded up to a multiple of EvaluationCache::g_ways
+         * \param quantum Grid of the cache keys, 0 for exact keys
+         */
+        explicit CachedConstrainedOptimizable(const IConstrainedOptimizable& cost, std::size_t capacity = 1 << 16, double quantum = 0.0) :
+            m_cost(cost),
+            m_objective(cost.NumberOfParameters(), 1, capacity, quantum),
+            m_constraints(cost.NumberOfParameters(), cost.NumberOfConstraints(), capacity, quantum)
+        {
+
+        }
+
+        double EvaluteCost(std::vector<double> inputs) const override
+        {
+            return EvaluateCost(inputs.data(), inputs.size());
+        }
+
+        double EvaluateCost(const double* inputs, std::size_t size) const override
+        {
+            assert(size == m_cost.NumberOfParameters());
+
+            double cost;
+            if (m_objective.Lookup(inputs, &cost))
+            {
+                return cost;
+            }
+
+            cost = m_cost.EvaluateCost(inputs, size);
+            m_objective.Insert(inputs, &cost);
+            return cost;
+        }
+
+        using IOptimizable::EvaluateCost;
+
+        void EvaluateConstraints(const double* inputs, std::size_t size, double* violations) const override
+        {
+            if (m_constraints.Lookup(inputs, violations))
+            {
+                return;
+            }
+
+            m_cost.EvaluateConstraints(inputs, size, violations);
+            m_constraints.Insert(inputs, violations);
+        }
+
+        unsigned int NumberOfConstraints() const override
+        {
+            return m_cost.NumberOfConstraints();
+        }
+
+        unsigned int NumberOfParameters() const override
+        {
+            return m_cost.NumberOfParameters();
+        }
+
+        std::vector<Constraints> GetConstraints() const override
+        {
+            return m_cost.GetConstraints();
+        }
+
+        Statistics GetStatistics() const
+        {
+            return m_objective.GetStatistics();
+        }
+
+        Statistics GetConstraintStatistics() const
+        {
+            return m_constraints.GetStatistics();
+        }
+
+        void ResetStatistics()
+        {
+            m_objective.ResetStatistics();
+            m_constraints.ResetStatistics();
+        }
+
+        /**
+         * Remove all cached agents. Must not be called concurrently with evaluations.
+         */
+        void Clear()
+        {
+            m_objective.Clear();
+            m_constraints.Clear();
+        }
+
+    private:
+        const IConstrainedOptimizable& m_cost;
+
+        // Cache storage is logically const, it does not change results
+        mutable EvaluationCache m_objective;
+        mutable EvaluationCache m_constraints;
+    };
+}
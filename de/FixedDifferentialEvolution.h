@@ -0,0 +1,412 @@
+/**
+ * \file FixedDifferentialEvolution.h
+ * \author Milos Stojanovic Stojke (milsto)
+ *
+ * Differential evolution for problems whose dimension is known at compile time.
+ */
+
+#pragma once
+
+#include <array>
+#include <vector>
+#include <cassert>
+#include <cstdint>
+#include <iostream>
+#include <iomanip>
+#include <utility>
+#include <limits>
+#include <functional>
+#include <type_traits>
+
+#include "DifferentialEvolution.h"
+
+namespace de
+{
+    /**
+     * Cost function interface with compile time number of parameters.
+     */
+    template<typename T, std::size_t N>
+    class IFixedOptimizable
+    {
+    public:
+        typedef IOptimizable::Constraints Constraints;
+        typedef std::array<T, N> Agent;
+
+        virtual T EvaluteCost(const Agent& inputs) const = 0;
+        virtual std::array<Constraints, N> GetConstraints() const = 0;
+        virtual ~IFixedOptimizable() {}
+
+        static constexpr std::size_t NumberOfParameters()
+        {
+            return N;
+        }
+    };
+
+    namespace detail
+    {
+        /**
+         * Calls f(I), f(I + 1), ..., f(N - 1) with the loop fully unrolled at compile time.
+         */
+        template<std::size_t I, std::size_t N>
+        struct StaticFor
+        {
+            template<typename Function>
+            static void Apply(Function& f)
+            {
+                f(I);
+                StaticFor<I + 1, N>::Apply(f);
+            }
+        };
+
+        template<std::size_t N>
+        struct StaticFor<N, N>
+        {
+            template<typename Function>
+            static void Apply(Function&)
+            {
+
+            }
+        };
+
+        /**
+         * Plain loop used instead of StaticFor for long vectors to keep compile times bounded.
+         */
+        template<std::size_t N>
+        struct LoopFor
+        {
+            template<typename Function>
+            static void Apply(Function& f)
+            {
+                for (std::size_t i = 0; i < N; i++)
+                {
+                    f(i);
+                }
+            }
+        };
+
+        template<std::size_t N>
+        struct UnrolledFor : std::conditional<(N <= 64), StaticFor<0, N>, LoopFor<N>>::type
+        {
+
+        };
+    }
+
+    /**
+     * Differential Evolution optimizer (DE/rand/1/bin) specialized for a compile time dimension N.
+     *
+     * Agents are std::array<T, N> stored in a single contiguous vector and all per-dimension loops
+     * are unrolled. Engine is the per-agent random engine, see RandomEngine. For the same seed and
+     * an equivalent cost function results match the runtime dimension DifferentialEvolution optimizer
+     * with T = double, provided neither is compiled with floating point contraction (use
+     * -ffp-contract=off with GCC and Clang when targeting FMA capable hardware).
+     */
+    template<typename T, std::size_t N, typename Engine = RandomEngine>
+    class FixedDifferentialEvolution
+    {
+        static_assert(N > 0, "Number of parameters must be positive");
+
+    public:
+        typedef IFixedOptimizable<T, N> Optimizable;
+        typedef typename Optimizable::Agent Agent;
+        typedef typename Optimizable::Constraints Constraints;
+
+        /**
+         * Construct Differential Evolution optimizer
+         *
+         * \param costFunction Cost function to minimize
+         * \param populationSize Number of agents in each optimization step
+         * \param randomSeed Set random seed to a fix value to have repeatable (non stochastic) experiments
+         * \param shouldCheckConstraints Should constraints be checked for each new candidate.
+         * \param callback Optional callback to be called after each optimization iteration has finished.
+         * \param terminationCondition Optional condition evaluated after each iteration, optimization stops when it is true.
+         */
+        FixedDifferentialEvolution( const Optimizable& costFunction,
+                                    unsigned int populationSize,
+                                    int randomSeed = 123,
+                                    bool shouldCheckConstraints = true,
+                                    std::function<void(const FixedDifferentialEvolution&)> callback = nullptr,
+                                    std::function<bool(const FixedDifferentialEvolution&)> terminationCondition = nullptr) :
+            m_cost(costFunction),
+            m_populationSize(populationSize),
+            m_F(0.8),
+            m_CR(0.9),
+            m_shouldCheckConstraints(shouldCheckConstraints),
+            m_callback(callback),
+            m_terminationCondition(terminationCondition),
+            m_bestAgentIndex(0),
+            m_minCost(std::numeric_limits<T>::infinity())
+        {
+            assert(m_populationSize >= 4);
+
+            m_agentGenerators.reserve(m_populationSize);
+            for (unsigned int x = 0; x < m_populationSize; x++)
+            {
+                m_agentGenerators.push_back(Engine(static_cast<std::uint64_t>(randomSeed), x));
+            }
+
+            m_population.resize(m_populationSize);
+            m_trials.resize(m_populationSize);
+            m_minCostPerAgent.resize(m_populationSize);
+            m_trialCosts.resize(m_populationSize);
+
+            m_constraints = costFunction.GetConstraints();
+        }
+
+        void InitPopulation()
+        {
+            for (unsigned int x = 0; x < m_populationSize; x++)
+            {
+                for (std::size_t i = 0; i < N; i++)
+                {
+                    double lower = m_constraints[i].isConstrained ? m_constraints[i].lower : -std::numeric_limits<double>::infinity();
+                    double upper = m_constraints[i].isConstrained ? m_constraints[i].upper : std::numeric_limits<double>::infinity();
+
+                    m_population[x][i] = static_cast<T>(UniformReal(m_agentGenerators[x], lower, upper));
+                }
+            }
+
+            m_minCost = std::numeric_limits<T>::infinity();
+            m_bestAgentIndex = 0;
+            for (unsigned int x = 0; x < m_populationSize; x++)
+            {
+                m_minCostPerAgent[x] = m_cost.EvaluteCost(m_population[x]);
+
+                if (m_minCostPerAgent[x] < m_minCost)
+                {
+                    m_minCost = m_minCostPerAgent[x];
+                    m_bestAgentIndex = x;
+                }
+            }
+        }
+
+        void SelectionAndCorssing()
+        {
+            // Build all trial vectors first so the generation is synchronous
+            for (unsigned int x = 0; x < m_populationSize; x++)
+            {
+                BuildTrial(x);
+            }
+
+            for (unsigned int x = 0; x < m_populationSize; x++)
+            {
+                m_trialCosts[x] = m_cost.EvaluteCost(m_trials[x]);
+            }
+
+            T minCost = std::numeric_limits<T>::infinity();
+            unsigned int bestAgentIndex = 0;
+
+            for (unsigned int x = 0; x < m_populationSize; x++)
+            {
+                if (m_trialCosts[x] < m_minCostPerAgent[x])
+                {
+                    m_population[x] = m_trials[x];
+                    m_minCostPerAgent[x] = m_trialCosts[x];
+                }
+
+                if (m_minCostPerAgent[x] < minCost)
+                {
+                    minCost = m_minCostPerAgent[x];
+                    bestAgentIndex = x;
+                }
+            }
+
+            m_minCost = minCost;
+            m_bestAgentIndex = bestAgentIndex;
+        }
+
+        const Agent& GetBestAgent() const
+        {
+            return m_population[m_bestAgentIndex];
+        }
+
+        T GetBestCost() const
+        {
+            return m_minCostPerAgent[m_bestAgentIndex];
+        }
+
+        std::vector<std::pair<Agent, T>> GetPopulationWithCosts() const
+        {
+            std::vector<std::pair<Agent, T>> toRet;
+            for (unsigned int i = 0; i < m_populationSize; i++)
+            {
+                toRet.push_back(std::make_pair(m_population[i], m_minCostPerAgent[i]));
+            }
+
+            return toRet;
+        }
+
+        void Optimize(int iterations, bool verbose = true)
+        {
+            InitPopulation();
+
+            for (int i = 0; i < iterations; i++)
+            {
+                SelectionAndCorssing();
+
+                if (verbose)
+                {
+                    std::cout << std::fixed << std::setprecision(5);
+                    std::cout << "Current minimal cost: " << m_minCost << "\t\t";
+                    std::cout << "Best agent: ";
+                    for (std::size_t j = 0; j < N; j++)
+                    {
+                        std::cout << m_population[m_bestAgentIndex][j] << " ";
+                    }
+                    std::cout << std::endl;
+                }
+
+                if (m_callback)
+                {
+                    m_callback(*this);
+                }
+
+                if (m_terminationCondition && m_terminationCondition(*this))
+                {
+                    if (verbose)
+                    {
+                        std::cout << "Terminated due to positive evaluation of the termination condition." << std::endl;
+                    }
+                    return;
+                }
+            }
+
+            if (verbose)
+            {
+                std::cout << "Terminated due to exceeding total number of generations." << std::endl;
+            }
+        }
+
+    private:
+        struct DonorCrossover
+        {
+            Agent& trial;
+            const Agent& a;
+            const Agent& b;
+            const Agent& c;
+            const Agent& x;
+            T F;
+            T CR;
+
+            void operator()(std::size_t i) const
+            {
+                trial[i] = trial[i] < CR ? a[i] + F * (b[i] - c[i]) : x[i];
+            }
+        };
+
+        struct ConstraintCheck
+        {
+            const Agent& agent;
+            const std::array<Constraints, N>& constraints;
+            bool& valid;
+
+            void operator()(std::size_t i) const
+            {
+                valid = valid && constraints[i].Check(agent[i]);
+            }
+        };
+
+        /**
+         * Moves a violating parameter between its bound and the parent, the same repair the runtime
+         * optimizer applies once rejection gives up.
+         */
+        struct BounceBackRepair
+        {
+            Agent& trial;
+            const Agent& parent;
+            const std::array<Constraints, N>& constraints;
+            Engine& generator;
+
+            void operator()(std::size_t i) const
+            {
+                if (!constraints[i].isConstrained)
+                {
+                    return;
+                }
+
+                const double value = static_cast<double>(trial[i]);
+                const double origin = static_cast<double>(parent[i]);
+                if (value < constraints[i].lower)
+                {
+                    trial[i] = static_cast<T>(constraints[i].lower + UniformReal(generator) * (origin - constraints[i].lower));
+                }
+                else if (value > constraints[i].upper)
+                {
+                    trial[i] = static_cast<T>(constraints[i].upper - UniformReal(generator) * (constraints[i].upper - origin));
+                }
+            }
+        };
+
+        void BuildTrial(unsigned int x)
+        {
+            Engine& generator = m_agentGenerators[x];
+
+            unsigned int attempts = 0;
+            while (true)
+            {
+                std::uint32_t indices[3];
+                SampleDistinct(generator, m_populationSize, x, indices, 3);
+                const std::uint32_t a = indices[0];
+                const std::uint32_t b = indices[1];
+                const std::uint32_t c = indices[2];
+
+                Agent& trial = m_trials[x];
+
+                std::size_t R = UniformIndex(generator, static_cast<std::uint32_t>(N));
+
+                // Crossover randoms are kept in the trial until the blend overwrites them
+                for (std::size_t i = 0; i < N; i++)
+                {
+                    trial[i] = static_cast<T>(UniformReal(generator));
+                }
+
+                DonorCrossover blend = { trial, m_population[a], m_population[b], m_population[c], m_population[x], m_F, m_CR };
+                detail::UnrolledFor<N>::Apply(blend);
+                trial[R] = m_population[a][R] + m_F * (m_population[b][R] - m_population[c][R]);
+
+                if (m_shouldCheckConstraints)
+                {
+                    bool valid = true;
+                    ConstraintCheck check = { trial, m_constraints, valid };
+                    detail::UnrolledFor<N>::Apply(check);
+                    if (!valid)
+                    {
+                        // Rejection is bounded, near the bounds it could otherwise retry for a very long time
+                        if (++attempts < g_maxRejections)
+                        {
+                            continue;
+                        }
+
+                        BounceBackRepair repair = { trial, m_population[x], m_constraints, generator };
+                        detail::UnrolledFor<N>::Apply(repair);
+                    }
+                }
+
+                return;
+            }
+        }
+
+        const Optimizable& m_cost;
+        unsigned int m_populationSize;
+        T m_F;
+        T m_CR;
+
+        bool m_shouldCheckConstraints;
+
+        std::function<void(const FixedDifferentialEvolution&)> m_callback;
+        std::function<bool(const FixedDifferentialEvolution&)> m_terminationCondition;
+
+        std::vector<Engine> m_agentGenerators;
+        std::vector<Agent> m_population;
+        std::vector<Agent> m_trials;
+        std::vector<T> m_minCostPerAgent;
+        std::vector<T> m_trialCosts;
+
+        std::array<Constraints, N> m_constraints;
+
+        unsigned int m_bestAgentIndex;
+        T m_minCost;
+
+        // Number of rejected trials of an agent before the trial is repaired, matches DifferentialEvolution
+        static constexpr unsigned int g_maxRejections = 100;
+    };
+}
@@ -0,0 +1,507 @@
+/**
+ * \file IslandModel.h
+ * \author Milos Stojanovic Stojke (milsto)
+ *
+ * Island model: several Differential Evolution populations evolving on separate threads and
+ * periodically exchanging their best agents.
+ */
+
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <cassert>
+#include <cstdint>
+#include <iostream>
+#include <iomanip>
+#include <limits>
+#include <algorithm>
+
+#include "DifferentialEvolution.h"
+
+namespace de
+{
+    /**
+     * Islands from which each island receives migrants.
+     *
+     * Ring: the previous island.
+     * Torus: the four neighbours in a two dimensional grid with wrap around.
+     * FullyConnected: all other islands.
+     * Random: one random other island, chosen again at each migration.
+     */
+    enum class MigrationTopology
+    {
+        Ring,
+        Torus,
+        FullyConnected,
+        Random
+    };
+
+    /**
+     * Agents replaced by immigrants.
+     *
+     * Worst: the worst agents, only by immigrants better than them.
+     * Random: random agents other than the island best.
+     */
+    enum class ReplacementPolicy
+    {
+        Worst,
+        Random
+    };
+
+    /**
+     * Order the first count entries of selected as the best (or worst) agents of an island, compared
+     * the way the island's selection compares them, returns
+     * count clamped to the population size. Selected grows with the population, restarts of the
+     * island may enlarge it between migrations and population size reduction may shrink it below count.
+     */
+    inline unsigned int SelectAgents(const DifferentialEvolution& island, unsigned int count, bool best, std::vector<std::uint32_t>& selected)
+    {
+        const unsigned int size = island.GetPopulationSize();
+        count = std::min(count, size);
+        if (selected.size() < size)
+        {
+            selected.resize(size);
+        }
+        for (unsigned int i = 0; i < size; i++)
+        {
+            selected[i] = i;
+        }
+
+        std::partial_sort(selected.begin(), selected.begin() + count, selected.begin() + size,
+            [&island, best](std::uint32_t left, std::uint32_t right)
+            {
+                if (island.IsAgentBetter(left, right))
+                {
+                    return best;
+                }
+                if (island.IsAgentBetter(right, left))
+                {
+                    return !best;
+                }
+                return left < right;
+            });
+        return count;
+    }
+
+    /**
+     * Fill sources with the islands from which island i of n receives migrants.
+     */
+    template<typename Engine>
+    void MigrationSources(MigrationTopology topology, unsigned int i, unsigned int n, Engine& engine, std::vector<std::uint32_t>& sources)
+    {
+        sources.clear();
+
+        if (n == 1)
+        {
+            return;
+        }
+
+        switch (topology)
+        {
+        case MigrationTopology::Ring:
+            sources.push_back((i + n - 1) % n);
+            break;
+        case MigrationTopology::Torus:
+        {
+            // Grid as close to square as possible
+            unsigned int rows = 1;
+            for (unsigned int r = 1; r * r <= n; r++)
+            {
+                if (n % r == 0)
+                {
+                    rows = r;
+                }
+            }
+            const unsigned int columns = n / rows;
+            const unsigned int row = i / columns;
+            const unsigned int column = i % columns;
+
+            const unsigned int neighbours[4] = {
+                ((row + rows - 1) % rows) * columns + column,
+                ((row + 1) % rows) * columns + column,
+                row * columns + (column + columns - 1) % columns,
+                row * columns + (column + 1) % columns
+            };
+            for (unsigned int neighbour : neighbours)
+            {
+                if (neighbour != i && std::find(sources.begin(), sources.end(), neighbour) == sources.end())
+                {
+                    sources.push_back(neighbour);
+                }
+            }
+            break;
+        }
+        case MigrationTopology::FullyConnected:
+            for (unsigned int j = 0; j < n; j++)
+            {
+                if (j != i)
+                {
+                    sources.push_back(j);
+                }
+            }
+            break;
+        case MigrationTopology::Random:
+        {
+            const unsigned int j = UniformIndex(engine, n - 1);
+            sources.push_back(j < i ? j : j + 1);
+            break;
+        }
+        }
+    }
+
+    /**
+     * Move the best migrationSize candidates to the front, returns their count. better(left, right)
+     * compares two candidates.
+     */
+    template<typename Better>
+    unsigned int SelectImmigrants(std::vector<std::uint32_t>& candidates, unsigned int migrationSize, Better better)
+    {
+        const unsigned int count = std::min<unsigned int>(migrationSize, static_cast<unsigned int>(candidates.size()));
+        std::partial_sort(candidates.begin(), candidates.begin() + count, candidates.end(),
+            [&better](std::uint32_t left, std::uint32_t right)
+            {
+                return better(left, right) || (!better(right, left) && left < right);
+            });
+        return count;
+    }
+
+    /**
+     * Insert immigrants, given as row indices of agents, costs and constraint violations, into an
+     * island according to the replacement policy.
+     */
+    template<typename Engine>
+    void ReceiveImmigrants(DifferentialEvolution& island, ReplacementPolicy policy, const AlignedMatrix& agents, const double* costs, const double* violations,
+                           const std::uint32_t* immigrants, unsigned int count, Engine& engine, std::vector<std::uint32_t>& selected)
+    {
+        if (policy == ReplacementPolicy::Worst)
+        {
+            const unsigned int replaced = SelectAgents(island, count, false, selected);
+            for (unsigned int k = 0; k < replaced; k++)
+            {
+                const std::uint32_t immigrant = immigrants[k];
+                if (island.IsBetter(costs[immigrant], violations[immigrant], island.GetAgentCost(selected[k]), island.GetAgentViolation(selected[k])))
+                {
+                    island.ReplaceAgent(selected[k], agents.RowData(immigrant), costs[immigrant], violations[immigrant]);
+                }
+            }
+        }
+        else
+        {
+            const unsigned int size = island.GetPopulationSize();
+            const unsigned int best = island.GetBestAgentIndex();
+            for (unsigned int k = 0; k < count; k++)
+            {
+                const std::uint32_t target = UniformIndex(engine, size - 1);
+                const std::uint32_t immigrant = immigrants[k];
+                island.ReplaceAgent(target < best ? target : target + 1, agents.RowData(immigrant), costs[immigrant], violations[immigrant]);
+            }
+        }
+    }
+
+    /**
+     * Island model built from DifferentialEvolution populations.
+     *
+     * Islands evolve independently on the thread pool and share no data between migrations. Every
+     * migration interval generations all islands send copies of their best agents, then each island
+     * takes the best migration size of the agents sent by its sources. Migration is synchronous,
+     * so for a given seed results do not depend on the number of threads. With general constraints
+     * emigrants, immigrants and the best island are compared by constraint violation first, the same
+     * way the islands compare agents in selection.
+     *
+     * The cost function is called concurrently from several threads.
+     */
+    class IslandModel
+    {
+    public:
+        /**
+         * Construct island model
+         *
+         * \param costFunction Cost function to minimize
+         * \param numberOfIslands Number of populations
+         * \param populationSize Number of agents of each island
+         * \param randomSeed Seed of the first island, island i uses randomSeed + i
+         * \param shouldCheckConstraints Should constraints be checked for each new candidate.
+         */
+        IslandModel(const IOptimizable& costFunction,
+                    unsigned int numberOfIslands,
+                    unsigned int populationSize,
+                    int randomSeed = 123,
+                    bool shouldCheckConstraints = true) :
+            m_topology(MigrationTopology::Ring),
+            m_replacementPolicy(ReplacementPolicy::Worst),
+            m_migrationInterval(10),
+            m_migrationSize(1),
+            m_generation(0),
+            m_generator(static_cast<std::uint64_t>(randomSeed), g_migrationStreams)
+        {
+            assert(numberOfIslands >= 1);
+
+            for (unsigned int i = 0; i < numberOfIslands; i++)
+            {
+                m_islands.emplace_back(new DifferentialEvolution(costFunction, populationSize, randomSeed + static_cast<int>(i), shouldCheckConstraints));
+            }
+
+            m_numberOfParameters = costFunction.NumberOfParameters();
+            m_selected.resize(populationSize);
+            SetMigrationSize(m_migrationSize);
+            SetNumberOfThreads(0);
+        }
+
+        /**
+         * Set number of threads running the islands, 0 uses all hardware threads. Islands themselves
+         * are single threaded.
+         */
+        void SetNumberOfThreads(unsigned int numberOfThreads)
+        {
+            if (numberOfThreads == 0)
+            {
+                numberOfThreads = std::max(1u, std::thread::hardware_concurrency());
+            }
+            numberOfThreads = std::min(numberOfThreads, GetNumberOfIslands());
+
+            if (numberOfThreads == 1)
+            {
+                m_threadPool.reset();
+            }
+            else if (!m_threadPool || m_threadPool->NumberOfThreads() != numberOfThreads)
+            {
+                m_threadPool.reset(new ThreadPool(numberOfThreads));
+            }
+        }
+
+        void SetTopology(MigrationTopology topology)
+        {
+            m_topology = topology;
+        }
+
+        void SetReplacementPolicy(ReplacementPolicy policy)
+        {
+            m_replacementPolicy = policy;
+        }
+
+        /**
+         * Set number of generations between migrations (default 10).
+         */
+        void SetMigrationInterval(unsigned int generations)
+        {
+            assert(generations >= 1);
+            m_migrationInterval = generations;
+        }
+
+        /**
+         * Set number of agents each island sends and receives at a migration (default 1).
+         */
+        void SetMigrationSize(unsigned int numberOfAgents)
+        {
+            assert(numberOfAgents >= 1 && numberOfAgents < m_islands[0]->GetPopulationSize());
+            m_migrationSize = numberOfAgents;
+
+            m_emigrants.Resize(GetNumberOfIslands() * m_migrationSize, m_numberOfParameters);
+            m_emigrantCosts.Resize(GetNumberOfIslands() * m_migrationSize);
+            m_emigrantViolations.Resize(GetNumberOfIslands() * m_migrationSize);
+            m_emigrantCounts.resize(GetNumberOfIslands());
+            m_candidates.reserve(GetNumberOfIslands() * m_migrationSize);
+        }
+
+        unsigned int GetNumberOfIslands() const
+        {
+            return static_cast<unsigned int>(m_islands.size());
+        }
+
+        /**
+         * Island optimizer, may be used to select strategy or control parameters per island.
+         */
+        DifferentialEvolution& GetIsland(unsigned int index)
+        {
+            return *m_islands[index];
+        }
+
+        const DifferentialEvolution& GetIsland(unsigned int index) const
+        {
+            return *m_islands[index];
+        }
+
+        void InitPopulation()
+        {
+            m_generation = 0;
+
+            auto init = [this](std::size_t begin, std::size_t end, unsigned int)
+            {
+                for (std::size_t i = begin; i < end; i++)
+                {
+                    m_islands[i]->InitPopulation();
+                }
+            };
+            ParallelFor(init);
+        }
+
+        /**
+         * Run the given number of generations on all islands, migrating every migration interval
+         * generations.
+         */
+        void Evolve(unsigned int generations)
+        {
+            while (generations > 0)
+            {
+                const unsigned int untilMigration = m_migrationInterval - m_generation % m_migrationInterval;
+                const unsigned int steps = std::min(generations, untilMigration);
+
+                auto evolve = [this, steps](std::size_t begin, std::size_t end, unsigned int)
+                {
+                    for (std::size_t i = begin; i < end; i++)
+                    {
+                        for (unsigned int s = 0; s < steps; s++)
+                        {
+                            m_islands[i]->SelectionAndCorssing();
+                        }
+                    }
+                };
+                ParallelFor(evolve);
+
+                m_generation += steps;
+                generations -= steps;
+
+                if (m_generation % m_migrationInterval == 0)
+                {
+                    Migrate();
+                }
+            }
+        }
+
+        void Optimize(int iterations, bool verbose = true)
+        {
+            InitPopulation();
+
+            for (int i = 0; i < iterations; i += m_migrationInterval)
+            {
+                Evolve(std::min<unsigned int>(m_migrationInterval, iterations - i));
+
+                if (verbose)
+                {
+                    std::cout << std::fixed << std::setprecision(5);
+                    std::cout << "Generation " << m_generation << "\t\t";
+                    std::cout << "Current minimal cost: " << GetBestCost() << "\t\t";
+                    std::cout << "Island costs: ";
+                    for (const auto& island : m_islands)
+                    {
+                        std::cout << island->GetBestCost() << " ";
+                    }
+                    std::cout << "\n";
+                }
+            }
+
+            if (verbose)
+            {
+                std::cout << "Terminated due to exceeding total number of generations." << std::endl;
+            }
+        }
+
+        unsigned int GetBestIsland() const
+        {
+            unsigned int best = 0;
+            for (unsigned int i = 1; i < GetNumberOfIslands(); i++)
+            {
+                if (IsBetterByFeasibility(m_islands[i]->GetBestCost(), m_islands[i]->GetBestViolation(),
+                                          m_islands[best]->GetBestCost(), m_islands[best]->GetBestViolation()))
+                {
+                    best = i;
+                }
+            }
+            return best;
+        }
+
+        std::vector<double> GetBestAgent() const
+        {
+            return m_islands[GetBestIsland()]->GetBestAgent();
+        }
+
+        double GetBestCost() const
+        {
+            return m_islands[GetBestIsland()]->GetBestCost();
+        }
+
+        unsigned int GetGeneration() const
+        {
+            return m_generation;
+        }
+
+    private:
+        template<typename Function>
+        void ParallelFor(Function& function)
+        {
+            if (m_threadPool)
+            {
+                m_threadPool->ParallelFor(m_islands.size(), 1, function);
+            }
+            else
+            {
+                function(std::size_t(0), m_islands.size(), 0u);
+            }
+        }
+
+        void Migrate()
+        {
+            const unsigned int n = GetNumberOfIslands();
+
+            // Emigrants of all islands are copied first so the exchange does not depend on island order
+            for (unsigned int i = 0; i < n; i++)
+            {
+                const DifferentialEvolution& island = *m_islands[i];
+                // Islands smaller than the migration size send fewer agents
+                m_emigrantCounts[i] = SelectAgents(island, m_migrationSize, true, m_selected);
+                for (unsigned int k = 0; k < m_emigrantCounts[i]; k++)
+                {
+                    m_emigrants.CopyRow(i * m_migrationSize + k, island.GetAgent(m_selected[k]).data());
+                    m_emigrantCosts[i * m_migrationSize + k] = island.GetAgentCost(m_selected[k]);
+                    m_emigrantViolations[i * m_migrationSize + k] = island.GetAgentViolation(m_selected[k]);
+                }
+            }
+
+            for (unsigned int i = 0; i < n; i++)
+            {
+                MigrationSources(m_topology, i, n, m_generator, m_sources);
+
+                m_candidates.clear();
+                for (unsigned int source : m_sources)
+                {
+                    for (unsigned int k = 0; k < m_emigrantCounts[source]; k++)
+                    {
+                        m_candidates.push_back(source * m_migrationSize + k);
+                    }
+                }
+
+                const DifferentialEvolution& island = *m_islands[i];
+                const unsigned int count = SelectImmigrants(m_candidates, m_migrationSize,
+                    [this, &island](std::uint32_t left, std::uint32_t right)
+                    {
+                        return island.IsBetter(m_emigrantCosts[left], m_emigrantViolations[left], m_emigrantCosts[right], m_emigrantViolations[right]);
+                    });
+                ReceiveImmigrants(*m_islands[i], m_replacementPolicy, m_emigrants, m_emigrantCosts.data(), m_emigrantViolations.data(),
+                                  m_candidates.data(), count, m_generator, m_selected);
+            }
+        }
+
+        std::vector<std::unique_ptr<DifferentialEvolution>> m_islands;
+        std::unique_ptr<ThreadPool> m_threadPool;
+
+        MigrationTopology m_topology;
+        ReplacementPolicy m_replacementPolicy;
+        unsigned int m_migrationInterval;
+        unsigned int m_migrationSize;
+        unsigned int m_generation;
+        unsigned int m_numberOfParameters;
+
+        // Used by the random topology and the random replacement policy
+        RandomEngine m_generator;
+
+        // Migration buffers, allocated when the migration size is set
+        AlignedMatrix m_emigrants;
+        AlignedBuffer<double> m_emigrantCosts;
+        AlignedBuffer<double> m_emigrantViolations;
+        std::vector<std::uint32_t> m_emigrantCounts;
+        std::vector<std::uint32_t> m_candidates;
+        std::vector<std::uint32_t> m_sources;
+        std::vector<std::uint32_t> m_selected;
+    };
+}
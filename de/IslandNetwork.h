@@ -0,0 +1,1188 @@
+/**
+ * \file IslandNetwork.h
+ * \author Milos Stojanovic Stojke (milsto)
+ *
+ * Island model across processes. Each island is a DifferentialEvolution optimizer in its own process,
+ * islands exchange agents through a coordinator over Unix domain sockets, TCP or shared memory.
+ * POSIX only.
+ */
+
+#pragma once
+
+#include <vector>
+#include <string>
+#include <memory>
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <cassert>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <algorithm>
+#include <stdexcept>
+#include <system_error>
+
+#include <fcntl.h>
+#include <netdb.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+
+#include "DifferentialEvolution.h"
+#include "IslandModel.h"
+
+namespace de
+{
+    /**
+     * Migration protocol. Every message is a fixed 32 byte header followed by count records of
+     * cost and dimensions parameters, all values in host byte order. Peers must share byte order
+     * and double format, a byte swapped magic is rejected.
+     *
+     * Hello:      island -> coordinator, first message, count is 0.
+     * Migrants:   island -> coordinator, best agents of the island at a migration.
+     * Immigrants: coordinator -> island, agents selected for the island from its sources.
+     * Finished:   island -> coordinator, best agent of the island at the end of the run.
+     */
+    enum class MigrationMessageType : std::uint16_t
+    {
+        Hello = 1,
+        Migrants = 2,
+        Immigrants = 3,
+        Finished = 4
+    };
+
+    struct MigrationMessageHeader
+    {
+        static const std::uint32_t g_magic = 0x474d4544; // "DEMG"
+        static const std::uint16_t g_version = 2;
+
+        std::uint32_t magic;
+        std::uint16_t version;
+        std::uint16_t type;
+        std::uint32_t island;
+        std::uint32_t count;
+        std::uint32_t dimensions;
+        std::uint32_t reserved;
+        std::uint64_t generation;
+    };
+
+    static_assert(sizeof(MigrationMessageHeader) == 32, "Migration header must be 32 bytes");
+
+    /**
+     * Encoded migration message. Agents are stored as records of cost and total constraint violation
+     * followed by parameters.
+     */
+    class MigrationMessage
+    {
+    public:
+        void Reset(MigrationMessageType type, std::uint32_t island, std::uint32_t dimensions, std::uint64_t generation)
+        {
+            MigrationMessageHeader header;
+            header.magic = MigrationMessageHeader::g_magic;
+            header.version = MigrationMessageHeader::g_version;
+            header.type = static_cast<std::uint16_t>(type);
+            header.island = island;
+            header.count = 0;
+            header.dimensions = dimensions;
+            header.reserved = 0;
+            header.generation = generation;
+
+            m_bytes.resize(sizeof(header));
+            std::memcpy(m_bytes.data(), &header, sizeof(header));
+        }
+
+        void Append(const double* agent, double cost, double violation)
+        {
+            MigrationMessageHeader header = Header();
+            const std::size_t offset = m_bytes.size();
+            m_bytes.resize(offset + (header.dimensions + 2) * sizeof(double));
+            std::memcpy(m_bytes.data() + offset, &cost, sizeof(double));
+            std::memcpy(m_bytes.data() + offset + sizeof(double), &violation, sizeof(double));
+            std::memcpy(m_bytes.data() + offset + 2 * sizeof(double), agent, header.dimensions * sizeof(double));
+
+            header.count++;
+            std::memcpy(m_bytes.data(), &header, sizeof(header));
+        }
+
+        /**
+         * Size in bytes of a message with count agents of the given dimension.
+         */
+        static std::size_t Size(std::uint32_t count, std::uint32_t dimensions)
+        {
+            return sizeof(MigrationMessageHeader) + static_cast<std::size_t>(count) * (static_cast<std::size_t>(dimensions) + 2) * sizeof(double);
+        }
+
+        MigrationMessageHeader Header() const
+        {
+            MigrationMessageHeader header;
+            std::memcpy(&header, m_bytes.data(), sizeof(header));
+            return header;
+        }
+
+        MigrationMessageType Type() const
+        {
+            return static_cast<MigrationMessageType>(Header().type);
+        }
+
+        double Cost(std::uint32_t index) const
+        {
+            double cost;
+            std::memcpy(&cost, Record(index), sizeof(double));
+            return cost;
+        }
+
+        double Violation(std::uint32_t index) const
+        {
+            double violation;
+            std::memcpy(&violation, Record(index) + sizeof(double), sizeof(double));
+            return violation;
+        }
+
+        void CopyAgent(std::uint32_t index, double* agent) const
+        {
+            std::memcpy(agent, Record(index) + 2 * sizeof(double), Header().dimensions * sizeof(double));
+        }
+
+        /**
+         * Check magic, version and that the size matches the header.
+         */
+        void Validate() const
+        {
+            if (m_bytes.size() < sizeof(MigrationMessageHeader))
+            {
+                throw std::runtime_error("Migration message is truncated");
+            }
+
+            const MigrationMessageHeader header = Header();
+            if (header.magic != MigrationMessageHeader::g_magic || header.version != MigrationMessageHeader::g_version)
+            {
+                throw std::runtime_error("Migration message has unknown magic or version");
+            }
+            if (m_bytes.size() != Size(header.count, header.dimensions))
+            {
+                throw std::runtime_error("Migration message size does not match its header");
+            }
+        }
+
+        std::vector<char>& Bytes()
+        {
+            return m_bytes;
+        }
+
+        const std::vector<char>& Bytes() const
+        {
+            return m_bytes;
+        }
+
+    private:
+        const char* Record(std::uint32_t index) const
+        {
+            return m_bytes.data() + sizeof(MigrationMessageHeader) + static_cast<std::size_t>(index) * (Header().dimensions + 2) * sizeof(double);
+        }
+
+        std::vector<char> m_bytes;
+    };
+
+    /**
+     * Bidirectional message channel between an island and the coordinator. Receive rejects messages
+     * longer than maxSize bytes before buffering them, so a faulty peer can not make it allocate or
+     * copy an arbitrary amount of memory.
+     */
+    class IMigrationChannel
+    {
+    public:
+        virtual void Send(const MigrationMessage& message) = 0;
+        virtual void Receive(MigrationMessage& message, std::size_t maxSize) = 0;
+        virtual ~IMigrationChannel() {}
+    };
+
+    namespace detail
+    {
+        inline void ThrowSystemError(const char* what)
+        {
+            throw std::system_error(errno, std::generic_category(), what);
+        }
+
+        /**
+         * Split "scheme:address" endpoint.
+         */
+        inline void ParseEndpoint(const std::string& endpoint, std::string& scheme, std::string& address)
+        {
+            const std::size_t colon = endpoint.find(':');
+            if (colon == std::string::npos)
+            {
+                throw std::invalid_argument("Endpoint must be unix:<path>, tcp:<host>:<port> or shm:<name>");
+            }
+            scheme = endpoint.substr(0, colon);
+            address = endpoint.substr(colon + 1);
+        }
+
+        /**
+         * Wait with increasing back off, used by the shared memory mailboxes.
+         */
+        class Backoff
+        {
+        public:
+            Backoff() :
+                m_spins(0)
+            {
+
+            }
+
+            void Wait()
+            {
+                if (m_spins < 64)
+                {
+                    m_spins++;
+                    std::this_thread::yield();
+                }
+                else
+                {
+                    std::this_thread::sleep_for(std::chrono::microseconds(50));
+                }
+            }
+
+        private:
+            unsigned int m_spins;
+        };
+    }
+
+    /**
+     * Length prefixed messages over a connected stream socket (Unix domain or TCP).
+     */
+    class SocketChannel : public IMigrationChannel
+    {
+    public:
+        explicit SocketChannel(int socket) :
+            m_socket(socket)
+        {
+
+        }
+
+        ~SocketChannel() override
+        {
+            ::close(m_socket);
+        }
+
+        SocketChannel(const SocketChannel&) = delete;
+        SocketChannel& operator=(const SocketChannel&) = delete;
+
+        void Send(const MigrationMessage& message) override
+        {
+            const std::uint32_t size = static_cast<std::uint32_t>(message.Bytes().size());
+            Write(&size, sizeof(size));
+            Write(message.Bytes().data(), size);
+        }
+
+        void Receive(MigrationMessage& message, std::size_t maxSize) override
+        {
+            std::uint32_t size = 0;
+            Read(&size, sizeof(size));
+            if (size > maxSize)
+            {
+                throw std::length_error("Migration message exceeds the largest expected size");
+            }
+            message.Bytes().resize(size);
+            Read(message.Bytes().data(), size);
+            message.Validate();
+        }
+
+    private:
+        void Write(const void* data, std::size_t size)
+        {
+#ifdef MSG_NOSIGNAL
+            const int flags = MSG_NOSIGNAL;
+#else
+            const int flags = 0;
+#endif
+            const char* bytes = static_cast<const char*>(data);
+            while (size > 0)
+            {
+                const ssize_t written = ::send(m_socket, bytes, size, flags);
+                if (written < 0)
+                {
+                    if (errno == EINTR)
+                    {
+                        continue;
+                    }
+                    detail::ThrowSystemError("send");
+                }
+                bytes += written;
+                size -= static_cast<std::size_t>(written);
+            }
+        }
+
+        void Read(void* data, std::size_t size)
+        {
+            char* bytes = static_cast<char*>(data);
+            while (size > 0)
+            {
+                const ssize_t received = ::recv(m_socket, bytes, size, 0);
+                if (received < 0)
+                {
+                    if (errno == EINTR)
+                    {
+                        continue;
+                    }
+                    detail::ThrowSystemError("recv");
+                }
+                if (received == 0)
+                {
+                    throw std::runtime_error("Migration peer closed the connection");
+                }
+                bytes += received;
+                size -= static_cast<std::size_t>(received);
+            }
+        }
+
+        int m_socket;
+    };
+
+    /**
+     * Shared memory segment with a pair of mailboxes per island, for islands on the same host.
+     *
+     * Layout: header, then for each island an upstream (island to coordinator) and a downstream
+     * mailbox. A mailbox holds one message, its state flag is a lock-free atomic so it works
+     * across processes.
+     */
+    class SharedMemorySegment
+    {
+    public:
+        static_assert(ATOMIC_INT_LOCK_FREE == 2, "Shared memory transport requires lock-free atomics");
+
+        struct Header
+        {
+            std::atomic<std::uint32_t> ready;
+            std::uint32_t numberOfIslands;
+            std::uint64_t mailboxCapacity;
+        };
+
+        struct Mailbox
+        {
+            std::atomic<std::uint32_t> full;
+            std::uint32_t size;
+        };
+
+        /**
+         * Create the segment, used by the coordinator. An existing segment of the same name is replaced.
+         */
+        static std::shared_ptr<SharedMemorySegment> Create(const std::string& name, unsigned int numberOfIslands, std::size_t mailboxCapacity)
+        {
+            ::shm_unlink(name.c_str());
+            const int fd = ::shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+            if (fd < 0)
+            {
+                detail::ThrowSystemError("shm_open");
+            }
+
+            std::shared_ptr<SharedMemorySegment> segment(new SharedMemorySegment(name, true));
+            segment->m_mailboxStride = MailboxStride(mailboxCapacity);
+            segment->m_size = HeaderSize() + 2 * numberOfIslands * segment->m_mailboxStride;
+            if (::ftruncate(fd, static_cast<off_t>(segment->m_size)) != 0)
+            {
+                ::close(fd);
+                detail::ThrowSystemError("ftruncate");
+            }
+            segment->Map(fd);
+
+            for (unsigned int i = 0; i < 2 * numberOfIslands; i++)
+            {
+                Mailbox* mailbox = new (segment->m_base + HeaderSize() + i * segment->m_mailboxStride) Mailbox;
+                mailbox->full.store(0, std::memory_order_relaxed);
+                mailbox->size = 0;
+            }
+
+            Header* header = new (segment->m_base) Header;
+            header->numberOfIslands = numberOfIslands;
+            header->mailboxCapacity = mailboxCapacity;
+            header->ready.store(1, std::memory_order_release);
+
+            return segment;
+        }
+
+        /**
+         * Open a segment created by the coordinator, waits until it exists.
+         */
+        static std::shared_ptr<SharedMemorySegment> Open(const std::string& name)
+        {
+            int fd = -1;
+            detail::Backoff backoff;
+            while ((fd = ::shm_open(name.c_str(), O_RDWR, 0600)) < 0)
+            {
+                if (errno != ENOENT)
+                {
+                    detail::ThrowSystemError("shm_open");
+                }
+                backoff.Wait();
+            }
+
+            struct stat status;
+            while (true)
+            {
+                if (::fstat(fd, &status) != 0)
+                {
+                    ::close(fd);
+                    detail::ThrowSystemError("fstat");
+                }
+                if (static_cast<std::size_t>(status.st_size) >= HeaderSize())
+                {
+                    break;
+                }
+                backoff.Wait();
+            }
+
+            std::shared_ptr<SharedMemorySegment> segment(new SharedMemorySegment(name, false));
+            segment->m_size = static_cast<std::size_t>(status.st_size);
+            segment->Map(fd);
+
+            Header* header = reinterpret_cast<Header*>(segment->m_base);
+            while (header->ready.load(std::memory_order_acquire) != 1)
+            {
+                backoff.Wait();
+            }
+            segment->m_mailboxStride = MailboxStride(header->mailboxCapacity);
+
+            return segment;
+        }
+
+        ~SharedMemorySegment()
+        {
+            if (m_base)
+            {
+                ::munmap(m_base, m_size);
+            }
+            if (m_owner)
+            {
+                ::shm_unlink(m_name.c_str());
+            }
+        }
+
+        SharedMemorySegment(const SharedMemorySegment&) = delete;
+        SharedMemorySegment& operator=(const SharedMemorySegment&) = delete;
+
+        unsigned int NumberOfIslands() const
+        {
+            return reinterpret_cast<const Header*>(m_base)->numberOfIslands;
+        }
+
+        std::size_t MailboxCapacity() const
+        {
+            return static_cast<std::size_t>(reinterpret_cast<const Header*>(m_base)->mailboxCapacity);
+        }
+
+        /**
+         * Upstream mailboxes carry messages from islands, downstream mailboxes to islands.
+         */
+        Mailbox* GetMailbox(unsigned int island, bool upstream)
+        {
+            assert(island < NumberOfIslands());
+            return reinterpret_cast<Mailbox*>(m_base + HeaderSize() + (2 * island + (upstream ? 0 : 1)) * m_mailboxStride);
+        }
+
+        static char* MailboxData(Mailbox* mailbox)
+        {
+            return reinterpret_cast<char*>(mailbox) + g_cacheLineSize;
+        }
+
+    private:
+        SharedMemorySegment(const std::string& name, bool owner) :
+            m_name(name),
+            m_owner(owner),
+            m_base(nullptr),
+            m_size(0),
+            m_mailboxStride(0)
+        {
+
+        }
+
+        static std::size_t HeaderSize()
+        {
+            return g_cacheLineSize;
+        }
+
+        static std::size_t MailboxStride(std::size_t capacity)
+        {
+            // Each mailbox starts on its own cache line, data follows the flag line
+            return g_cacheLineSize + (capacity + g_cacheLineSize - 1) / g_cacheLineSize * g_cacheLineSize;
+        }
+
+        void Map(int fd)
+        {
+            void* base = ::mmap(nullptr, m_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            ::close(fd);
+            if (base == MAP_FAILED)
+            {
+                detail::ThrowSystemError("mmap");
+            }
+            m_base = static_cast<char*>(base);
+        }
+
+        std::string m_name;
+        bool m_owner;
+        char* m_base;
+        std::size_t m_size;
+        std::size_t m_mailboxStride;
+    };
+
+    /**
+     * Channel over the pair of shared memory mailboxes of one island.
+     */
+    class SharedMemoryChannel : public IMigrationChannel
+    {
+    public:
+        SharedMemoryChannel(std::shared_ptr<SharedMemorySegment> segment, unsigned int island, bool coordinator) :
+            m_segment(segment),
+            m_outbox(segment->GetMailbox(island, !coordinator)),
+            m_inbox(segment->GetMailbox(island, coordinator))
+        {
+
+        }
+
+        void Send(const MigrationMessage& message) override
+        {
+            const std::size_t size = message.Bytes().size();
+            if (size > m_segment->MailboxCapacity())
+            {
+                throw std::length_error("Migration message does not fit the shared memory mailbox");
+            }
+
+            detail::Backoff backoff;
+            while (m_outbox->full.load(std::memory_order_acquire) != 0)
+            {
+                backoff.Wait();
+            }
+
+            std::memcpy(SharedMemorySegment::MailboxData(m_outbox), message.Bytes().data(), size);
+            m_outbox->size = static_cast<std::uint32_t>(size);
+            m_outbox->full.store(1, std::memory_order_release);
+        }
+
+        void Receive(MigrationMessage& message, std::size_t maxSize) override
+        {
+            detail::Backoff backoff;
+            while (m_inbox->full.load(std::memory_order_acquire) == 0)
+            {
+                backoff.Wait();
+            }
+
+            // The size is written by the peer, it must not make the copy leave the mailbox
+            const std::size_t size = m_inbox->size;
+            if (size > std::min(maxSize, m_segment->MailboxCapacity()))
+            {
+                throw std::length_error("Migration message exceeds the largest expected size");
+            }
+            message.Bytes().resize(size);
+            std::memcpy(message.Bytes().data(), SharedMemorySegment::MailboxData(m_inbox), size);
+            m_inbox->full.store(0, std::memory_order_release);
+            message.Validate();
+        }
+
+    private:
+        std::shared_ptr<SharedMemorySegment> m_segment;
+        SharedMemorySegment::Mailbox* m_outbox;
+        SharedMemorySegment::Mailbox* m_inbox;
+    };
+
+    namespace detail
+    {
+        inline int ListenUnix(const std::string& path, unsigned int backlog)
+        {
+            sockaddr_un address;
+            if (path.size() >= sizeof(address.sun_path))
+            {
+                throw std::invalid_argument("Unix socket path is too long");
+            }
+            std::memset(&address, 0, sizeof(address));
+            address.sun_family = AF_UNIX;
+            std::memcpy(address.sun_path, path.c_str(), path.size());
+
+            const int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+            if (fd < 0)
+            {
+                ThrowSystemError("socket");
+            }
+
+            ::unlink(path.c_str());
+            if (::bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 || ::listen(fd, static_cast<int>(backlog)) != 0)
+            {
+                ::close(fd);
+                ThrowSystemError("bind");
+            }
+            return fd;
+        }
+
+        inline int ConnectUnix(const std::string& path)
+        {
+            sockaddr_un address;
+            if (path.size() >= sizeof(address.sun_path))
+            {
+                throw std::invalid_argument("Unix socket path is too long");
+            }
+            std::memset(&address, 0, sizeof(address));
+            address.sun_family = AF_UNIX;
+            std::memcpy(address.sun_path, path.c_str(), path.size());
+
+            // The coordinator may not be listening yet
+            Backoff backoff;
+            while (true)
+            {
+                const int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+                if (fd < 0)
+                {
+                    ThrowSystemError("socket");
+                }
+                if (::connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0)
+                {
+                    return fd;
+                }
+                const int error = errno;
+                ::close(fd);
+                if (error != ENOENT && error != ECONNREFUSED)
+                {
+                    errno = error;
+                    ThrowSystemError("connect");
+                }
+                backoff.Wait();
+            }
+        }
+
+        inline addrinfo* ResolveTcp(const std::string& address, bool passive)
+        {
+            const std::size_t colon = address.rfind(':');
+            if (colon == std::string::npos)
+            {
+                throw std::invalid_argument("TCP endpoint must be tcp:<host>:<port>");
+            }
+            const std::string host = address.substr(0, colon);
+            const std::string port = address.substr(colon + 1);
+
+            addrinfo hints;
+            std::memset(&hints, 0, sizeof(hints));
+            hints.ai_family = AF_UNSPEC;
+            hints.ai_socktype = SOCK_STREAM;
+            hints.ai_flags = passive ? AI_PASSIVE : 0;
+
+            addrinfo* result = nullptr;
+            const int error = ::getaddrinfo(host.empty() ? nullptr : host.c_str(), port.c_str(), &hints, &result);
+            if (error != 0)
+            {
+                throw std::runtime_error(std::string("getaddrinfo: ") + ::gai_strerror(error));
+            }
+            return result;
+        }
+
+        inline void SetNoDelay(int fd)
+        {
+            // Migration messages are small and latency bound
+            int enable = 1;
+            ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable));
+        }
+
+        inline int ListenTcp(const std::string& address, unsigned int backlog)
+        {
+            addrinfo* addresses = ResolveTcp(address, true);
+            int fd = -1;
+            for (addrinfo* candidate = addresses; candidate; candidate = candidate->ai_next)
+            {
+                fd = ::socket(candidate->ai_family, candidate->ai_socktype, candidate->ai_protocol);
+                if (fd < 0)
+                {
+                    continue;
+                }
+
+                int enable = 1;
+                ::setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(enable));
+                if (::bind(fd, candidate->ai_addr, candidate->ai_addrlen) == 0 && ::listen(fd, static_cast<int>(backlog)) == 0)
+                {
+                    break;
+                }
+                ::close(fd);
+                fd = -1;
+            }
+            ::freeaddrinfo(addresses);
+
+            if (fd < 0)
+            {
+                ThrowSystemError("bind");
+            }
+            return fd;
+        }
+
+        inline int ConnectTcp(const std::string& address)
+        {
+            Backoff backoff;
+            while (true)
+            {
+                addrinfo* addresses = ResolveTcp(address, false);
+                int fd = -1;
+                for (addrinfo* candidate = addresses; candidate; candidate = candidate->ai_next)
+                {
+                    fd = ::socket(candidate->ai_family, candidate->ai_socktype, candidate->ai_protocol);
+                    if (fd < 0)
+                    {
+                        continue;
+                    }
+                    if (::connect(fd, candidate->ai_addr, candidate->ai_addrlen) == 0)
+                    {
+                        break;
+                    }
+                    ::close(fd);
+                    fd = -1;
+                }
+                ::freeaddrinfo(addresses);
+
+                if (fd >= 0)
+                {
+                    SetNoDelay(fd);
+                    return fd;
+                }
+                if (errno != ECONNREFUSED)
+                {
+                    ThrowSystemError("connect");
+                }
+                backoff.Wait();
+            }
+        }
+    }
+
+    /**
+     * Connect an island process to the coordinator at endpoint and register it.
+     *
+     * \param endpoint unix:<path>, tcp:<host>:<port> or shm:<name>
+     * \param island Index of the island in [0, number of islands)
+     * \param numberOfParameters Dimension of the agents
+     */
+    inline std::unique_ptr<IMigrationChannel> ConnectIsland(const std::string& endpoint, unsigned int island, unsigned int numberOfParameters)
+    {
+        std::string scheme;
+        std::string address;
+        detail::ParseEndpoint(endpoint, scheme, address);
+
+        std::unique_ptr<IMigrationChannel> channel;
+        if (scheme == "unix")
+        {
+            channel.reset(new SocketChannel(detail::ConnectUnix(address)));
+        }
+        else if (scheme == "tcp")
+        {
+            channel.reset(new SocketChannel(detail::ConnectTcp(address)));
+        }
+        else if (scheme == "shm")
+        {
+            std::shared_ptr<SharedMemorySegment> segment = SharedMemorySegment::Open(address);
+            if (island >= segment->NumberOfIslands())
+            {
+                throw std::out_of_range("Island index exceeds the number of islands of the shared memory segment");
+            }
+            channel.reset(new SharedMemoryChannel(segment, island, false));
+        }
+        else
+        {
+            throw std::invalid_argument("Unknown endpoint scheme " + scheme);
+        }
+
+        MigrationMessage hello;
+        hello.Reset(MigrationMessageType::Hello, island, numberOfParameters, 0);
+        channel->Send(hello);
+
+        return channel;
+    }
+
+    /**
+     * Island running in its own process. Runs the optimizer and every migration interval
+     * generations sends its best agents to the coordinator and inserts the agents it receives.
+     * All islands of a run must use the same number of generations, migration interval and
+     * migration size as the coordinator.
+     */
+    class RemoteIsland
+    {
+    public:
+        RemoteIsland(DifferentialEvolution& optimizer, std::unique_ptr<IMigrationChannel> channel, unsigned int island, int randomSeed = 123) :
+            m_optimizer(optimizer),
+            m_channel(std::move(channel)),
+            m_island(island),
+            m_replacementPolicy(ReplacementPolicy::Worst),
+            m_migrationInterval(10),
+            m_migrationSize(1),
+            m_generation(0),
+            m_generator(static_cast<std::uint64_t>(randomSeed), g_migrationStreams + island)
+        {
+            m_selected.resize(m_optimizer.GetPopulationSize());
+        }
+
+        void SetReplacementPolicy(ReplacementPolicy policy)
+        {
+            m_replacementPolicy = policy;
+        }
+
+        void SetMigrationInterval(unsigned int generations)
+        {
+            assert(generations >= 1);
+            m_migrationInterval = generations;
+        }
+
+        void SetMigrationSize(unsigned int numberOfAgents)
+        {
+            assert(numberOfAgents >= 1 && numberOfAgents < m_optimizer.GetPopulationSize());
+            m_migrationSize = numberOfAgents;
+        }
+
+        /**
+         * Initialize the population and run the given number of generations, then report the best
+         * agent to the coordinator.
+         */
+        void Optimize(unsigned int generations)
+        {
+            const unsigned int dimensions = m_optimizer.GetPopulation().Columns();
+
+            m_optimizer.InitPopulation();
+            for (m_generation = 1; m_generation <= generations; m_generation++)
+            {
+                m_optimizer.SelectionAndCorssing();
+
+                if (m_generation % m_migrationInterval == 0 && m_generation < generations)
+                {
+                    Migrate(dimensions);
+                }
+            }
+
+            m_message.Reset(MigrationMessageType::Finished, m_island, dimensions, generations);
+            m_message.Append(m_optimizer.GetBestAgentView().data(), m_optimizer.GetBestCost(), m_optimizer.GetBestViolation());
+            m_channel->Send(m_message);
+        }
+
+    private:
+        void Migrate(unsigned int dimensions)
+        {
+            const unsigned int count = SelectAgents(m_optimizer, m_migrationSize, true, m_selected);
+
+            m_message.Reset(MigrationMessageType::Migrants, m_island, dimensions, m_generation);
+            for (unsigned int k = 0; k < count; k++)
+            {
+                m_message.Append(m_optimizer.GetAgent(m_selected[k]).data(), m_optimizer.GetAgentCost(m_selected[k]), m_optimizer.GetAgentViolation(m_selected[k]));
+            }
+            m_channel->Send(m_message);
+
+            m_channel->Receive(m_message, MigrationMessage::Size(m_migrationSize, dimensions));
+            const MigrationMessageHeader header = m_message.Header();
+            if (m_message.Type() != MigrationMessageType::Immigrants || header.dimensions != dimensions || header.count > m_migrationSize)
+            {
+                throw std::runtime_error("Unexpected message from the migration coordinator");
+            }
+
+            m_immigrants.Resize(std::max(1u, header.count), dimensions);
+            m_immigrantCosts.Resize(std::max(1u, header.count));
+            m_immigrantViolations.Resize(std::max(1u, header.count));
+            m_order.resize(header.count);
+            for (std::uint32_t k = 0; k < header.count; k++)
+            {
+                m_message.CopyAgent(k, m_immigrants.RowData(k));
+                m_immigrantCosts[k] = m_message.Cost(k);
+                m_immigrantViolations[k] = m_message.Violation(k);
+                m_order[k] = k;
+            }
+
+            ReceiveImmigrants(m_optimizer, m_replacementPolicy, m_immigrants, m_immigrantCosts.data(), m_immigrantViolations.data(),
+                              m_order.data(), header.count, m_generator, m_selected);
+        }
+
+        DifferentialEvolution& m_optimizer;
+        std::unique_ptr<IMigrationChannel> m_channel;
+        unsigned int m_island;
+
+        ReplacementPolicy m_replacementPolicy;
+        unsigned int m_migrationInterval;
+        unsigned int m_migrationSize;
+        unsigned int m_generation;
+
+        RandomEngine m_generator;
+
+        MigrationMessage m_message;
+        AlignedMatrix m_immigrants;
+        AlignedBuffer<double> m_immigrantCosts;
+        AlignedBuffer<double> m_immigrantViolations;
+        std::vector<std::uint32_t> m_order;
+        std::vector<std::uint32_t> m_selected;
+    };
+
+    /**
+     * Coordinator of a multi-process island run. Waits for all islands to connect, then at each
+     * migration collects migrants from all islands and sends every island the best agents of its
+     * sources in the topology. Runs until all islands report Finished. Migrants and the best agent are
+     * compared by Deb's feasibility rules, the islands apply their own epsilon level when inserting
+     * immigrants.
+     */
+    class MigrationCoordinator
+    {
+    public:
+        /**
+         * \param endpoint unix:<path>, tcp:<host>:<port> or shm:<name>
+         * \param numberOfIslands Number of island processes expected to connect
+         * \param numberOfParameters Dimension of the agents
+         * \param migrationSize Number of agents each island sends and receives
+         * \param randomSeed Seed of the random topology
+         */
+        MigrationCoordinator(const std::string& endpoint,
+                             unsigned int numberOfIslands,
+                             unsigned int numberOfParameters,
+                             unsigned int migrationSize = 1,
+                             int randomSeed = 123) :
+            m_numberOfIslands(numberOfIslands),
+            m_numberOfParameters(numberOfParameters),
+            m_migrationSize(migrationSize),
+            m_topology(MigrationTopology::Ring),
+            m_listener(-1),
+            m_generator(static_cast<std::uint64_t>(randomSeed), g_migrationStreams),
+            m_bestCost(std::numeric_limits<double>::infinity()),
+            m_bestViolation(std::numeric_limits<double>::infinity()),
+            m_bestIsland(0)
+        {
+            assert(numberOfIslands >= 1 && migrationSize >= 1);
+
+            detail::ParseEndpoint(endpoint, m_scheme, m_address);
+            if (m_scheme == "unix")
+            {
+                m_listener = detail::ListenUnix(m_address, numberOfIslands);
+            }
+            else if (m_scheme == "tcp")
+            {
+                m_listener = detail::ListenTcp(m_address, numberOfIslands);
+            }
+            else if (m_scheme == "shm")
+            {
+                m_segment = SharedMemorySegment::Create(m_address, numberOfIslands, MigrationMessage::Size(migrationSize, numberOfParameters));
+            }
+            else
+            {
+                throw std::invalid_argument("Unknown endpoint scheme " + m_scheme);
+            }
+
+            m_channels.resize(numberOfIslands);
+            m_migrants.Resize(numberOfIslands * migrationSize, numberOfParameters);
+            m_migrantCosts.Resize(numberOfIslands * migrationSize);
+            m_migrantViolations.Resize(numberOfIslands * migrationSize);
+            m_migrantCounts.resize(numberOfIslands);
+            m_sent.resize(numberOfIslands);
+            m_finished.resize(numberOfIslands);
+            m_bestAgent.resize(numberOfParameters);
+        }
+
+        ~MigrationCoordinator()
+        {
+            m_channels.clear();
+            if (m_listener >= 0)
+            {
+                ::close(m_listener);
+                if (m_scheme == "unix")
+                {
+                    ::unlink(m_address.c_str());
+                }
+            }
+        }
+
+        MigrationCoordinator(const MigrationCoordinator&) = delete;
+        MigrationCoordinator& operator=(const MigrationCoordinator&) = delete;
+
+        void SetTopology(MigrationTopology topology)
+        {
+            m_topology = topology;
+        }
+
+        /**
+         * Accept all islands and relay migrations until every island has finished.
+         */
+        void Run()
+        {
+            AcceptIslands();
+
+            std::fill(m_finished.begin(), m_finished.end(), false);
+            unsigned int numberOfFinished = 0;
+
+            while (numberOfFinished < m_numberOfIslands)
+            {
+                // Islands migrate in lock step, so one message is expected from every running island
+                for (unsigned int i = 0; i < m_numberOfIslands; i++)
+                {
+                    m_sent[i] = false;
+                    if (m_finished[i])
+                    {
+                        continue;
+                    }
+
+                    m_channels[i]->Receive(m_message, MigrationMessage::Size(m_migrationSize, m_numberOfParameters));
+                    const MigrationMessageHeader header = m_message.Header();
+                    if (header.island != i || header.dimensions != m_numberOfParameters || header.count > m_migrationSize)
+                    {
+                        throw std::runtime_error("Unexpected message from an island");
+                    }
+
+                    if (m_message.Type() == MigrationMessageType::Finished)
+                    {
+                        m_finished[i] = true;
+                        numberOfFinished++;
+                        if (header.count > 0 && IsBetterByFeasibility(m_message.Cost(0), m_message.Violation(0), m_bestCost, m_bestViolation))
+                        {
+                            m_bestCost = m_message.Cost(0);
+                            m_bestViolation = m_message.Violation(0);
+                            m_bestIsland = i;
+                            m_message.CopyAgent(0, m_bestAgent.data());
+                        }
+                        continue;
+                    }
+                    if (m_message.Type() != MigrationMessageType::Migrants)
+                    {
+                        throw std::runtime_error("Unexpected message type from an island");
+                    }
+
+                    m_sent[i] = true;
+                    m_migrantCounts[i] = header.count;
+                    for (std::uint32_t k = 0; k < header.count; k++)
+                    {
+                        m_message.CopyAgent(k, m_migrants.RowData(i * m_migrationSize + k));
+                        m_migrantCosts[i * m_migrationSize + k] = m_message.Cost(k);
+                        m_migrantViolations[i * m_migrationSize + k] = m_message.Violation(k);
+                    }
+                }
+
+                for (unsigned int i = 0; i < m_numberOfIslands; i++)
+                {
+                    if (m_sent[i])
+                    {
+                        SendImmigrants(i);
+                    }
+                }
+            }
+        }
+
+        /**
+         * Best agent reported by the islands at the end of Run.
+         */
+        const std::vector<double>& GetBestAgent() const
+        {
+            return m_bestAgent;
+        }
+
+        double GetBestCost() const
+        {
+            return m_bestCost;
+        }
+
+        double GetBestViolation() const
+        {
+            return m_bestViolation;
+        }
+
+        unsigned int GetBestIsland() const
+        {
+            return m_bestIsland;
+        }
+
+    private:
+        void AcceptIslands()
+        {
+            for (unsigned int connected = 0; connected < m_numberOfIslands; connected++)
+            {
+                std::unique_ptr<IMigrationChannel> channel;
+                if (m_segment)
+                {
+                    channel.reset(new SharedMemoryChannel(m_segment, connected, true));
+                }
+                else
+                {
+                    int fd;
+                    while ((fd = ::accept(m_listener, nullptr, nullptr)) < 0)
+                    {
+                        if (errno != EINTR)
+                        {
+                            detail::ThrowSystemError("accept");
+                        }
+                    }
+                    if (m_scheme == "tcp")
+                    {
+                        detail::SetNoDelay(fd);
+                    }
+                    channel.reset(new SocketChannel(fd));
+                }
+
+                channel->Receive(m_message, MigrationMessage::Size(0, m_numberOfParameters));
+                const MigrationMessageHeader header = m_message.Header();
+                if (m_message.Type() != MigrationMessageType::Hello || header.island >= m_numberOfIslands ||
+                    header.dimensions != m_numberOfParameters || m_channels[header.island])
+                {
+                    throw std::runtime_error("Invalid registration of an island");
+                }
+                if (m_segment && header.island != connected)
+                {
+                    throw std::runtime_error("Island registered in a foreign shared memory mailbox");
+                }
+
+                m_channels[header.island] = std::move(channel);
+            }
+        }
+
+        void SendImmigrants(unsigned int island)
+        {
+            MigrationSources(m_topology, island, m_numberOfIslands, m_generator, m_sources);
+
+            m_candidates.clear();
+            for (unsigned int source : m_sources)
+            {
+                if (!m_sent[source])
+                {
+                    continue;
+                }
+                for (unsigned int k = 0; k < m_migrantCounts[source]; k++)
+                {
+                    m_candidates.push_back(source * m_migrationSize + k);
+                }
+            }
+
+            const unsigned int count = SelectImmigrants(m_candidates, m_migrationSize,
+                [this](std::uint32_t left, std::uint32_t right)
+                {
+                    return IsBetterByFeasibility(m_migrantCosts[left], m_migrantViolations[left], m_migrantCosts[right], m_migrantViolations[right]);
+                });
+
+            m_message.Reset(MigrationMessageType::Immigrants, island, m_numberOfParameters, 0);
+            for (unsigned int k = 0; k < count; k++)
+            {
+                m_message.Append(m_migrants.RowData(m_candidates[k]), m_migrantCosts[m_candidates[k]], m_migrantViolations[m_candidates[k]]);
+            }
+            m_channels[island]->Send(m_message);
+        }
+
+        unsigned int m_numberOfIslands;
+        unsigned int m_numberOfParameters;
+        unsigned int m_migrationSize;
+        MigrationTopology m_topology;
+
+        std::string m_scheme;
+        std::string m_address;
+        int m_listener;
+        std::shared_ptr<SharedMemorySegment> m_segment;
+        std::vector<std::unique_ptr<IMigrationChannel>> m_channels;
+
+        RandomEngine m_generator;
+
+        MigrationMessage m_message;
+        AlignedMatrix m_migrants;
+        AlignedBuffer<double> m_migrantCosts;
+        AlignedBuffer<double> m_migrantViolations;
+        std::vector<std::uint32_t> m_migrantCounts;
+        std::vector<bool> m_sent;
+        std::vector<bool> m_finished;
+        std::vector<std::uint32_t> m_sources;
+        std::vector<std::uint32_t> m_candidates;
+
+        std::vector<double> m_bestAgent;
+        double m_bestCost;
+        double m_bestViolation;
+        unsigned int m_bestIsland;
+    };
+}
@@ -0,0 +1,233 @@
+/**
+ * \file Surrogate.h
+ * \author Milos Stojanovic Stojke (milsto)
+ *
+ * Surrogate models of the cost function used to pre-screen trial vectors.
+ */
+
+#pragma once
+
+#include <vector>
+#include <cassert>
+#include <cstdint>
+#include <cmath>
+#include <limits>
+#include <algorithm>
+
+#include "DifferentialEvolution.h"
+
+namespace de
+{
+    /**
+     * Local radial basis function model over an archive of evaluated agents.
+     *
+     * A prediction interpolates the costs of the nearest archived agents with Gaussian basis
+     * functions whose width is the mean squared distance of the neighbours. Adding an agent is
+     * constant time. A prediction scans the archive once and solves a small system over the
+     * neighbours, so it stays fast for tens of thousands of archived agents. When the archive is
+     * full the oldest agents are replaced.
+     */
+    class LocalRbfSurrogate : public ISurrogate
+    {
+    public:
+        /**
+         * \param numberOfParameters Dimension of the agents
+         * \param neighbours Number of nearest agents used by a prediction, 0 for 2 * numberOfParameters + 1
+         * \param maxArchiveSize Maximal number of archived agents
+         */
+        explicit LocalRbfSurrogate(unsigned int numberOfParameters, unsigned int neighbours = 0, std::size_t maxArchiveSize = 50000) :
+            m_numberOfParameters(numberOfParameters),
+            m_neighbours(neighbours > 0 ? neighbours : 2 * numberOfParameters + 1),
+            m_maxArchiveSize(std::max<std::size_t>(maxArchiveSize, m_neighbours)),
+            m_next(0)
+        {
+            assert(numberOfParameters > 0);
+        }
+
+        void Add(const double* agent, double cost) override
+        {
+            if (!std::isfinite(cost))
+            {
+                return;
+            }
+
+            if (m_costs.size() < m_maxArchiveSize)
+            {
+                m_agents.insert(m_agents.end(), agent, agent + m_numberOfParameters);
+                m_costs.push_back(cost);
+                return;
+            }
+
+            std::copy(agent, agent + m_numberOfParameters, m_agents.begin() + m_next * m_numberOfParameters);
+            m_costs[m_next] = cost;
+            m_next = (m_next + 1) % m_maxArchiveSize;
+        }
+
+        bool Predict(const double* agent, double& cost) const override
+        {
+            const std::size_t size = m_costs.size();
+            if (size < m_neighbours)
+            {
+                return false;
+            }
+
+            Workspace& workspace = LocalWorkspace();
+            workspace.distances.resize(size);
+            workspace.indices.resize(size);
+
+            for (std::size_t i = 0; i < size; i++)
+            {
+                const double* archived = &m_agents[i * m_numberOfParameters];
+                double distance = 0.0;
+                for (unsigned int j = 0; j < m_numberOfParameters; j++)
+                {
+                    const double difference = archived[j] - agent[j];
+                    distance += difference * difference;
+                }
+                workspace.distances[i] = distance;
+                workspace.indices[i] = static_cast<std::uint32_t>(i);
+            }
+
+            const unsigned int k = m_neighbours;
+            std::nth_element(workspace.indices.begin(), workspace.indices.begin() + (k - 1), workspace.indices.end(),
+                [&workspace](std::uint32_t left, std::uint32_t right)
+                {
+                    return workspace.distances[left] < workspace.distances[right] || (workspace.distances[left] == workspace.distances[right] && left < right);
+                });
+
+            double width = 0.0;
+            double mean = 0.0;
+            for (unsigned int i = 0; i < k; i++)
+            {
+                const std::uint32_t neighbour = workspace.indices[i];
+                if (workspace.distances[neighbour] == 0.0)
+                {
+                    cost = m_costs[neighbour];
+                    return true;
+                }
+                width += workspace.distances[neighbour];
+                mean += m_costs[neighbour];
+            }
+            width /= k;
+            mean /= k;
+
+            // Gaussian kernel matrix of the neighbours, regularized more if it is numerically singular
+            for (double ridge = 1e-10; ridge < 1.0; ridge *= 100.0)
+            {
+                workspace.matrix.resize(k * k);
+                workspace.weights.resize(k);
+                for (unsigned int i = 0; i < k; i++)
+                {
+                    const double* a = &m_agents[workspace.indices[i] * m_numberOfParameters];
+                    for (unsigned int j = 0; j <= i; j++)
+                    {
+                        const double* b = &m_agents[workspace.indices[j] * m_numberOfParameters];
+                        double distance = 0.0;
+                        for (unsigned int d = 0; d < m_numberOfParameters; d++)
+                        {
+                            distance += (a[d] - b[d]) * (a[d] - b[d]);
+                        }
+                        workspace.matrix[i * k + j] = std::exp(-distance / width) + (i == j ? ridge : 0.0);
+                    }
+                    workspace.weights[i] = m_costs[workspace.indices[i]] - mean;
+                }
+
+                if (!SolveCholesky(workspace.matrix, workspace.weights, k))
+                {
+                    continue;
+                }
+
+                cost = mean;
+                for (unsigned int i = 0; i < k; i++)
+                {
+                    cost += workspace.weights[i] * std::exp(-workspace.distances[workspace.indices[i]] / width);
+                }
+                return std::isfinite(cost);
+            }
+
+            return false;
+        }
+
+        std::size_t Size() const
+        {
+            return m_costs.size();
+        }
+
+    private:
+        struct Workspace
+        {
+            std::vector<double> distances;
+            std::vector<std::uint32_t> indices;
+            std::vector<double> matrix;
+            std::vector<double> weights;
+        };
+
+        // Predictions run concurrently, each thread keeps its buffers between calls
+        static Workspace& LocalWorkspace()
+        {
+            thread_local Workspace workspace;
+            return workspace;
+        }
+
+        /**
+         * Solve A x = b in place for a symmetric positive definite A given by its lower triangle.
+         * Returns false if A is not numerically positive definite.
+         */
+        static bool SolveCholesky(std::vector<double>& a, std::vector<double>& b, unsigned int n)
+        {
+            for (unsigned int j = 0; j < n; j++)
+            {
+                double diagonal = a[j * n + j];
+                for (unsigned int p = 0; p < j; p++)
+                {
+                    diagonal -= a[j * n + p] * a[j * n + p];
+                }
+                if (!(diagonal > 0.0))
+                {
+                    return false;
+                }
+                diagonal = std::sqrt(diagonal);
+                a[j * n + j] = diagonal;
+
+                for (unsigned int i = j + 1; i < n; i++)
+                {
+                    double value = a[i * n + j];
+                    for (unsigned int p = 0; p < j; p++)
+                    {
+                        value -= a[i * n + p] * a[j * n + p];
+                    }
+                    a[i * n + j] = value / diagonal;
+                }
+            }
+
+            for (unsigned int i = 0; i < n; i++)
+            {
+                double value = b[i];
+                for (unsigned int p = 0; p < i; p++)
+                {
+                    value -= a[i * n + p] * b[p];
+                }
+                b[i] = value / a[i * n + i];
+            }
+            for (unsigned int i = n; i-- > 0;)
+            {
+                double value = b[i];
+                for (unsigned int p = i + 1; p < n; p++)
+                {
+                    value -= a[p * n + i] * b[p];
+                }
+                b[i] = value / a[i * n + i];
+            }
+            return true;
+        }
+
+        unsigned int m_numberOfParameters;
+        unsigned int m_neighbours;
+        std::size_t m_maxArchiveSize;
+        std::size_t m_next;
+
+        // Archived agents row by row and their costs
+        std::vector<double> m_agents;
+        std::vector<double> m_costs;
+    };
+}
@@ -0,0 +1,60 @@
+/**
+ * \file Telemetry.h
+ * \author Milos Stojanovic Stojke (milsto)
+ *
+ * Sinks of per generation telemetry of DifferentialEvolution.
+ */
+
+#pragma once
+
+#include <ostream>
+#include <cassert>
+
+#include "DifferentialEvolution.h"
+
+namespace de
+{
+    /**
+     * Write telemetry of every interval-th generation as a line of text to a stream.
+     *
+     * Lines are not flushed, so the stream buffers them and fast runs are not slowed down by console
+     * output. Flush the stream when the run ends.
+     */
+    class StreamTelemetrySink : public ITelemetrySink
+    {
+    public:
+        /**
+         * \param stream Output stream owned by the caller
+         * \param interval Number of generations between two lines
+         */
+        explicit StreamTelemetrySink(std::ostream& stream, unsigned int interval = 1) :
+            m_stream(stream),
+            m_interval(interval)
+        {
+            assert(interval > 0);
+        }
+
+        void OnGeneration(const GenerationTelemetry& telemetry) override
+        {
+            if (telemetry.generation % m_interval != 0)
+            {
+                return;
+            }
+
+            m_stream << "generation " << telemetry.generation
+                     << " evaluations " << telemetry.totalEvaluations
+                     << " replacements " << telemetry.replacements
+                     << " rejections " << telemetry.rejections
+                     << " best " << telemetry.bestCost
+                     << " mean " << telemetry.meanCost
+                     << " worst " << telemetry.worstCost
+                     << " diversity " << telemetry.diversity
+                     << " evaluation " << telemetry.evaluationSeconds
+                     << "s overhead " << telemetry.overheadSeconds << "s\n";
+        }
+
+    private:
+        std::ostream& m_stream;
+        unsigned int m_interval;
+    };
+}
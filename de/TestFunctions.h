@@ -9,6 +9,8 @@
 
 #include <vector>
 #include <cassert>
+#include <cmath>
+#include <algorithm>
 
 #include "DifferentialEvolution.h"
 
@@ -24,10 +26,15 @@ namespace de
         }
         double EvaluteCost(std::vector<double> inputs) const override
         {
-            assert(inputs.size() == m_dim);
+            return EvaluateCost(inputs.data(), inputs.size());
+        }
+
+        double EvaluateCost(const double* inputs, std::size_t size) const override
+        {
+            assert(size == m_dim);
 
             double val = 0.0;
-            for (int i = 0; i < m_dim; i++)
+            for (unsigned int i = 0; i < m_dim; i++)
             {
                 val += inputs[i] * inputs[i]
                        - 100 * cos(inputs[i]) * cos(inputs[i])
@@ -37,6 +44,8 @@ namespace de
             return val + 1400.0;
         }
 
+        using IOptimizable::EvaluateCost;
+
         unsigned int NumberOfParameters() const override
         {
             return m_dim;
@@ -66,15 +75,17 @@ namespace de
         }
         double EvaluteCost(std::vector<double> inputs) const override
         {
-            assert(inputs.size() == m_dim);
+            return EvaluateCost(inputs.data(), inputs.size());
+        }
 
-            double x = inputs[0];
-            double y = inputs[1];
+        double EvaluateCost(const double* inputs, std::size_t size) const override
+        {
+            assert(size == m_dim);
 
             double val1 = 0.0;
             double val2 = 0.0;
 
-            for (int i = 0; i < m_dim; i++)
+            for (unsigned int i = 0; i < m_dim; i++)
             {
                 if (inputs[i] < -1.0 || inputs[i] > 1.0)
                 {
@@ -88,6 +99,8 @@ namespace de
             return -0.1 * val1 - val2;
         }
 
+        using IOptimizable::EvaluateCost;
+
         unsigned int NumberOfParameters() const override
         {
             return m_dim;
@@ -118,13 +131,18 @@ namespace de
 
         double EvaluteCost(std::vector<double> inputs) const override
         {
-            assert(inputs.size() == m_dim);
+            return EvaluateCost(inputs.data(), inputs.size());
+        }
+
+        double EvaluateCost(const double* inputs, std::size_t size) const override
+        {
+            assert(size == m_dim);
 
             double A = 10;
 
             double val = 0.0;
 
-            for (int i = 0; i < m_dim; i++)
+            for (unsigned int i = 0; i < m_dim; i++)
             {
                 if (inputs[i] < -5.12 || inputs[i] > 5.12)
                 {
@@ -137,6 +155,8 @@ namespace de
             return A * m_dim + val;
         }
 
+        using IOptimizable::EvaluateCost;
+
         unsigned int NumberOfParameters() const override
         {
             return m_dim;
@@ -155,4 +175,54 @@ namespace de
     private:
         unsigned int m_dim;
     };
+
+    /**
+     * Problem G06 of the CEC 2006 constrained benchmark, two nonlinear inequality constraints.
+     * Feasible region is a thin crescent, the optimum is -6961.81387558015 at (14.095, 0.84296).
+     */
+    class G06 : public IConstrainedOptimizable
+    {
+    public:
+        double EvaluteCost(std::vector<double> inputs) const override
+        {
+            return EvaluateCost(inputs.data(), inputs.size());
+        }
+
+        double EvaluateCost(const double* inputs, std::size_t size) const override
+        {
+            assert(size == 2);
+
+            return std::pow(inputs[0] - 10.0, 3) + std::pow(inputs[1] - 20.0, 3);
+        }
+
+        using IOptimizable::EvaluateCost;
+
+        void EvaluateConstraints(const double* inputs, std::size_t size, double* violations) const override
+        {
+            assert(size == 2);
+
+            const double a = (inputs[0] - 5.0) * (inputs[0] - 5.0) + (inputs[1] - 5.0) * (inputs[1] - 5.0);
+            const double b = (inputs[0] - 6.0) * (inputs[0] - 6.0) + (inputs[1] - 5.0) * (inputs[1] - 5.0);
+            violations[0] = std::max(0.0, 100.0 - a);
+            violations[1] = std::max(0.0, b - 82.81);
+        }
+
+        unsigned int NumberOfParameters() const override
+        {
+            return 2;
+        }
+
+        unsigned int NumberOfConstraints() const override
+        {
+            return 2;
+        }
+
+        std::vector<Constraints> GetConstraints() const override
+        {
+            std::vector<Constraints> constr(NumberOfParameters());
+            constr[0] = Constraints(13.0, 100.0, true);
+            constr[1] = Constraints(0.0, 100.0, true);
+            return constr;
+        }
+    };
 }
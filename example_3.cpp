@@ -0,0 +1,99 @@
+/**
+ * \file example_3.cpp
+ * \author Milos Stojanovic Stojke (milsto)
+ *
+ * Multi-process island model on Rastrigin's test function. Every island is a separate process
+ * exchanging agents with a local coordinator.
+ *
+ * Usage: example_3 [endpoint]                       forks the coordinator and 4 islands
+ *        example_3 coordinator <endpoint> <islands> runs only the coordinator
+ *        example_3 island <endpoint> <index>        runs only one island
+ *
+ * Endpoint is unix:<path>, tcp:<host>:<port> or shm:<name>, default unix:/tmp/de_islands.sock
+ */
+
+#include "de/DifferentialEvolution.h"
+#include "de/IslandNetwork.h"
+#include "de/TestFunctions.h"
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace
+{
+    const unsigned int g_dimensions = 10;
+    const unsigned int g_generations = 2000;
+    const unsigned int g_migrationInterval = 20;
+    const unsigned int g_migrationSize = 2;
+
+    int RunCoordinator(const std::string& endpoint, unsigned int islands)
+    {
+        de::MigrationCoordinator coordinator(endpoint, islands, g_dimensions, g_migrationSize);
+        coordinator.SetTopology(de::MigrationTopology::Ring);
+        coordinator.Run();
+
+        std::cout << "Best cost " << coordinator.GetBestCost() << " from island " << coordinator.GetBestIsland() << "\nBest agent:";
+        for (double value : coordinator.GetBestAgent())
+        {
+            std::cout << " " << value;
+        }
+        std::cout << std::endl;
+
+        return 0;
+    }
+
+    int RunIsland(const std::string& endpoint, unsigned int index)
+    {
+        // Each process owns its cost function, it does not have to be thread-safe
+        de::Rastrigin cost(g_dimensions);
+        de::DifferentialEvolution optimizer(cost, 50, 123 + static_cast<int>(index));
+
+        de::RemoteIsland island(optimizer, de::ConnectIsland(endpoint, index, g_dimensions), index);
+        island.SetMigrationInterval(g_migrationInterval);
+        island.SetMigrationSize(g_migrationSize);
+        island.Optimize(g_generations);
+
+        return 0;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    if (argc == 4 && std::string(argv[1]) == "coordinator")
+    {
+        return RunCoordinator(argv[2], static_cast<unsigned int>(std::atoi(argv[3])));
+    }
+    if (argc == 4 && std::string(argv[1]) == "island")
+    {
+        return RunIsland(argv[2], static_cast<unsigned int>(std::atoi(argv[3])));
+    }
+
+    const std::string endpoint = argc > 1 ? argv[1] : "unix:/tmp/de_islands.sock";
+    const unsigned int islands = 4;
+
+    std::vector<pid_t> children;
+    for (unsigned int i = 0; i < islands; i++)
+    {
+        const pid_t pid = fork();
+        if (pid == 0)
+        {
+            std::_Exit(RunIsland(endpoint, i));
+        }
+        children.push_back(pid);
+    }
+
+    const int result = RunCoordinator(endpoint, islands);
+
+    for (pid_t child : children)
+    {
+        int status = 0;
+        waitpid(child, &status, 0);
+    }
+
+    return result;
+}
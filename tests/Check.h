@@ -0,0 +1,88 @@
+/**
+ * \file Check.h
+ * \author Milos Stojanovic Stojke (milsto)
+ *
+ * Minimal checks used by the tests. A failed check is reported and counted, the test executable
+ * returns a non-zero exit code if any check failed.
+ */
+
+#pragma once
+
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+
+#include "de/DifferentialEvolution.h"
+
+namespace de
+{
+    namespace test
+    {
+        inline int& Failures()
+        {
+            static int failures = 0;
+            return failures;
+        }
+
+        inline void Fail(const char* file, int line, const char* expression)
+        {
+            std::cerr << file << ":" << line << ": check failed: " << expression << std::endl;
+            Failures()++;
+        }
+
+        /**
+         * Bitwise equality of the first rows of two populations and of their costs.
+         */
+        inline bool SamePopulation(const DifferentialEvolution& a, const DifferentialEvolution& b)
+        {
+            if (a.GetPopulationSize() != b.GetPopulationSize() || a.GetPopulation().Columns() != b.GetPopulation().Columns())
+            {
+                return false;
+            }
+
+            const std::size_t columns = a.GetPopulation().Columns();
+            for (unsigned int x = 0; x < a.GetPopulationSize(); x++)
+            {
+                const double costA = a.GetAgentCost(x);
+                const double costB = b.GetAgentCost(x);
+                if (std::memcmp(a.GetPopulation().RowData(x), b.GetPopulation().RowData(x), columns * sizeof(double)) != 0 ||
+                    std::memcmp(&costA, &costB, sizeof(double)) != 0)
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        inline int Result()
+        {
+            if (Failures() > 0)
+            {
+                std::cerr << Failures() << " check(s) failed" << std::endl;
+                return 1;
+            }
+            return 0;
+        }
+    }
+}
+
+#define DE_CHECK(condition) \
+    do \
+    { \
+        if (!(condition)) \
+        { \
+            de::test::Fail(__FILE__, __LINE__, #condition); \
+        } \
+    } while (false)
+
+#define DE_CHECK_EQUAL(actual, expected) \
+    do \
+    { \
+        const auto deActual = (actual); \
+        const auto deExpected = (expected); \
+        if (!(deActual == deExpected)) \
+        { \
+            de::test::Fail(__FILE__, __LINE__, #actual " == " #expected); \
+            std::cerr << std::setprecision(17) << "  actual " << deActual << ", expected " << deExpected << std::endl; \
+        } \
+    } while (false)
@@ -0,0 +1,72 @@
+/**
+ * \file test_allocations.cpp
+ * \author Milos Stojanovic Stojke (milsto)
+ *
+ * Generations after InitPopulation do not allocate.
+ */
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#include "Check.h"
+#include "de/TestFunctions.h"
+
+namespace
+{
+    std::atomic<unsigned long long> g_allocations(0);
+}
+
+void* operator new(std::size_t size)
+{
+    g_allocations++;
+    void* memory = std::malloc(size == 0 ? 1 : size);
+    if (!memory)
+    {
+        throw std::bad_alloc();
+    }
+    return memory;
+}
+
+void operator delete(void* memory) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete(void* memory, std::size_t) noexcept
+{
+    std::free(memory);
+}
+
+namespace
+{
+    void TestGenerations(de::MutationStrategy mutation, de::ParameterControl control, unsigned int threads)
+    {
+        de::Rastrigin cost(10);
+
+        de::DifferentialEvolution optimizer(cost, 50, 3);
+        optimizer.SetNumberOfThreads(threads);
+        optimizer.SetStrategy(mutation, de::CrossoverStrategy::Binomial);
+        optimizer.SetParameterControl(control);
+        optimizer.InitPopulation();
+
+        const unsigned long long before = g_allocations.load();
+        for (int i = 0; i < 20; i++)
+        {
+            optimizer.SelectionAndCorssing();
+        }
+        DE_CHECK_EQUAL(g_allocations.load() - before, 0ull);
+    }
+}
+
+int main()
+{
+    for (unsigned int threads : { 1u, 4u })
+    {
+        TestGenerations(de::MutationStrategy::Rand1, de::ParameterControl::Fixed, threads);
+        TestGenerations(de::MutationStrategy::CurrentToPBest1, de::ParameterControl::SHADE, threads);
+        TestGenerations(de::MutationStrategy::Best2, de::ParameterControl::JDE, threads);
+    }
+
+    return de::test::Result();
+}
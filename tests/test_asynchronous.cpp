@@ -0,0 +1,58 @@
+/**
+ * \file test_asynchronous.cpp
+ * \author Milos Stojanovic Stojke (milsto)
+ *
+ * Asynchronous steady-state optimization evaluates exactly the requested number of trials and
+ * never replaces an agent with a worse one.
+ */
+
+#include <vector>
+
+#include "Check.h"
+#include "de/TestFunctions.h"
+
+namespace
+{
+    void TestAsynchronousSteps(de::MutationStrategy mutation, unsigned int threads)
+    {
+        de::Rastrigin cost(10);
+
+        de::DifferentialEvolution optimizer(cost, 50, 7);
+        optimizer.SetNumberOfThreads(threads);
+        optimizer.SetStrategy(mutation, de::CrossoverStrategy::Binomial);
+        optimizer.InitPopulation();
+        DE_CHECK_EQUAL(optimizer.GetNumberOfEvaluations(), 50ull);
+
+        std::vector<double> initial(optimizer.GetPopulationSize());
+        for (unsigned int x = 0; x < optimizer.GetPopulationSize(); x++)
+        {
+            initial[x] = optimizer.GetAgentCost(x);
+        }
+        const double initialBest = optimizer.GetBestCost();
+
+        optimizer.AsynchronousSteps(5000);
+
+        DE_CHECK_EQUAL(optimizer.GetNumberOfEvaluations(), 50ull + 5000ull);
+        for (unsigned int x = 0; x < optimizer.GetPopulationSize(); x++)
+        {
+            DE_CHECK(optimizer.GetAgentCost(x) <= initial[x]);
+        }
+        DE_CHECK(optimizer.GetBestCost() < initialBest);
+
+        for (unsigned int x = 0; x < optimizer.GetPopulationSize(); x++)
+        {
+            DE_CHECK(optimizer.GetBestCost() <= optimizer.GetAgentCost(x));
+        }
+    }
+}
+
+int main()
+{
+    for (unsigned int threads : { 1u, 4u })
+    {
+        TestAsynchronousSteps(de::MutationStrategy::Rand1, threads);
+        TestAsynchronousSteps(de::MutationStrategy::CurrentToPBest1, threads);
+    }
+
+    return de::test::Result();
+}
@@ -0,0 +1,124 @@
+/**
+ * \file test_bound_handling.cpp
+ * \author Milos Stojanovic Stojke (milsto)
+ *
+ * Bound handling keeps agents inside the bounds and fixed parameters at their value.
+ */
+
+#include <cmath>
+#include <vector>
+
+#include "Check.h"
+#include "de/TestFunctions.h"
+
+namespace
+{
+    /**
+     * Rastrigin function whose first parameter is fixed by equal bounds, recording whether it was
+     * evaluated at a point that is not finite.
+     */
+    class FixedParameterRastrigin : public de::Rastrigin
+    {
+    public:
+        explicit FixedParameterRastrigin(unsigned int dims) :
+            de::Rastrigin(dims),
+            m_nonFinite(false)
+        {
+
+        }
+
+        double EvaluateCost(const double* inputs, std::size_t size) const override
+        {
+            for (std::size_t i = 0; i < size; i++)
+            {
+                m_nonFinite = m_nonFinite || !std::isfinite(inputs[i]);
+            }
+            return de::Rastrigin::EvaluateCost(inputs, size);
+        }
+
+        using de::Rastrigin::EvaluateCost;
+
+        bool NonFinite() const
+        {
+            return m_nonFinite;
+        }
+
+        std::vector<Constraints> GetConstraints() const override
+        {
+            std::vector<Constraints> constraints = de::Rastrigin::GetConstraints();
+            constraints[0] = Constraints(1.0, 1.0, true);
+            return constraints;
+        }
+
+    private:
+        mutable bool m_nonFinite;
+    };
+
+    void TestBoundHandling(de::BoundHandling handling)
+    {
+        // Large F sends many trials out of the bounds
+        de::Rastrigin cost(10);
+        de::DifferentialEvolution optimizer(cost, 30, 5);
+        optimizer.SetBoundHandling(handling);
+        optimizer.SetF(1.5);
+        optimizer.Optimize(200, false);
+
+        bool inside = true;
+        for (unsigned int x = 0; x < optimizer.GetPopulationSize(); x++)
+        {
+            for (double value : optimizer.GetAgent(x))
+            {
+                inside = inside && value >= -5.12 && value <= 5.12;
+            }
+        }
+        DE_CHECK(inside);
+
+        const de::DifferentialEvolution::BoundCounters counters = optimizer.GetBoundCounters();
+        if (handling == de::BoundHandling::Reject)
+        {
+            DE_CHECK(counters.rejections > 0);
+        }
+        else
+        {
+            DE_CHECK(counters.repairs > 0);
+            DE_CHECK_EQUAL(counters.rejections, 0ull);
+        }
+    }
+
+    void TestFixedParameter(de::BoundHandling handling)
+    {
+        FixedParameterRastrigin cost(4);
+        de::DifferentialEvolution optimizer(cost, 20, 3);
+        optimizer.SetBoundHandling(handling);
+        optimizer.InitPopulation();
+
+        // Agents off the fixed value send trials out of the zero width range
+        std::vector<double> agent = optimizer.GetBestAgent();
+        for (unsigned int x = 0; x < 5; x++)
+        {
+            agent[0] = 2.0 + x;
+            optimizer.ReplaceAgent(x, agent.data(), cost.EvaluateCost(agent.data(), agent.size()));
+        }
+        for (int i = 0; i < 20; i++)
+        {
+            optimizer.SelectionAndCorssing();
+        }
+
+        DE_CHECK(!cost.NonFinite());
+        DE_CHECK_EQUAL(optimizer.GetBestAgent()[0], 1.0);
+    }
+}
+
+int main()
+{
+    for (de::BoundHandling handling : { de::BoundHandling::Reject, de::BoundHandling::Clamp, de::BoundHandling::Reflect,
+                                        de::BoundHandling::BounceBack, de::BoundHandling::Midpoint,
+                                        de::BoundHandling::RandomReinit, de::BoundHandling::Wrap })
+    {
+        TestBoundHandling(handling);
+    }
+    TestFixedParameter(de::BoundHandling::Clamp);
+    TestFixedParameter(de::BoundHandling::Wrap);
+
+    return de::test::Result();
+}
@@ -0,0 +1,122 @@
+/**
+ * \file test_cache.cpp
+ * \author Milos Stojanovic Stojke (milsto)
+ *
+ * Cached evaluations, also of constraints, do not change results.
+ */
+
+#include <atomic>
+
+#include "Check.h"
+#include "de/EvaluationCache.h"
+#include "de/TestFunctions.h"
+
+namespace
+{
+    /**
+     * Cost function counting its evaluations.
+     */
+    class CountingRastrigin : public de::Rastrigin
+    {
+    public:
+        explicit CountingRastrigin(unsigned int dims) :
+            de::Rastrigin(dims),
+            m_evaluations(0)
+        {
+
+        }
+
+        double EvaluateCost(const double* inputs, std::size_t size) const override
+        {
+            m_evaluations++;
+            return de::Rastrigin::EvaluateCost(inputs, size);
+        }
+
+        using de::Rastrigin::EvaluateCost;
+
+        unsigned long long Evaluations() const
+        {
+            return m_evaluations;
+        }
+
+    private:
+        mutable std::atomic<unsigned long long> m_evaluations;
+    };
+
+    void TestCache(unsigned int threads)
+    {
+        de::Rastrigin cost(4);
+
+        de::DifferentialEvolution reference(cost, 40, 3, false);
+        reference.SetNumberOfThreads(threads);
+        reference.Optimize(1000, false);
+
+        // Small cache so entries are evicted
+        CountingRastrigin counted(4);
+        de::CachedOptimizable cached(counted, 1024);
+        de::DifferentialEvolution optimizer(cached, 40, 3, false);
+        optimizer.SetNumberOfThreads(threads);
+        optimizer.Optimize(1000, false);
+
+        DE_CHECK(de::test::SamePopulation(reference, optimizer));
+
+        const de::CachedOptimizable::Statistics statistics = cached.GetStatistics();
+        DE_CHECK_EQUAL(statistics.hits + statistics.misses, optimizer.GetNumberOfEvaluations());
+        DE_CHECK(statistics.evictions > 0);
+        DE_CHECK(counted.Evaluations() <= statistics.misses);
+    }
+
+    void TestConstrainedCache()
+    {
+        de::G06 cost;
+
+        de::DifferentialEvolution reference(cost, 40, 11);
+        reference.Optimize(300, false);
+
+        de::CachedConstrainedOptimizable cached(cost, 1024);
+        de::DifferentialEvolution optimizer(cached, 40, 11);
+        optimizer.Optimize(300, false);
+
+        // Constraints are seen through the cache, so results do not change
+        DE_CHECK(de::test::SamePopulation(reference, optimizer));
+        DE_CHECK_EQUAL(optimizer.GetBestViolation(), reference.GetBestViolation());
+
+        const double agent[2] = { 13.0, 0.0 };
+        double first[2];
+        double second[2];
+        cached.ResetStatistics();
+        cached.EvaluateConstraints(agent, 2, first);
+        cached.EvaluateConstraints(agent, 2, second);
+        DE_CHECK_EQUAL(cached.GetConstraintStatistics().hits, 1ull);
+        DE_CHECK(first[0] == second[0] && first[1] == second[1] && first[0] > 0.0);
+    }
+
+    void TestCacheQuantum()
+    {
+        CountingRastrigin counted(2);
+        de::CachedOptimizable cached(counted, 64, 0.5);
+
+        const double a[2] = { 1.1, 2.0 };
+        const double b[2] = { 1.2, 2.0 };
+        const double c[2] = { 1.4, 2.0 };
+        const double costA = cached.EvaluateCost(a, 2);
+        DE_CHECK_EQUAL(cached.EvaluateCost(b, 2), costA);
+        DE_CHECK_EQUAL(counted.Evaluations(), 1ull);
+        DE_CHECK(cached.EvaluateCost(c, 2) != costA);
+        DE_CHECK_EQUAL(counted.Evaluations(), 2ull);
+
+        cached.Clear();
+        cached.EvaluateCost(a, 2);
+        DE_CHECK_EQUAL(counted.Evaluations(), 3ull);
+    }
+}
+
+int main()
+{
+    TestCache(1);
+    TestCache(4);
+    TestCacheQuantum();
+    TestConstrainedCache();
+
+    return de::test::Result();
+}
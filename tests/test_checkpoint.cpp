@@ -0,0 +1,148 @@
+/**
+ * \file test_checkpoint.cpp
+ * \author Milos Stojanovic Stojke (milsto)
+ *
+ * Restored states continue bit-identically and invalid states are rejected.
+ */
+
+#include <cstdio>
+#include <vector>
+
+#include "Check.h"
+#include "de/Surrogate.h"
+#include "de/TestFunctions.h"
+
+namespace
+{
+    void Configure(de::DifferentialEvolution& optimizer)
+    {
+        optimizer.SetParameterControl(de::ParameterControl::SHADE);
+        optimizer.SetStrategy(de::MutationStrategy::CurrentToPBest1, de::CrossoverStrategy::Binomial);
+        optimizer.SetPopulationSizeSchedule(10, 20000);
+    }
+
+    void TestInMemory(de::ParameterControl control)
+    {
+        de::Rastrigin cost(10);
+
+        de::DifferentialEvolution original(cost, 80, 7);
+        Configure(original);
+        original.SetParameterControl(control);
+        original.Optimize(60, false);
+
+        std::vector<char> state;
+        original.SaveState(state);
+
+        // Different seed, the restored random streams must replace it
+        de::DifferentialEvolution restored(cost, 80, 99);
+        Configure(restored);
+        restored.SetParameterControl(control);
+        DE_CHECK(restored.RestoreState(state.data(), state.size()));
+        DE_CHECK_EQUAL(restored.GetNumberOfGenerations(), original.GetNumberOfGenerations());
+        DE_CHECK_EQUAL(restored.GetNumberOfEvaluations(), original.GetNumberOfEvaluations());
+        DE_CHECK(de::test::SamePopulation(original, restored));
+
+        original.Continue(100, false);
+        restored.Continue(100, false);
+        DE_CHECK(de::test::SamePopulation(original, restored));
+        DE_CHECK_EQUAL(restored.GetBestCost(), original.GetBestCost());
+    }
+
+    void TestFile()
+    {
+        const char* path = "test_checkpoint.ckpt";
+        de::Rastrigin cost(6);
+
+        de::DifferentialEvolution original(cost, 40, 3);
+        Configure(original);
+        original.SetCheckpointing(path, 25);
+        original.Optimize(50, false);
+        DE_CHECK(original.FlushCheckpoints());
+
+        de::DifferentialEvolution restored(cost, 40, 3);
+        Configure(restored);
+        DE_CHECK(restored.LoadCheckpoint(path));
+        DE_CHECK(de::test::SamePopulation(original, restored));
+
+        original.Continue(50, false);
+        restored.Continue(50, false);
+        DE_CHECK(de::test::SamePopulation(original, restored));
+
+        std::remove(path);
+        DE_CHECK(!restored.LoadCheckpoint(path));
+    }
+
+    void CheckRestoredCounters(const de::IOptimizable& cost, const de::DifferentialEvolution& original)
+    {
+        std::vector<char> state;
+        original.SaveState(state);
+
+        de::DifferentialEvolution restored(cost, original.GetPopulationSize(), 1);
+        DE_CHECK(restored.RestoreState(state.data(), state.size()));
+
+        const de::DifferentialEvolution::BoundCounters counters = restored.GetBoundCounters();
+        DE_CHECK_EQUAL(restored.GetNumberOfSkippedEvaluations(), original.GetNumberOfSkippedEvaluations());
+        DE_CHECK_EQUAL(restored.GetNumberOfScreenedTrials(), original.GetNumberOfScreenedTrials());
+        DE_CHECK_EQUAL(counters.rejections, original.GetBoundCounters().rejections);
+        DE_CHECK_EQUAL(counters.repairs, original.GetBoundCounters().repairs);
+    }
+
+    void TestCounters()
+    {
+        // Skipped evaluations and bound repairs counted on several threads
+        de::G06 constrained;
+        de::DifferentialEvolution skipping(constrained, 30, 5);
+        skipping.SetNumberOfThreads(3);
+        skipping.SetBoundHandling(de::BoundHandling::Clamp);
+        skipping.Optimize(40, false);
+        DE_CHECK(skipping.GetNumberOfSkippedEvaluations() > 0);
+        DE_CHECK(skipping.GetBoundCounters().repairs > 0);
+        CheckRestoredCounters(constrained, skipping);
+
+        de::Rastrigin cost(4);
+        de::LocalRbfSurrogate surrogate(4);
+        de::DifferentialEvolution screening(cost, 30, 5);
+        screening.SetSurrogate(&surrogate, de::SurrogateScreening::TopK, 10);
+        screening.Optimize(40, false);
+        DE_CHECK(screening.GetNumberOfScreenedTrials() > 0);
+        DE_CHECK(screening.GetBoundCounters().rejections > 0);
+        CheckRestoredCounters(cost, screening);
+    }
+
+    void TestInvalid()
+    {
+        de::Rastrigin cost(6);
+        de::DifferentialEvolution original(cost, 40, 3);
+        original.Optimize(10, false);
+
+        std::vector<char> state;
+        original.SaveState(state);
+
+        de::DifferentialEvolution restored(cost, 40, 3);
+        restored.InitPopulation();
+
+        std::vector<char> corrupted = state;
+        corrupted[corrupted.size() / 2] ^= 1;
+        DE_CHECK(!restored.RestoreState(corrupted.data(), corrupted.size()));
+        DE_CHECK(!restored.RestoreState(state.data(), state.size() - 1));
+        DE_CHECK_EQUAL(restored.GetNumberOfGenerations(), 0ull);
+
+        de::Rastrigin otherCost(7);
+        de::DifferentialEvolution otherDimension(otherCost, 40, 3);
+        DE_CHECK(!otherDimension.RestoreState(state.data(), state.size()));
+
+        de::DifferentialEvolution otherPopulation(cost, 41, 3);
+        DE_CHECK(!otherPopulation.RestoreState(state.data(), state.size()));
+    }
+}
+
+int main()
+{
+    TestInMemory(de::ParameterControl::SHADE);
+    TestInMemory(de::ParameterControl::Fixed);
+    TestFile();
+    TestCounters();
+    TestInvalid();
+
+    return de::test::Result();
+}
@@ -0,0 +1,68 @@
+/**
+ * \file test_constraints.cpp
+ * \author Milos Stojanovic Stojke (milsto)
+ *
+ * General constraints with feasibility rules and epsilon constrained selection.
+ */
+
+#include <cmath>
+
+#include "Check.h"
+#include "de/TestFunctions.h"
+
+namespace
+{
+    const double g_g06Optimum = -6961.81387558015;
+
+    void TestG06(de::ConstraintHandling handling)
+    {
+        de::G06 cost;
+
+        de::DifferentialEvolution reference(cost, 40, 11);
+        reference.SetConstraintHandling(handling, 500);
+        reference.Optimize(2000, false);
+
+        DE_CHECK_EQUAL(reference.GetBestViolation(), 0.0);
+        DE_CHECK(std::abs(reference.GetBestCost() - g_g06Optimum) < 1e-3);
+
+        de::DifferentialEvolution parallel(cost, 40, 11);
+        parallel.SetNumberOfThreads(4);
+        parallel.SetConstraintHandling(handling, 500);
+        parallel.Optimize(2000, false);
+
+        DE_CHECK(de::test::SamePopulation(reference, parallel));
+    }
+
+    void TestSkippedEvaluations()
+    {
+        de::G06 cost;
+
+        de::DifferentialEvolution reference(cost, 40, 11);
+        reference.InitPopulation();
+        for (int i = 0; i < 20; i++)
+        {
+            reference.SelectionAndCorssing();
+        }
+        DE_CHECK(reference.GetNumberOfSkippedEvaluations() > 0);
+
+        // Trials cut by the budget in the last generation are not skipped for their violation
+        de::DifferentialEvolution budget(cost, 40, 11);
+        budget.SetMaxEvaluations(reference.GetNumberOfEvaluations() - 5);
+        budget.InitPopulation();
+        for (int i = 0; i < 20; i++)
+        {
+            budget.SelectionAndCorssing();
+        }
+        DE_CHECK_EQUAL(budget.GetNumberOfEvaluations(), reference.GetNumberOfEvaluations() - 5);
+        DE_CHECK(budget.GetNumberOfSkippedEvaluations() <= reference.GetNumberOfSkippedEvaluations());
+    }
+}
+
+int main()
+{
+    TestG06(de::ConstraintHandling::FeasibilityRules);
+    TestG06(de::ConstraintHandling::Epsilon);
+    TestSkippedEvaluations();
+
+    return de::test::Result();
+}
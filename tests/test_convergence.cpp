@@ -0,0 +1,131 @@
+/**
+ * \file test_convergence.cpp
+ * \author Milos Stojanovic Stojke (milsto)
+ *
+ * Convergence detectors fire on a plateau of the cost and never while the cost improves steadily.
+ */
+
+#include <atomic>
+#include <limits>
+
+#include "Check.h"
+#include "de/TestFunctions.h"
+
+namespace
+{
+    /**
+     * Constant cost, no trial ever improves the population.
+     */
+    class FlatCost : public de::Rastrigin
+    {
+    public:
+        FlatCost() :
+            de::Rastrigin(4)
+        {
+
+        }
+
+        double EvaluateCost(const double*, std::size_t) const override
+        {
+            return 1.0;
+        }
+
+        using de::Rastrigin::EvaluateCost;
+    };
+
+    /**
+     * Cost decreasing with every evaluation, each trial beats its target and the best cost improves
+     * by the same amount every generation.
+     */
+    class ImprovingCost : public de::Rastrigin
+    {
+    public:
+        ImprovingCost() :
+            de::Rastrigin(4),
+            m_evaluations(0)
+        {
+
+        }
+
+        double EvaluateCost(const double*, std::size_t) const override
+        {
+            return 1e6 - static_cast<double>(++m_evaluations);
+        }
+
+        using de::Rastrigin::EvaluateCost;
+
+    private:
+        mutable std::atomic<unsigned long long> m_evaluations;
+    };
+
+    void TestStagnation()
+    {
+        FlatCost flat;
+        de::DifferentialEvolution plateau(flat, 20, 3);
+        plateau.SetStagnationGenerations(5);
+        plateau.Optimize(100, false);
+
+        DE_CHECK(plateau.GetStopReason() == de::StopReason::Stagnation);
+        DE_CHECK_EQUAL(plateau.GetNumberOfGenerations(), 5ull);
+        DE_CHECK_EQUAL(plateau.GetGenerationsWithoutImprovement(), 5ull);
+
+        ImprovingCost improving;
+        de::DifferentialEvolution steady(improving, 20, 3);
+        steady.SetStagnationGenerations(5);
+        steady.Optimize(100, false);
+
+        DE_CHECK(steady.GetStopReason() == de::StopReason::Generations);
+        DE_CHECK_EQUAL(steady.GetNumberOfGenerations(), 100ull);
+        DE_CHECK_EQUAL(steady.GetGenerationsWithoutImprovement(), 0ull);
+    }
+
+    void TestImprovementRate()
+    {
+        FlatCost flat;
+        de::DifferentialEvolution plateau(flat, 20, 3);
+        plateau.SetImprovementRateThreshold(1e-6, 4);
+        plateau.Optimize(100, false);
+
+        // Fires as soon as the window is filled
+        DE_CHECK(plateau.GetStopReason() == de::StopReason::ImprovementRate);
+        DE_CHECK_EQUAL(plateau.GetNumberOfGenerations(), 5ull);
+        DE_CHECK_EQUAL(plateau.GetImprovementRate(), 0.0);
+
+        ImprovingCost improving;
+        de::DifferentialEvolution steady(improving, 20, 3);
+        steady.SetImprovementRateThreshold(1e-6, 4);
+        steady.Optimize(100, false);
+
+        DE_CHECK(steady.GetStopReason() == de::StopReason::Generations);
+        DE_CHECK(steady.GetImprovementRate() > 1e-6);
+    }
+
+    void TestCostSpread()
+    {
+        FlatCost flat;
+        de::DifferentialEvolution plateau(flat, 20, 3);
+        plateau.SetCostSpreadThreshold(0.0);
+        plateau.Optimize(100, false);
+
+        DE_CHECK(plateau.GetStopReason() == de::StopReason::CostSpread);
+        DE_CHECK_EQUAL(plateau.GetNumberOfGenerations(), 1ull);
+
+        // Every agent improves in each generation, so the spread stays that of a generation
+        ImprovingCost improving;
+        de::DifferentialEvolution steady(improving, 20, 3);
+        steady.SetCostSpreadThreshold(1.0);
+        steady.Optimize(100, false);
+
+        DE_CHECK(steady.GetStopReason() == de::StopReason::Generations);
+        DE_CHECK(steady.GetCostSpread() > 1.0);
+    }
+}
+
+int main()
+{
+    TestStagnation();
+    TestImprovementRate();
+    TestCostSpread();
+
+    return de::test::Result();
+}
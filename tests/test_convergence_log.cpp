@@ -0,0 +1,141 @@
+/**
+ * \file test_convergence_log.cpp
+ * \author Milos Stojanovic Stojke (milsto)
+ *
+ * The convergence log records every generation, also when restarts grow the population.
+ */
+
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include "Check.h"
+#include "de/ConvergenceLog.h"
+#include "de/TestFunctions.h"
+
+namespace
+{
+    std::vector<char> ReadFile(const char* path)
+    {
+        std::vector<char> content;
+        std::FILE* file = std::fopen(path, "rb");
+        if (file)
+        {
+            char buffer[4096];
+            std::size_t read;
+            while ((read = std::fread(buffer, 1, sizeof(buffer), file)) > 0)
+            {
+                content.insert(content.end(), buffer, buffer + read);
+            }
+            std::fclose(file);
+        }
+        return content;
+    }
+
+    /**
+     * Records the population size the log sees in every generation.
+     */
+    class PopulationSizeSink : public de::ITelemetrySink
+    {
+    public:
+        explicit PopulationSizeSink(const de::DifferentialEvolution& optimizer) :
+            m_optimizer(optimizer)
+        {
+
+        }
+
+        void OnGeneration(const de::GenerationTelemetry&) override
+        {
+            sizes.push_back(m_optimizer.GetPopulationSize());
+        }
+
+        std::vector<unsigned int> sizes;
+
+    private:
+        const de::DifferentialEvolution& m_optimizer;
+    };
+
+    void TestRestarts()
+    {
+        const char* path = "test_convergence_log.bin";
+        const unsigned int dimensions = 5;
+        de::Rastrigin cost(dimensions);
+
+        de::DifferentialEvolution optimizer(cost, 10, 3);
+        optimizer.SetRestartStrategy(de::RestartStrategy::IPOP, 80);
+        optimizer.SetStagnationGenerations(20);
+
+        // Smallest ring buffer, snapshots of the grown population wrap around it
+        PopulationSizeSink sink(optimizer);
+        const std::vector<unsigned int>& populationSizes = sink.sizes;
+        {
+            de::ConvergenceLog log(optimizer, path, de::LogFormat::Binary, 1, 1);
+            optimizer.AddTelemetrySink(&log);
+            optimizer.AddTelemetrySink(&sink);
+            optimizer.Optimize(600, false);
+
+            DE_CHECK(log.Flush());
+            DE_CHECK_EQUAL(log.GetNumberOfDroppedRecords(), 0ull);
+            optimizer.RemoveTelemetrySink(&log);
+        }
+        DE_CHECK(optimizer.GetNumberOfRestarts() >= 2);
+        DE_CHECK(optimizer.GetPopulationSize() > 10);
+
+        const std::vector<char> content = ReadFile(path);
+        std::remove(path);
+
+        std::size_t position = 16;
+        std::size_t best = 0;
+        std::size_t snapshots = 0;
+        bool consistent = content.size() >= position;
+        while (consistent && position + sizeof(de::LogRecordHeader) <= content.size())
+        {
+            de::LogRecordHeader header;
+            std::memcpy(&header, content.data() + position, sizeof(header));
+            consistent = header.size == sizeof(header) + header.count * (dimensions + 1) * sizeof(double) &&
+                position + header.size <= content.size();
+            if (header.type == de::LogRecordHeader::g_best)
+            {
+                best++;
+            }
+            else if (consistent && snapshots < populationSizes.size())
+            {
+                consistent = header.count == populationSizes[snapshots];
+                snapshots++;
+            }
+            position += header.size;
+        }
+
+        DE_CHECK(consistent);
+        DE_CHECK_EQUAL(position, content.size());
+        DE_CHECK_EQUAL(best, populationSizes.size());
+        DE_CHECK_EQUAL(snapshots, populationSizes.size());
+    }
+
+    void TestTooSmall()
+    {
+        const char* path = "test_convergence_log_small.bin";
+        de::Rastrigin cost(5);
+
+        // Log constructed before the restart strategy, grown snapshots do not fit
+        de::DifferentialEvolution optimizer(cost, 10, 3);
+        de::ConvergenceLog log(optimizer, path, de::LogFormat::Binary, 1, 1);
+        optimizer.SetRestartStrategy(de::RestartStrategy::IPOP, 80);
+        optimizer.SetStagnationGenerations(20);
+        optimizer.AddTelemetrySink(&log);
+        optimizer.Optimize(600, false);
+
+        DE_CHECK(optimizer.GetNumberOfRestarts() >= 2);
+        DE_CHECK(!log.Flush());
+        DE_CHECK(log.GetNumberOfDroppedRecords() > 0);
+        std::remove(path);
+    }
+}
+
+int main()
+{
+    TestRestarts();
+    TestTooSmall();
+
+    return de::test::Result();
+}
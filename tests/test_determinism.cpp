@@ -0,0 +1,52 @@
+/**
+ * \file test_determinism.cpp
+ * \author Milos Stojanovic Stojke (milsto)
+ *
+ * Results for a given seed do not depend on the number of threads.
+ */
+
+#include "Check.h"
+#include "de/TestFunctions.h"
+
+namespace
+{
+    void Run(de::DifferentialEvolution& optimizer, unsigned int generations)
+    {
+        optimizer.InitPopulation();
+        for (unsigned int i = 0; i < generations; i++)
+        {
+            optimizer.SelectionAndCorssing();
+        }
+    }
+
+    void TestThreads(de::MutationStrategy mutation, de::CrossoverStrategy crossover, de::ParameterControl control)
+    {
+        de::Rastrigin cost(12);
+
+        de::DifferentialEvolution reference(cost, 60, 17);
+        reference.SetParameterControl(control);
+        reference.SetStrategy(mutation, crossover);
+        Run(reference, 150);
+
+        for (unsigned int threads : { 2u, 3u, 8u })
+        {
+            de::DifferentialEvolution optimizer(cost, 60, 17);
+            optimizer.SetNumberOfThreads(threads);
+            optimizer.SetParameterControl(control);
+            optimizer.SetStrategy(mutation, crossover);
+            Run(optimizer, 150);
+
+            DE_CHECK(de::test::SamePopulation(reference, optimizer));
+            DE_CHECK_EQUAL(optimizer.GetNumberOfEvaluations(), reference.GetNumberOfEvaluations());
+        }
+    }
+}
+
+int main()
+{
+    TestThreads(de::MutationStrategy::Rand1, de::CrossoverStrategy::Binomial, de::ParameterControl::Fixed);
+    TestThreads(de::MutationStrategy::CurrentToPBest1, de::CrossoverStrategy::Binomial, de::ParameterControl::SHADE);
+    TestThreads(de::MutationStrategy::Best2, de::CrossoverStrategy::Exponential, de::ParameterControl::JDE);
+
+    return de::test::Result();
+}
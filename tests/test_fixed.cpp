@@ -0,0 +1,77 @@
+/**
+ * \file test_fixed.cpp
+ * \author Milos Stojanovic Stojke (milsto)
+ *
+ * FixedDifferentialEvolution gives the same results as DifferentialEvolution with DE/rand/1/bin.
+ */
+
+#include "Check.h"
+#include "de/FixedDifferentialEvolution.h"
+#include "de/TestFunctions.h"
+
+namespace
+{
+    template<std::size_t N>
+    class FixedRastrigin : public de::IFixedOptimizable<double, N>
+    {
+    public:
+        typedef de::IFixedOptimizable<double, N> Base;
+
+        double EvaluteCost(const typename Base::Agent& inputs) const override
+        {
+            return m_cost.EvaluateCost(inputs.data(), N);
+        }
+
+        std::array<typename Base::Constraints, N> GetConstraints() const override
+        {
+            std::array<typename Base::Constraints, N> constraints;
+            for (auto& constraint : constraints)
+            {
+                constraint = typename Base::Constraints(-5.12, 5.12, true);
+            }
+            return constraints;
+        }
+
+    private:
+        de::Rastrigin m_cost{ N };
+    };
+
+    template<std::size_t N>
+    void TestEquivalence(unsigned int populationSize, int seed, bool repaired = false)
+    {
+        FixedRastrigin<N> fixedCost;
+        de::FixedDifferentialEvolution<double, N> fixed(fixedCost, populationSize, seed);
+        fixed.Optimize(300, false);
+
+        de::Rastrigin cost(N);
+        de::DifferentialEvolution dynamic(cost, populationSize, seed);
+        dynamic.SetSimdLevel(de::SimdLevel::Scalar);
+        dynamic.Optimize(300, false);
+
+        DE_CHECK_EQUAL(fixed.GetBestCost(), dynamic.GetBestCost());
+        DE_CHECK_EQUAL(dynamic.GetBoundCounters().repairs > 0, repaired);
+
+        const auto population = fixed.GetPopulationWithCosts();
+        bool same = true;
+        for (unsigned int x = 0; x < populationSize; x++)
+        {
+            same = same && population[x].second == dynamic.GetAgentCost(x);
+            for (std::size_t i = 0; i < N; i++)
+            {
+                same = same && population[x].first[i] == dynamic.GetAgent(x)[i];
+            }
+        }
+        DE_CHECK(same);
+    }
+}
+
+int main()
+{
+    TestEquivalence<2>(20, 3);
+    TestEquivalence<5>(40, 11);
+
+    // High dimension runs out of rejections and repairs some trials
+    TestEquivalence<17>(50, 7, true);
+
+    return de::test::Result();
+}
@@ -0,0 +1,162 @@
+/**
+ * \file test_island_model.cpp
+ * \author Milos Stojanovic Stojke (milsto)
+ *
+ * Results for a given seed do not depend on the number of threads for any topology, replacing
+ * the worst agents never makes an island worse, infeasible agents do not win over feasible ones in
+ * migration and migration works with islands smaller than the migration size.
+ */
+
+#include <cmath>
+#include <vector>
+
+#include "Check.h"
+#include "de/IslandModel.h"
+#include "de/TestFunctions.h"
+
+namespace
+{
+    void Configure(de::IslandModel& model, de::MigrationTopology topology, de::ReplacementPolicy policy)
+    {
+        model.SetTopology(topology);
+        model.SetReplacementPolicy(policy);
+        model.SetMigrationInterval(5);
+        model.SetMigrationSize(3);
+    }
+
+    void TestThreads(de::MigrationTopology topology, de::ReplacementPolicy policy)
+    {
+        de::Rastrigin cost(8);
+
+        de::IslandModel reference(cost, 6, 30, 11);
+        reference.SetNumberOfThreads(1);
+        Configure(reference, topology, policy);
+        reference.Optimize(100, false);
+
+        for (unsigned int threads : { 2u, 3u, 6u })
+        {
+            de::IslandModel model(cost, 6, 30, 11);
+            model.SetNumberOfThreads(threads);
+            Configure(model, topology, policy);
+            model.Optimize(100, false);
+
+            for (unsigned int i = 0; i < model.GetNumberOfIslands(); i++)
+            {
+                DE_CHECK(de::test::SamePopulation(reference.GetIsland(i), model.GetIsland(i)));
+            }
+            DE_CHECK_EQUAL(model.GetBestCost(), reference.GetBestCost());
+        }
+    }
+
+    void TestWorstReplacement(de::MigrationTopology topology)
+    {
+        de::Rastrigin cost(8);
+
+        de::IslandModel model(cost, 6, 30, 23);
+        model.SetNumberOfThreads(3);
+        Configure(model, topology, de::ReplacementPolicy::Worst);
+        model.SetMigrationInterval(1);
+        model.InitPopulation();
+
+        // Selection keeps the better of target and trial, so any increase would come from migration
+        std::vector<double> previous;
+        for (unsigned int generation = 0; generation < 50; generation++)
+        {
+            previous.clear();
+            for (unsigned int i = 0; i < model.GetNumberOfIslands(); i++)
+            {
+                for (unsigned int x = 0; x < model.GetIsland(i).GetPopulationSize(); x++)
+                {
+                    previous.push_back(model.GetIsland(i).GetAgentCost(x));
+                }
+            }
+            const double best = model.GetBestCost();
+
+            model.Evolve(1);
+
+            std::size_t k = 0;
+            for (unsigned int i = 0; i < model.GetNumberOfIslands(); i++)
+            {
+                for (unsigned int x = 0; x < model.GetIsland(i).GetPopulationSize(); x++)
+                {
+                    DE_CHECK(model.GetIsland(i).GetAgentCost(x) <= previous[k++]);
+                }
+            }
+            DE_CHECK(model.GetBestCost() <= best);
+        }
+    }
+
+    void TestConstrainedMigration()
+    {
+        const double g06Optimum = -6961.81387558015;
+        de::G06 cost;
+
+        // Feasible agent and an infeasible one of lower cost
+        const double feasible[2] = { 15.0, 5.0 };
+        const double infeasible[2] = { 13.0, 0.0 };
+
+        de::IslandModel model(cost, 2, 10, 19);
+        model.SetNumberOfThreads(1);
+        model.SetMigrationInterval(1);
+        model.SetMigrationSize(3);
+        model.InitPopulation();
+        for (unsigned int x = 0; x < 10; x++)
+        {
+            model.GetIsland(0).ReplaceAgent(x, infeasible, cost.EvaluateCost(infeasible, 2));
+            model.GetIsland(1).ReplaceAgent(x, feasible, cost.EvaluateCost(feasible, 2));
+        }
+        DE_CHECK(model.GetIsland(0).GetBestViolation() > 0.0);
+        DE_CHECK(model.GetIsland(0).GetBestCost() < model.GetIsland(1).GetBestCost());
+        DE_CHECK_EQUAL(model.GetBestIsland(), 1u);
+
+        // The infeasible immigrants of island 0 can not replace feasible agents of island 1
+        model.Evolve(1);
+        for (unsigned int x = 0; x < 10; x++)
+        {
+            DE_CHECK_EQUAL(model.GetIsland(1).GetAgentViolation(x), 0.0);
+        }
+
+        de::IslandModel optimizer(cost, 4, 30, 19);
+        optimizer.SetNumberOfThreads(2);
+        Configure(optimizer, de::MigrationTopology::FullyConnected, de::ReplacementPolicy::Worst);
+        optimizer.Optimize(2000, false);
+        DE_CHECK_EQUAL(optimizer.GetIsland(optimizer.GetBestIsland()).GetBestViolation(), 0.0);
+        DE_CHECK(std::abs(optimizer.GetBestCost() - g06Optimum) < 1e-2);
+    }
+
+    void TestShrinkingIsland()
+    {
+        de::Rastrigin cost(6);
+
+        for (de::ReplacementPolicy policy : { de::ReplacementPolicy::Worst, de::ReplacementPolicy::Random })
+        {
+            de::IslandModel model(cost, 4, 20, 31);
+            model.SetNumberOfThreads(1);
+            model.SetTopology(de::MigrationTopology::FullyConnected);
+            model.SetReplacementPolicy(policy);
+            model.SetMigrationInterval(5);
+            model.SetMigrationSize(10);
+            model.GetIsland(0).SetPopulationSizeSchedule(5, 2000);
+            model.Optimize(200, false);
+
+            DE_CHECK_EQUAL(model.GetIsland(0).GetPopulationSize(), 5u);
+            DE_CHECK_EQUAL(model.GetIsland(1).GetPopulationSize(), 20u);
+            DE_CHECK(model.GetBestCost() <= model.GetIsland(0).GetBestCost());
+        }
+    }
+}
+
+int main()
+{
+    for (de::MigrationTopology topology : { de::MigrationTopology::Ring, de::MigrationTopology::Torus,
+                                            de::MigrationTopology::FullyConnected, de::MigrationTopology::Random })
+    {
+        TestThreads(topology, de::ReplacementPolicy::Worst);
+        TestThreads(topology, de::ReplacementPolicy::Random);
+        TestWorstReplacement(topology);
+    }
+    TestConstrainedMigration();
+    TestShrinkingIsland();
+
+    return de::test::Result();
+}
@@ -0,0 +1,116 @@
+/**
+ * \file test_island_network.cpp
+ * \author Milos Stojanovic Stojke (milsto)
+ *
+ * Migration channels deliver messages and reject oversized ones before buffering them.
+ */
+
+#include <stdexcept>
+#include <string>
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "Check.h"
+#include "de/IslandNetwork.h"
+
+namespace
+{
+    const std::uint32_t g_dimensions = 3;
+    const std::uint32_t g_migrationSize = 2;
+
+    void Fill(de::MigrationMessage& message, unsigned int count)
+    {
+        message.Reset(de::MigrationMessageType::Migrants, 0, g_dimensions, 7);
+        for (unsigned int k = 0; k < count; k++)
+        {
+            const double agent[g_dimensions] = { 1.0 * k, 2.0 * k, 3.0 * k };
+            message.Append(agent, 0.5 * k, 0.25 * k);
+        }
+    }
+
+    bool Delivered(const de::MigrationMessage& message)
+    {
+        double agent[g_dimensions];
+        message.CopyAgent(1, agent);
+        return message.Header().count == g_migrationSize && message.Cost(1) == 0.5 && message.Violation(1) == 0.25 && agent[2] == 3.0;
+    }
+
+    bool RejectsOversized(de::IMigrationChannel& channel, de::MigrationMessage& message)
+    {
+        try
+        {
+            channel.Receive(message, de::MigrationMessage::Size(g_migrationSize, g_dimensions));
+        }
+        catch (const std::length_error&)
+        {
+            return true;
+        }
+        return false;
+    }
+
+    void TestSocket()
+    {
+        int sockets[2];
+        DE_CHECK(::socketpair(AF_UNIX, SOCK_STREAM, 0, sockets) == 0);
+        de::SocketChannel island(sockets[0]);
+        de::SocketChannel coordinator(sockets[1]);
+
+        de::MigrationMessage sent;
+        de::MigrationMessage received;
+        Fill(sent, g_migrationSize);
+        island.Send(sent);
+        coordinator.Receive(received, de::MigrationMessage::Size(g_migrationSize, g_dimensions));
+        DE_CHECK(Delivered(received));
+
+        Fill(sent, g_migrationSize + 1);
+        island.Send(sent);
+        DE_CHECK(RejectsOversized(coordinator, received));
+    }
+
+    void TestForgedLength()
+    {
+        int sockets[2];
+        DE_CHECK(::socketpair(AF_UNIX, SOCK_STREAM, 0, sockets) == 0);
+        de::SocketChannel coordinator(sockets[1]);
+
+        // Length prefix of 4 GB, no message body follows
+        const std::uint32_t size = 0xfffffff0u;
+        DE_CHECK(::write(sockets[0], &size, sizeof(size)) == static_cast<ssize_t>(sizeof(size)));
+
+        de::MigrationMessage received;
+        DE_CHECK(RejectsOversized(coordinator, received));
+        ::close(sockets[0]);
+    }
+
+    void TestSharedMemory()
+    {
+        const std::string name = "/de_test_" + std::to_string(::getpid());
+        std::shared_ptr<de::SharedMemorySegment> segment =
+            de::SharedMemorySegment::Create(name, 1, de::MigrationMessage::Size(g_migrationSize, g_dimensions));
+        de::SharedMemoryChannel island(segment, 0, false);
+        de::SharedMemoryChannel coordinator(segment, 0, true);
+
+        de::MigrationMessage sent;
+        de::MigrationMessage received;
+        Fill(sent, g_migrationSize);
+        island.Send(sent);
+        coordinator.Receive(received, de::MigrationMessage::Size(g_migrationSize, g_dimensions));
+        DE_CHECK(Delivered(received));
+
+        // Size written by a faulty peer beyond the mailbox
+        de::SharedMemorySegment::Mailbox* mailbox = segment->GetMailbox(0, true);
+        mailbox->size = 1u << 30;
+        mailbox->full.store(1, std::memory_order_release);
+        DE_CHECK(RejectsOversized(coordinator, received));
+    }
+}
+
+int main()
+{
+    TestSocket();
+    TestForgedLength();
+    TestSharedMemory();
+
+    return de::test::Result();
+}
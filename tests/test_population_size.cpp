@@ -0,0 +1,100 @@
+/**
+ * \file test_population_size.cpp
+ * \author Milos Stojanovic Stojke (milsto)
+ *
+ * Population size schedules shrink the population to the scheduled size and keep the best agents.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "Check.h"
+#include "de/TestFunctions.h"
+
+namespace
+{
+    std::vector<double> SortedCosts(const de::DifferentialEvolution& optimizer)
+    {
+        std::vector<double> costs(optimizer.GetPopulationSize());
+        for (unsigned int x = 0; x < optimizer.GetPopulationSize(); x++)
+        {
+            costs[x] = optimizer.GetAgentCost(x);
+        }
+        std::sort(costs.begin(), costs.end());
+        return costs;
+    }
+
+    void TestLinearReduction()
+    {
+        de::Rastrigin cost(5);
+        de::DifferentialEvolution optimizer(cost, 100, 3);
+        optimizer.SetPopulationSizeSchedule(10, 5000);
+        optimizer.InitPopulation();
+
+        double best = optimizer.GetBestCost();
+        while (optimizer.GetNumberOfEvaluations() < 6000)
+        {
+            optimizer.SelectionAndCorssing();
+
+            const double progress = std::min(1.0, optimizer.GetNumberOfEvaluations() / 5000.0);
+            const unsigned int expected = static_cast<unsigned int>(std::lround(100.0 - 90.0 * progress));
+            DE_CHECK_EQUAL(optimizer.GetPopulationSize(), expected);
+
+            // The best agent survives every reduction
+            DE_CHECK(optimizer.GetBestCost() <= best);
+            DE_CHECK_EQUAL(optimizer.GetBestCost(), SortedCosts(optimizer)[0]);
+            best = optimizer.GetBestCost();
+        }
+        DE_CHECK_EQUAL(optimizer.GetPopulationSize(), 10u);
+    }
+
+    void TestSurvivors()
+    {
+        de::Rastrigin cost(5);
+        de::DifferentialEvolution optimizer(cost, 60, 5);
+
+        // Records the population the schedule shrinks, halving it every generation
+        std::vector<double> before;
+        optimizer.SetPopulationSizeSchedule([&](unsigned long long)
+        {
+            before = SortedCosts(optimizer);
+            return optimizer.GetPopulationSize() / 2;
+        });
+        optimizer.InitPopulation();
+
+        for (unsigned int size : { 30u, 15u, 7u, 4u, 4u })
+        {
+            optimizer.SelectionAndCorssing();
+
+            DE_CHECK_EQUAL(optimizer.GetPopulationSize(), size);
+            before.resize(size);
+            DE_CHECK(SortedCosts(optimizer) == before);
+        }
+    }
+
+    void TestStrategyMinimum()
+    {
+        // DE/best/2 needs at least five agents
+        de::Rastrigin cost(5);
+        de::DifferentialEvolution optimizer(cost, 30, 7);
+        optimizer.SetStrategy(de::MutationStrategy::Best2, de::CrossoverStrategy::Binomial);
+        optimizer.SetPopulationSizeSchedule([](unsigned long long) { return 1u; });
+        optimizer.InitPopulation();
+
+        for (int i = 0; i < 3; i++)
+        {
+            optimizer.SelectionAndCorssing();
+            DE_CHECK_EQUAL(optimizer.GetPopulationSize(), 5u);
+        }
+    }
+}
+
+int main()
+{
+    TestLinearReduction();
+    TestSurvivors();
+    TestStrategyMinimum();
+
+    return de::test::Result();
+}
@@ -0,0 +1,103 @@
+/**
+ * \file test_restarts.cpp
+ * \author Milos Stojanovic Stojke (milsto)
+ *
+ * Restarts are deterministic and restored runs restart in the same generations as the original run.
+ */
+
+#include <vector>
+
+#include "Check.h"
+#include "de/TestFunctions.h"
+
+namespace
+{
+    void Configure(de::DifferentialEvolution& optimizer)
+    {
+        optimizer.SetRestartStrategy(de::RestartStrategy::BIPOP, 160);
+        optimizer.SetImprovementRateThreshold(1e-3, 10);
+        optimizer.SetStagnationGenerations(30);
+    }
+
+    void TestThreads()
+    {
+        de::Rastrigin cost(6);
+
+        de::DifferentialEvolution reference(cost, 20, 13);
+        Configure(reference);
+        reference.Optimize(500, false);
+        DE_CHECK(reference.GetNumberOfRestarts() >= 3);
+
+        de::DifferentialEvolution parallel(cost, 20, 13);
+        parallel.SetNumberOfThreads(4);
+        Configure(parallel);
+        parallel.Optimize(500, false);
+
+        DE_CHECK_EQUAL(parallel.GetNumberOfRestarts(), reference.GetNumberOfRestarts());
+        DE_CHECK(de::test::SamePopulation(reference, parallel));
+        DE_CHECK_EQUAL(parallel.GetBestCost(), reference.GetBestCost());
+    }
+
+    void TestResume()
+    {
+        de::Rastrigin cost(6);
+
+        de::DifferentialEvolution original(cost, 20, 13);
+        Configure(original);
+        original.Optimize(105, false);
+
+        std::vector<char> state;
+        original.SaveState(state);
+
+        de::DifferentialEvolution restored(cost, 20, 99);
+        Configure(restored);
+        DE_CHECK(restored.RestoreState(state.data(), state.size()));
+        DE_CHECK_EQUAL(restored.GetNumberOfRestarts(), original.GetNumberOfRestarts());
+        DE_CHECK_EQUAL(restored.GetGenerationsWithoutImprovement(), original.GetGenerationsWithoutImprovement());
+        DE_CHECK_EQUAL(restored.GetImprovementRate(), original.GetImprovementRate());
+        DE_CHECK_EQUAL(restored.GetCostSpread(), original.GetCostSpread());
+        DE_CHECK_EQUAL(restored.GetParameterSpread(), original.GetParameterSpread());
+
+        original.Continue(400, false);
+        restored.Continue(400, false);
+        DE_CHECK(original.GetNumberOfRestarts() > 1);
+        DE_CHECK_EQUAL(restored.GetNumberOfRestarts(), original.GetNumberOfRestarts());
+        DE_CHECK_EQUAL(restored.GetNumberOfEvaluations(), original.GetNumberOfEvaluations());
+        DE_CHECK(de::test::SamePopulation(original, restored));
+        DE_CHECK_EQUAL(restored.GetBestCost(), original.GetBestCost());
+
+        // The improvement rate history has to fit the configured window
+        de::DifferentialEvolution otherWindow(cost, 20, 13);
+        Configure(otherWindow);
+        otherWindow.SetImprovementRateThreshold(1e-3, 20);
+        DE_CHECK(!otherWindow.RestoreState(state.data(), state.size()));
+    }
+
+    void TestTargetCost()
+    {
+        de::Rastrigin cost(6);
+
+        de::DifferentialEvolution optimizer(cost, 20, 13);
+        Configure(optimizer);
+        optimizer.Optimize(500, false);
+
+        // The best agent comes from an earlier run, the current population is worse
+        const double best = optimizer.GetBestCost();
+        DE_CHECK(optimizer.GetAgentCost(optimizer.GetBestAgentIndex()) > best);
+
+        const unsigned long long generations = optimizer.GetNumberOfGenerations();
+        optimizer.SetTargetCost(best);
+        optimizer.Continue(100, false);
+        DE_CHECK(optimizer.GetStopReason() == de::StopReason::TargetCost);
+        DE_CHECK_EQUAL(optimizer.GetNumberOfGenerations(), generations);
+    }
+}
+
+int main()
+{
+    TestThreads();
+    TestResume();
+    TestTargetCost();
+
+    return de::test::Result();
+}
@@ -0,0 +1,52 @@
+/**
+ * \file test_simd.cpp
+ * \author Milos Stojanovic Stojke (milsto)
+ *
+ * Results for a given seed do not depend on the SIMD level.
+ */
+
+#include "Check.h"
+#include "de/TestFunctions.h"
+
+namespace
+{
+    void Run(de::DifferentialEvolution& optimizer, unsigned int generations)
+    {
+        optimizer.InitPopulation();
+        for (unsigned int i = 0; i < generations; i++)
+        {
+            optimizer.SelectionAndCorssing();
+        }
+    }
+
+    void TestSimdLevels()
+    {
+        // Dimension not a multiple of the vector width exercises the remainder handling
+        de::Rastrigin cost(13);
+
+        for (de::SimdLevel level : { de::SimdLevel::SSE2, de::SimdLevel::AVX2, de::SimdLevel::AVX512 })
+        {
+            for (de::CrossoverStrategy crossover : { de::CrossoverStrategy::Binomial, de::CrossoverStrategy::Exponential })
+            {
+                de::DifferentialEvolution scalar(cost, 40, 5);
+                scalar.SetSimdLevel(de::SimdLevel::Scalar);
+                scalar.SetStrategy(de::MutationStrategy::Rand1, crossover);
+                Run(scalar, 200);
+
+                de::DifferentialEvolution vector(cost, 40, 5);
+                vector.SetSimdLevel(level);
+                vector.SetStrategy(de::MutationStrategy::Rand1, crossover);
+                Run(vector, 200);
+
+                DE_CHECK(de::test::SamePopulation(scalar, vector));
+            }
+        }
+    }
+}
+
+int main()
+{
+    TestSimdLevels();
+
+    return de::test::Result();
+}
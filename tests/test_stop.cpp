@@ -0,0 +1,180 @@
+/**
+ * \file test_stop.cpp
+ * \author Milos Stojanovic Stojke (milsto)
+ *
+ * Evaluation budget, deadline and stop token stop a run at the evaluation they are reached.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <limits>
+#include <thread>
+
+#include "Check.h"
+#include "de/TestFunctions.h"
+
+namespace
+{
+    /**
+     * Cost function counting its evaluations and the largest batch, optionally slow or setting a
+     * stop token at a given evaluation.
+     */
+    class StoppingRastrigin : public de::Rastrigin
+    {
+    public:
+        explicit StoppingRastrigin(unsigned int dims) :
+            de::Rastrigin(dims),
+            m_evaluations(0),
+            m_largestBatch(0),
+            m_stopAt(0),
+            m_token(nullptr),
+            m_delay(0)
+        {
+
+        }
+
+        void SetToken(std::atomic<bool>* token, unsigned long long stopAt)
+        {
+            m_token = token;
+            m_stopAt = stopAt;
+        }
+
+        void SetDelay(std::chrono::microseconds delay)
+        {
+            m_delay = delay;
+        }
+
+        void EvaluateBatch(const double* inputs, std::size_t count, std::size_t stride, double* costs) const override
+        {
+            m_largestBatch = std::max(m_largestBatch, count);
+            de::Rastrigin::EvaluateBatch(inputs, count, stride, costs);
+        }
+
+        double EvaluateCost(const double* inputs, std::size_t size) const override
+        {
+            if (m_delay.count() > 0)
+            {
+                std::this_thread::sleep_for(m_delay);
+            }
+            if (++m_evaluations == m_stopAt && m_token)
+            {
+                m_token->store(true);
+            }
+            return de::Rastrigin::EvaluateCost(inputs, size);
+        }
+
+        using de::Rastrigin::EvaluateCost;
+
+        unsigned long long Evaluations() const
+        {
+            return m_evaluations;
+        }
+
+        std::size_t LargestBatch() const
+        {
+            return m_largestBatch;
+        }
+
+    private:
+        mutable std::atomic<unsigned long long> m_evaluations;
+        mutable std::size_t m_largestBatch;
+        unsigned long long m_stopAt;
+        std::atomic<bool>* m_token;
+        std::chrono::microseconds m_delay;
+    };
+
+    void TestMaxEvaluations(unsigned int threads)
+    {
+        StoppingRastrigin cost(5);
+        de::DifferentialEvolution optimizer(cost, 40, 3, false);
+        optimizer.SetNumberOfThreads(threads);
+        optimizer.SetMaxEvaluations(40 + 10 * 40 + 7);
+        optimizer.Optimize(1000, false);
+
+        DE_CHECK(optimizer.GetStopReason() == de::StopReason::MaxEvaluations);
+        DE_CHECK_EQUAL(optimizer.GetNumberOfEvaluations(), 40ull + 10ull * 40ull + 7ull);
+        DE_CHECK_EQUAL(cost.Evaluations(), optimizer.GetNumberOfEvaluations());
+    }
+
+    void TestAsynchronousMaxEvaluations(unsigned int threads)
+    {
+        StoppingRastrigin cost(5);
+        de::DifferentialEvolution optimizer(cost, 40, 3, false);
+        optimizer.SetNumberOfThreads(threads);
+        optimizer.SetMaxEvaluations(40 + 300);
+        optimizer.InitPopulation();
+
+        // Shortened to the remaining budget
+        optimizer.AsynchronousSteps(1000);
+
+        DE_CHECK(optimizer.GetStopReason() == de::StopReason::MaxEvaluations);
+        DE_CHECK_EQUAL(optimizer.GetNumberOfEvaluations(), 40ull + 300ull);
+        DE_CHECK_EQUAL(cost.Evaluations(), optimizer.GetNumberOfEvaluations());
+
+        optimizer.AsynchronousSteps(10);
+        DE_CHECK_EQUAL(optimizer.GetNumberOfEvaluations(), 40ull + 300ull);
+    }
+
+    void TestDeadline()
+    {
+        StoppingRastrigin cost(5);
+        cost.SetDelay(std::chrono::microseconds(500));
+        de::DifferentialEvolution optimizer(cost, 40, 3, false);
+        optimizer.SetTimeLimit(std::chrono::hours(1));
+        optimizer.InitPopulation();
+
+        // A deadline in the past stops before the first generation
+        optimizer.SetDeadline(std::chrono::steady_clock::now());
+        optimizer.Continue(10, false);
+        DE_CHECK(optimizer.GetStopReason() == de::StopReason::Deadline);
+        DE_CHECK_EQUAL(optimizer.GetNumberOfEvaluations(), 40ull);
+
+        // Cut short within a generation, the cost function is always called with single agents
+        optimizer.SetTimeLimit(std::chrono::milliseconds(100));
+        optimizer.Continue(1000, false);
+        DE_CHECK(optimizer.GetStopReason() == de::StopReason::Deadline);
+        DE_CHECK(optimizer.GetNumberOfEvaluations() > 40ull);
+        DE_CHECK(optimizer.GetNumberOfEvaluations() < 40ull + 1000ull * 40ull);
+        DE_CHECK_EQUAL(cost.Evaluations(), optimizer.GetNumberOfEvaluations());
+        DE_CHECK_EQUAL(cost.LargestBatch(), std::size_t(1));
+    }
+
+    void TestStopToken(unsigned int batchSize)
+    {
+        std::atomic<bool> token(false);
+        StoppingRastrigin cost(5);
+        cost.SetToken(&token, 40 + 3 * 40 + 13);
+
+        de::DifferentialEvolution optimizer(cost, 40, 3, false);
+        optimizer.SetStopToken(&token);
+        optimizer.SetStopCheckBatchSize(batchSize);
+        optimizer.Optimize(1000, false);
+
+        // Single thread, the generation stops at the first check after the token is set
+        const unsigned long long expected = 40 + 3 * 40 + (13 + batchSize - 1) / batchSize * batchSize;
+        DE_CHECK(optimizer.GetStopReason() == de::StopReason::StopToken);
+        DE_CHECK_EQUAL(optimizer.GetNumberOfEvaluations(), expected);
+        DE_CHECK_EQUAL(cost.Evaluations(), expected);
+        DE_CHECK_EQUAL(cost.LargestBatch(), std::size_t(batchSize));
+
+        // Remaining trials of the stopped generation lose the selection
+        for (unsigned int x = 0; x < optimizer.GetPopulationSize(); x++)
+        {
+            DE_CHECK(optimizer.GetAgentCost(x) < std::numeric_limits<double>::infinity());
+        }
+    }
+}
+
+int main()
+{
+    TestMaxEvaluations(1);
+    TestMaxEvaluations(4);
+    TestAsynchronousMaxEvaluations(1);
+    TestAsynchronousMaxEvaluations(4);
+    TestDeadline();
+    TestStopToken(1);
+    TestStopToken(8);
+
+    return de::test::Result();
+}
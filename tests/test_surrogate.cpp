@@ -0,0 +1,125 @@
+/**
+ * \file test_surrogate.cpp
+ * \author Milos Stojanovic Stojke (milsto)
+ *
+ * Surrogate screening only skips trials which can not win the selection.
+ */
+
+#include <cmath>
+
+#include "Check.h"
+#include "de/Surrogate.h"
+#include "de/TestFunctions.h"
+
+namespace
+{
+    /**
+     * Surrogate predicting the exact cost.
+     */
+    class ExactSurrogate : public de::ISurrogate
+    {
+    public:
+        explicit ExactSurrogate(const de::IOptimizable& cost) :
+            m_cost(cost)
+        {
+
+        }
+
+        void Add(const double*, double) override
+        {
+
+        }
+
+        bool Predict(const double* agent, double& cost) const override
+        {
+            cost = m_cost.EvaluateCost(agent, m_cost.NumberOfParameters());
+            return true;
+        }
+
+    private:
+        const de::IOptimizable& m_cost;
+    };
+
+    void TestExactScreening()
+    {
+        de::Rastrigin cost(8);
+
+        de::DifferentialEvolution reference(cost, 40, 9);
+        reference.Optimize(200, false);
+
+        ExactSurrogate surrogate(cost);
+        de::DifferentialEvolution screened(cost, 40, 9);
+        screened.SetSurrogate(&surrogate);
+        screened.Optimize(200, false);
+
+        // Trials predicted exactly to lose the selection are the only ones skipped
+        DE_CHECK(de::test::SamePopulation(reference, screened));
+        DE_CHECK(screened.GetNumberOfScreenedTrials() > 0);
+        DE_CHECK_EQUAL(screened.GetNumberOfEvaluations() + screened.GetNumberOfScreenedTrials(), reference.GetNumberOfEvaluations());
+    }
+
+    void TestRbfSurrogate()
+    {
+        // Quadratic model problem, interpolation must be exact at archived points and close nearby
+        de::LocalRbfSurrogate surrogate(2, 0, 100);
+        double cost = 0.0;
+        const double probe[2] = { 0.05, -0.05 };
+        DE_CHECK(!surrogate.Predict(probe, cost));
+
+        for (int i = -5; i <= 5; i++)
+        {
+            for (int j = -5; j <= 5; j++)
+            {
+                const double agent[2] = { 0.1 * i, 0.1 * j };
+                surrogate.Add(agent, agent[0] * agent[0] + agent[1] * agent[1]);
+            }
+        }
+        DE_CHECK_EQUAL(surrogate.Size(), std::size_t(100));
+
+        const double archived[2] = { 0.5, 0.5 };
+        DE_CHECK(surrogate.Predict(archived, cost));
+        DE_CHECK_EQUAL(cost, 0.5);
+
+        DE_CHECK(surrogate.Predict(probe, cost));
+        DE_CHECK(std::abs(cost - 0.005) < 0.01);
+    }
+
+    void TestRbfScreening()
+    {
+        de::Rastrigin cost(6);
+        de::LocalRbfSurrogate surrogate(6);
+        de::DifferentialEvolution optimizer(cost, 30, 4);
+        optimizer.SetSurrogate(&surrogate, de::SurrogateScreening::TopK, 5);
+        optimizer.InitPopulation();
+        for (int i = 0; i < 100; i++)
+        {
+            optimizer.SelectionAndCorssing();
+        }
+
+        DE_CHECK_EQUAL(optimizer.GetNumberOfEvaluations(), 30ull + 100ull * 5ull);
+        DE_CHECK_EQUAL(optimizer.GetNumberOfScreenedTrials(), 100ull * 25ull);
+
+        // Selected trials cut by the evaluation budget are not screened out
+        de::LocalRbfSurrogate budgetSurrogate(6);
+        de::DifferentialEvolution budget(cost, 30, 4);
+        budget.SetSurrogate(&budgetSurrogate, de::SurrogateScreening::TopK, 5);
+        budget.SetMaxEvaluations(30 + 10 * 5 + 3);
+        budget.InitPopulation();
+        for (int i = 0; i < 11; i++)
+        {
+            budget.SelectionAndCorssing();
+        }
+
+        DE_CHECK_EQUAL(budget.GetNumberOfEvaluations(), 30ull + 10ull * 5ull + 3ull);
+        DE_CHECK_EQUAL(budget.GetNumberOfScreenedTrials(), 11ull * 25ull);
+    }
+}
+
+int main()
+{
+    TestExactScreening();
+    TestRbfSurrogate();
+    TestRbfScreening();
+
+    return de::test::Result();
+}
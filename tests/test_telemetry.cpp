@@ -0,0 +1,141 @@
+/**
+ * \file test_telemetry.cpp
+ * \author Milos Stojanovic Stojke (milsto)
+ *
+ * Telemetry of every generation reports the counters and statistics of the population.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "Check.h"
+#include "de/Telemetry.h"
+#include "de/TestFunctions.h"
+
+namespace
+{
+    /**
+     * Sink keeping the telemetry of all generations.
+     */
+    class RecordingSink : public de::ITelemetrySink
+    {
+    public:
+        void OnGeneration(const de::GenerationTelemetry& telemetry) override
+        {
+            records.push_back(telemetry);
+        }
+
+        std::vector<de::GenerationTelemetry> records;
+    };
+
+    /**
+     * Value following the given field name in a line of StreamTelemetrySink.
+     */
+    double Field(const std::string& line, const std::string& name)
+    {
+        std::istringstream stream(line);
+        std::string word;
+        while (stream >> word)
+        {
+            if (word == name)
+            {
+                double value = 0.0;
+                stream >> value;
+                return value;
+            }
+        }
+        de::test::Fail(__FILE__, __LINE__, name.c_str());
+        return 0.0;
+    }
+
+    bool Close(double a, double b)
+    {
+        return std::abs(a - b) <= 1e-5 * std::max(1.0, std::abs(b));
+    }
+
+    void TestRecords()
+    {
+        de::Rastrigin cost(6);
+        de::DifferentialEvolution optimizer(cost, 20, 3);
+        RecordingSink sink;
+        optimizer.AddTelemetrySink(&sink);
+        optimizer.SetF(1.5);
+        optimizer.SetBoundHandling(de::BoundHandling::Clamp);
+        optimizer.Optimize(8, false);
+
+        DE_CHECK_EQUAL(sink.records.size(), std::size_t(8));
+        double best = std::numeric_limits<double>::infinity();
+        unsigned long long repairs = 0;
+        for (std::size_t g = 0; g < sink.records.size(); g++)
+        {
+            const de::GenerationTelemetry& telemetry = sink.records[g];
+            DE_CHECK_EQUAL(telemetry.generation, g + 1);
+            DE_CHECK_EQUAL(telemetry.populationSize, 20u);
+            DE_CHECK_EQUAL(telemetry.evaluations, 20ull);
+            DE_CHECK_EQUAL(telemetry.totalEvaluations, 20ull * (g + 2));
+            DE_CHECK(telemetry.replacements <= 20u);
+            DE_CHECK_EQUAL(telemetry.rejections, 0ull);
+            DE_CHECK(telemetry.bestCost <= best);
+            DE_CHECK(telemetry.bestCost <= telemetry.meanCost && telemetry.meanCost <= telemetry.worstCost);
+            DE_CHECK(telemetry.diversity > 0.0);
+            DE_CHECK(telemetry.evaluationSeconds >= 0.0 && telemetry.overheadSeconds >= 0.0);
+            best = telemetry.bestCost;
+            repairs += telemetry.repairs;
+        }
+
+        // Per generation counters add up to the totals of the run
+        DE_CHECK_EQUAL(best, optimizer.GetBestCost());
+        DE_CHECK_EQUAL(repairs, optimizer.GetBoundCounters().repairs);
+        DE_CHECK(repairs > 0);
+    }
+
+    void TestStreamSink(unsigned int interval)
+    {
+        de::Rastrigin cost(6);
+        de::DifferentialEvolution optimizer(cost, 20, 3, false);
+        RecordingSink records;
+        std::ostringstream stream;
+        de::StreamTelemetrySink sink(stream, interval);
+        optimizer.AddTelemetrySink(&records);
+        optimizer.AddTelemetrySink(&sink);
+        optimizer.Optimize(8, false);
+
+        std::istringstream lines(stream.str());
+        std::string line;
+        std::size_t count = 0;
+        while (std::getline(lines, line))
+        {
+            const std::size_t g = count * interval + interval - 1;
+            DE_CHECK(g < records.records.size());
+            if (g >= records.records.size())
+            {
+                break;
+            }
+
+            const de::GenerationTelemetry& telemetry = records.records[g];
+            DE_CHECK_EQUAL(Field(line, "generation"), static_cast<double>(telemetry.generation));
+            DE_CHECK_EQUAL(Field(line, "evaluations"), static_cast<double>(telemetry.totalEvaluations));
+            DE_CHECK_EQUAL(Field(line, "replacements"), static_cast<double>(telemetry.replacements));
+            DE_CHECK_EQUAL(Field(line, "rejections"), static_cast<double>(telemetry.rejections));
+            DE_CHECK(Close(Field(line, "best"), telemetry.bestCost));
+            DE_CHECK(Close(Field(line, "mean"), telemetry.meanCost));
+            DE_CHECK(Close(Field(line, "worst"), telemetry.worstCost));
+            DE_CHECK(Close(Field(line, "diversity"), telemetry.diversity));
+            count++;
+        }
+        DE_CHECK_EQUAL(count, std::size_t(8 / interval));
+    }
+}
+
+int main()
+{
+    TestRecords();
+    TestStreamSink(1);
+    TestStreamSink(3);
+
+    return de::test::Result();
+}